@@ -1,6 +1,10 @@
 #include "stdafx.h"
 #include "ParseTpy.h"
 #include "TpyToEpics.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
 
 using namespace std;
 using namespace ParseUtil;
@@ -13,11 +17,90 @@ using namespace EpicsTpy;
 	Source for the main program that generates an EPICs .db file
  ************************************************************************/
 
-/** Main program
+/** Messages of a conversion. They are either printed right away, or
+	buffered and printed together, so that the messages of concurrent 
+	batch entries do not interleave.
+	@brief Message log
  ************************************************************************/
-int main(int argc, char *argv[])
+class message_log {
+public:
+	/// Constructor
+	/// @param buffer Buffer the messages until flush is called
+	explicit message_log (bool buffer = false) : buffered (buffer) {}
+
+	/// Print a message to stdout or stderr
+	/// @param fp stdout or stderr
+	/// @param format printf style format string
+	void print (FILE* fp, const char* format, ...);
+	/// Print all buffered messages in their original order
+	void flush();
+
+protected:
+	/// Messages are buffered
+	bool							buffered;
+	/// Buffered messages with their output stream
+	vector<pair<FILE*, string>>		messages;
+};
+
+/* Print a message
+   message_log::print
+ ************************************************************************/
+void message_log::print (FILE* fp, const char* format, ...)
+{
+	va_list args;
+	va_start (args, format);
+	if (!buffered) {
+		vfprintf (fp, format, args);
+		va_end (args);
+		return;
+	}
+	char buf[1024];
+	int len = vsnprintf (buf, sizeof (buf), format, args);
+	va_end (args);
+	if (len <= 0) {
+		return;
+	}
+	// join consecutive messages of the same stream
+	if (messages.empty() || (messages.back().first != fp)) {
+		messages.push_back (make_pair (fp, string()));
+	}
+	string& msg = messages.back().second;
+	if (len < (int)sizeof (buf)) {
+		msg.append (buf, len);
+		return;
+	}
+	// longer than the stack buffer: format directly into the message
+	size_t pos = msg.size();
+	msg.resize (pos + len + 1);
+	va_start (args, format);
+	vsnprintf (&msg[pos], len + 1, format, args);
+	va_end (args);
+	msg.resize (pos + len);
+}
+
+/* Print the buffered messages
+   message_log::flush
+ ************************************************************************/
+void message_log::flush()
+{
+	for (const auto& msg : messages) {
+		fputs (msg.second.c_str(), msg.first);
+	}
+	messages.clear();
+}
+
+/** Generates the output for a single input file
+	@param argc Number of arguments
+	@param argv Argument list
+	@param log Messages of the conversion
+	@param maxthreads Limit for the parse and writer threads (0 = no limit)
+	@return Exit code of the conversion
+ ************************************************************************/
+static int generate (int argc, const char* const argv[], message_log& log,
+					 int maxthreads = 0)
 {
 	tpy_file		tpyfile;
+	output_cache	outcache;
 	stringcase		inpfilename;
 	stringcase		outfilename;
 	stringcase		aliasname;
@@ -72,6 +155,53 @@ int main(int argc, char *argv[])
 	}
 	bool* argp = macros ? argp_macro : (listing ? argp_list : argp_db);
 	tpyfile.getopt (argc, argv, argp);
+	outcache.getopt (argc, argv, argp);
+	if ((maxthreads > 0) && (tpyfile.get_process_threads() > maxthreads)) {
+		tpyfile.set_process_threads (maxthreads);
+	}
+
+	// check the output cache before any output file is truncated
+	stringcase manifest;
+	if (outcache.get_use_cache() && !help &&
+		!inpfilename.empty() && !outfilename.empty()) {
+		unsigned long long tpyhash = 0;
+		if (output_cache::hash_file (inpfilename, tpyhash)) {
+			stringcase opts;
+			for (int i = 1; i < argc; ++i) {
+				stringcase arg (argv[i] ? argv[i] : "");
+				if ((arg == "-i" || arg == "/i") && i + 1 < argc) {
+					++i;
+					continue;
+				}
+				(opts += arg) += ' ';
+			}
+			outcache.set_key (tpyhash, opts, replacement_table());
+			manifest = output_cache::get_manifest (outfilename, macros);
+			if (outcache.read (manifest) && outcache.is_current()) {
+				log.print (stderr, "\nOutput to %s is unchanged (%i files)\n", 
+					outfilename.c_str(), outcache.size());
+				log.print (macros ? stdout : stderr, "\nSummary:\n");
+				if (macros) {
+					log.print (stdout, "Total number of processed records = %5d\n", 
+						outcache.get_stats (0));
+					log.print (stdout, "Total number files read           = %5d\n",  
+						outcache.get_stats (1));
+					log.print (stdout, "Total number files reused         = %5d\n",  
+						outcache.size());
+				}
+				else {
+					log.print (stderr, "Total number of processed records = %5d\n", 
+						outcache.get_stats (0));
+					log.print (stderr, "Total number of input records     = %5d\n", 
+						outcache.get_stats (1));
+					log.print (stderr, "Total number of in/out records    = %5d\n",  
+						outcache.get_stats (2));
+				}
+				return 0;
+			}
+		}
+	}
+
 	// default conversion rules
 	epics_list_processing	listproc;
 	epics_db_processing		dbproc;
@@ -79,6 +209,10 @@ int main(int argc, char *argv[])
 	if (macros) {
 		macroproc = epics_macrofiles_processing (aliasname, outfilename, false, argc, argv, argp_macro);
 		macroproc.set_indirname (inpfilename);
+		macroproc.set_writer_threads (maxthreads);
+		if (!manifest.empty()) {
+			macroproc.set_output_cache (&outcache);
+		}
 	}
 	else if (listing) {
 		listproc = epics_list_processing (outfilename, argc, argv, argp_list);
@@ -93,7 +227,7 @@ int main(int argc, char *argv[])
 	}
 	// Call help when asked, or when unprocessed options exit
 	if (help) {
-		printf ("Usage: EpicsDbGen ['options'] -i 'input' -o 'output'\n"
+		log.print (stdout, "Usage: EpicsDbGen ['options'] -i 'input' -o 'output'\n"
 			"       Generates an EPICS database from a TwinCAT tpy file.\n"
 			"       -ea exports all variables regardless of their opc setting\n"
 			"       -l[l][a|e|b] generate an [extended] [atomic|epics|burt] channel listing\n"
@@ -107,18 +241,26 @@ int main(int argc, char *argv[])
 			"       -ns ignores channels of type string\n"
 			"       -sio splits database into input only and input/ouput recrods\n"
 			"       -sn 'num' splits database into files with no more than num records\n"
+			"       -yc uses/updates a binary cache of the parsed tpy file\n"
+			"       -pt 'num' expands symbols with num threads\n"
+			"       -pp processes symbols while the input file is parsed\n"
+			"       -fi|-fx 'pattern' includes|excludes variables matching the pattern\n"
+			"       -ff 'file' reads include/exclude patterns from a file\n"
+			"       -yo reuses outputs when input, options and rules are unchanged\n"
+			"       -b 'manifest' converts all 'input' 'output' ['options'] lines of the manifest\n"
+			"       -bt 'num' converts the batch entries with num threads\n"
 			"       -i 'input' input file name (stdin when omitted)\n"
 			"       -o 'output' output database file (stdout when omitted)\n");
 		if (help == 2) return 1; 
 		else return 0;
 	}
 	if (macros && !macroproc) {
-		fprintf (stderr, "Failed to access directory %s and/or %s.\n", 
+		log.print (stderr, "Failed to access directory %s and/or %s.\n", 
 			macroproc.get_outdirname().c_str(), macroproc.get_indirname().c_str());
 		return 1;
 	}
 	if ((listing && !listproc) || (!listing && !macros && !dbproc)) {
-		fprintf (stderr, "Failed to open output %s.\n", outfilename.c_str());
+		log.print (stderr, "Failed to open output %s.\n", outfilename.c_str());
 		return 1;
 	}
 
@@ -127,17 +269,17 @@ int main(int argc, char *argv[])
 	if (!inpfilename.empty()) {
 		inpf = fopen (inpfilename.c_str(), "r");
 		if (!inpf) {
-			fprintf (stderr, "Failed to open input %s.\n", inpfilename.c_str());
+			log.print (stderr, "Failed to open input %s.\n", inpfilename.c_str());
 			return 1;
 		}
 	}
-	fprintf (stderr, "\nInput from %s\n", 
+	log.print (stderr, "\nInput from %s\n", 
 		inpf == stdin ? "stdin" : inpfilename.c_str());
 
 	// print status of output
-	fprintf (stderr, "Output to %s\n", 
+	log.print (stderr, "Output to %s\n", 
 		listproc.get_file() == stdout ? "stdout" : outfilename.c_str());
-	fprintf (stderr, "Arguments are");
+	log.print (stderr, "Arguments are");
 	// print arguments
 	for (int i = 1; i < argc; ++i) {
 		stringcase arg (argv[i] ? argv[i] : 0);
@@ -146,66 +288,265 @@ int main(int argc, char *argv[])
 				++i;
 				continue;
 		}
-		fprintf (stderr, " %s", arg.c_str());
+		log.print (stderr, " %s", arg.c_str());
 	}
-	fprintf (stderr, "\n");
+	log.print (stderr, "\n");
 
-	// Parse input
-	if (!tpyfile.parse (inpf)) {
-		fprintf (stderr, "Unable to parse %s.\n", inpfilename.c_str());
+	// Parse input, symbols are processed while parsing with -pp
+	tpy_stream stream (tpyfile);
+	if (!(inpf == stdin ? stream.start (inpf) : 
+		stream.start (inpfilename.c_str())) || !stream.wait_types()) {
+		log.print (stderr, "Unable to parse %s.\n", inpfilename.c_str());
 		return 1;
 	}
 
 	// generate macro files
 	if (macros) {
 		macroproc.set_twincat3 (tpyfile.get_project_info().get_tcat_version_major() >= 3);
-		if (!tpyfile.process_symbols (macroproc)) {
-			fprintf (stderr, "Unable to generate listing.\n");
+		if (!stream.process (macroproc)) {
+			log.print (stderr, "Unable to generate listing.\n");
 			return 1;
 		}
 		macroproc.flush();
+		if (!macroproc.wait_written()) {
+			log.print (stderr, "Unable to write macro files.\n");
+			return 1;
+		}
 	}
 	// generate listing
 	else if (listing) {
-		if (!tpyfile.process_symbols (listproc)) {
-			fprintf (stderr, "Unable to generate listing.\n");
+		if (!stream.process (listproc)) {
+			log.print (stderr, "Unable to generate listing.\n");
 			return 1;
 		}
 		listproc.flush();
 	}
 	// generating epics db
 	else {
-		if (!tpyfile.process_symbols (dbproc)) {
-			fprintf (stderr, "Unable to generate record database.\n");
+		if (!stream.process (dbproc)) {
+			log.print (stderr, "Unable to generate record database.\n");
 			return 1;
 		}
 		dbproc.flush();
 	}
+	if (!stream.finish()) {
+		log.print (stderr, "Unable to parse %s.\n", inpfilename.c_str());
+		return 1;
+	}
 
 	// write summary information
 	if (macros) {
-		fprintf (stdout, "\nSummary:\n");
-		fprintf (stdout, "Total number of processed records = %5d\n", 
+		log.print (stdout, "\nSummary:\n");
+		log.print (stdout, "Total number of processed records = %5d\n", 
 			macroproc.get_processed_total());
-		fprintf (stdout, "Total number files read           = %5d\n",  
+		log.print (stdout, "Total number files read           = %5d\n",  
 			macroproc.get_filein_total());
-		fprintf (stdout, "Total number files written        = %5d\n",  
+		log.print (stdout, "Total number files written        = %5d\n",  
 			macroproc.get_fileout_total());
+		if (!manifest.empty()) {
+			log.print (stdout, "Total number files reused         = %5d\n",  
+				macroproc.get_reused_total());
+			outcache.set_stats (macroproc.get_processed_total(), 
+				macroproc.get_filein_total(), macroproc.get_fileout_total());
+			outcache.write (manifest);
+		}
 	}
 	else {
 		split_io_support* summary= listing ? 
 			(split_io_support*)(&listproc) : (split_io_support*)(&dbproc);
-		fprintf (outfilename.empty() ? stdout : stderr, "\nSummary:\n");
-		fprintf (outfilename.empty() ? stdout : stderr, 
+		log.print (outfilename.empty() ? stdout : stderr, "\nSummary:\n");
+		log.print (outfilename.empty() ? stdout : stderr, 
 			"Total number of processed records = %5d\n", 
 			summary->get_processed_total());
-		fprintf (outfilename.empty() ? stdout : stderr, 
+		log.print (outfilename.empty() ? stdout : stderr, 
 			"Total number of input records     = %5d\n", 
 			summary->get_processed_readonly());
-		fprintf (outfilename.empty() ? stdout : stderr, 
+		log.print (outfilename.empty() ? stdout : stderr, 
 			"Total number of in/out records    = %5d\n",  
 			summary->get_processed_io());
+		// remember the outputs for the next run
+		if (!manifest.empty()) {
+			for (const auto& fname : summary->get_filenames()) {
+				outcache.add_file (fname);
+			}
+			outcache.set_stats (summary->get_processed_total(), 
+				summary->get_processed_readonly(), summary->get_processed_io());
+			outcache.write (manifest);
+		}
 	}
 
 	return 0;
 }
+
+/** Entry of a batch conversion
+ ************************************************************************/
+struct batch_entry {
+	/// Default constructor
+	batch_entry() : line (0), result (1), seconds (0.0), log (true) {}
+	/// Line number in the manifest
+	int					line;
+	/// Input file name
+	stringcase			inpfilename;
+	/// Output file name
+	stringcase			outfilename;
+	/// Arguments passed to generate
+	vector<string>		args;
+	/// Exit code of the conversion
+	int					result;
+	/// Conversion time in seconds
+	double				seconds;
+	/// Messages of the conversion, printed with the summary
+	message_log			log;
+};
+
+/** Converts all entries of a batch manifest concurrently.
+	Each non-empty line of the manifest lists an input file, an output 
+	file and optional arguments. Lines starting with a # are ignored.
+	Common arguments are applied to every entry before its own arguments.
+	The cores are split between the workers: each conversion is limited
+	to its share of parse (/pt) and output writer threads. Type names are
+	shared between the workers through the global string pool, whereas 
+	the conversion rules are set up per entry, since every entry can 
+	override them with its own arguments.
+	@param manifest Name of the manifest file
+	@param threads Number of worker threads (0 = hardware concurrency)
+	@param common Arguments common to all entries
+	@return 0 if all entries were converted successfully
+ ************************************************************************/
+static int generate_batch (const stringcase& manifest, int threads,
+						   const vector<string>& common)
+{
+	// read manifest
+	FILE* fp = fopen (manifest.c_str(), "r");
+	if (!fp) {
+		fprintf (stderr, "Failed to open batch manifest %s.\n", manifest.c_str());
+		return 1;
+	}
+	vector<batch_entry> entries;
+	char buf[4096];
+	int line = 0;
+	bool ok = true;
+	while (fgets (buf, sizeof (buf), fp)) {
+		++line;
+		vector<string> list;
+		split_string (list, string (buf), 
+			[] (char c)->bool { return isspace ((unsigned char)c) != 0; }, true);
+		if (list.empty() || list[0][0] == '#') {
+			continue;
+		}
+		if (list.size() < 2) {
+			fprintf (stderr, "Missing output in line %i of %s.\n", 
+				line, manifest.c_str());
+			ok = false;
+			continue;
+		}
+		batch_entry entry;
+		entry.line = line;
+		entry.inpfilename = list[0].c_str();
+		entry.outfilename = list[1].c_str();
+		entry.args.push_back ("EpicsDbGen");
+		entry.args.insert (entry.args.end(), common.begin(), common.end());
+		entry.args.insert (entry.args.end(), list.begin() + 2, list.end());
+		entry.args.push_back ("-i");
+		entry.args.push_back (list[0]);
+		entry.args.push_back ("-o");
+		entry.args.push_back (list[1]);
+		entries.push_back (std::move (entry));
+	}
+	fclose (fp);
+	if (!ok) {
+		return 1;
+	}
+
+	// convert entries on a pool of worker threads
+	if (threads <= 0) {
+		threads = static_cast<int>(thread::hardware_concurrency());
+	}
+	if (threads > static_cast<int>(entries.size())) {
+		threads = static_cast<int>(entries.size());
+	}
+	if (threads < 1) {
+		threads = 1;
+	}
+	int cores = static_cast<int>(thread::hardware_concurrency());
+	int share = cores / threads;
+	if (share < 1) {
+		share = 1;
+	}
+	auto start = chrono::steady_clock::now();
+	atomic<size_t> next (0);
+	auto worker = [&entries, &next, share] () {
+		for (size_t i = next++; i < entries.size(); i = next++) {
+			batch_entry& entry = entries[i];
+			vector<const char*> argv;
+			for (const auto& a : entry.args) {
+				argv.push_back (a.c_str());
+			}
+			argv.push_back (nullptr);
+			auto t0 = chrono::steady_clock::now();
+			entry.result = generate (static_cast<int>(entry.args.size()), argv.data(), 
+				entry.log, share);
+			entry.seconds = chrono::duration<double> 
+				(chrono::steady_clock::now() - t0).count();
+			if (entry.result) {
+				entry.log.print (stderr, "Failed to convert %s (line %i).\n", 
+					entry.inpfilename.c_str(), entry.line);
+			}
+		}
+	};
+	vector<thread> pool;
+	for (int i = 1; i < threads; ++i) {
+		pool.emplace_back (worker);
+	}
+	worker();
+	for (auto& t : pool) {
+		t.join();
+	}
+	double total = chrono::duration<double> 
+		(chrono::steady_clock::now() - start).count();
+
+	// write batch summary, every row is followed by the messages of its entry
+	int failed = 0;
+	fprintf (stderr, "\nBatch summary for %s:\n", manifest.c_str());
+	for (auto& entry : entries) {
+		if (entry.result) ++failed;
+		fprintf (stderr, "%-6s %8.2f s  %s -> %s\n", entry.result ? "FAILED" : "ok",
+			entry.seconds, entry.inpfilename.c_str(), entry.outfilename.c_str());
+		fflush (stderr);
+		entry.log.flush();
+		fflush (stdout);
+	}
+	fprintf (stderr, "Total number of batch entries     = %5d\n", 
+		static_cast<int>(entries.size()));
+	fprintf (stderr, "Total number of failed entries    = %5d\n", failed);
+	fprintf (stderr, "Total time with %2d threads        = %8.2f s\n", 
+		threads, total);
+	return failed ? 1 : 0;
+}
+
+/** Main program
+ ************************************************************************/
+int main(int argc, char *argv[])
+{
+	// check for batch mode
+	stringcase manifest;
+	int threads = 0;
+	vector<string> common;
+	for (int i = 1; i < argc; ++i) {
+		stringcase arg (argv[i] ? argv[i] : "");
+		if ((arg == "-b" || arg == "/b") && i + 1 < argc) {
+			manifest = argv[++i];
+		}
+		else if ((arg == "-bt" || arg == "/bt") && i + 1 < argc) {
+			threads = atoi (argv[++i]);
+		}
+		else {
+			common.push_back (argv[i] ? argv[i] : "");
+		}
+	}
+	if (!manifest.empty()) {
+		return generate_batch (manifest, threads, common);
+	}
+	message_log log;
+	return generate (argc, argv, log);
+}
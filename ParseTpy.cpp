@@ -2,6 +2,8 @@
 #include "ParseTpy.h"
 #include "ParseUtilConst.h"
 #include "ParseTpyConst.h"
+#include <windows.h>
+#include <limits.h>
 #define XML_STATIC ///< Static linking
 #include "Expat/expat.h"
 #if defined(__amigaos__) && defined(__USE_INLINE__)
@@ -48,7 +50,7 @@ public:
 		opc_parse (0), opc_cdata (0), igroup_parse (0), 
 		ioffset_parse (0), bitsize_parse (0), 
 		bitoffs_parse (0), array_parse (0), enum_parse (0), 
-		struct_parse (0), fb_parse(0),
+		struct_parse (0), fb_parse(0), stream (nullptr),
 		project_info (&p), sym_list (&s), type_list (&t) {}
 
 	/// Get symbol list
@@ -117,6 +119,8 @@ public:
 	int				bitoffs_parse;
 	/// temporary data string for parsed igroup/ioffset/bitsize/bitoffs
 	std::stringcase	data;
+	/// temporary data string for parsed type names
+	std::stringcase	type_data;
 
 	/// level indicator for array info parsing
 	int				array_parse;
@@ -138,6 +142,8 @@ public:
 	item_record		struct_element;
 	/// level indicator for function block parsing
 	int				fb_parse;
+	/// Stream receiving completed symbols (symbols are listed when null)
+	tpy_stream*		stream;
 
 protected:
 	/// pointer to symbol list
@@ -170,6 +176,7 @@ private:
 	 ioffset_parse = 0;
 	 bitsize_parse = 0;
 	 data = std::stringcase ("");
+	 type_data = std::stringcase ("");
 	 array_parse = 0;
 	 array_data = std::stringcase ("");
 	 array_bounds = dimension (0, 0);
@@ -347,6 +354,37 @@ bool compiler_info::is_tcat_Valid() const
 void type_map::insert (value_type val)
 {
 	type_multipmap::insert (val);
+	if (index_valid) {
+		index.clear();
+		index_valid = false;
+	}
+}
+
+/* type_map::index_key
+ ************************************************************************/
+unsigned long long type_map::index_key (value_type::first_type id, 
+	const std::stringcase& typn)
+{
+	// names match without namespace only if their last segments match
+	std::stringcase::size_type pos = typn.rfind ('.');
+	pos = (pos == std::stringcase::npos) ? 0 : pos + 1;
+	unsigned long long h = 0xcbf29ce484222325ULL ^ id;
+	for (const char* p = typn.c_str() + pos; *p; ++p) {
+		h = (h ^ (unsigned char)tolower ((unsigned char)*p)) * 0x100000001b3ULL;
+	}
+	return h;
+}
+
+/* type_map::build_index
+ ************************************************************************/
+void type_map::build_index()
+{
+	index.clear();
+	index.reserve (size());
+	for (const value_type& t : (const type_multipmap&)*this) {
+		index[index_key (t.first, t.second.get_name())].push_back (&t);
+	}
+	index_valid = true;
 }
 
 /** compareNamesWoNamespace
@@ -373,6 +411,19 @@ bool compareNamesWoNamespace (const std::stringcase& p1, const std::stringcase&
 const type_map::value_type::second_type* 
 type_map::find (value_type::first_type id, const std::stringcase& typn) const
 {
+	if (index_valid) {
+		type_index::const_iterator c = index.find (index_key (id, typn));
+		if (c == index.end()) {
+			return nullptr;
+		}
+		for (const value_type* t : c->second) {
+			if ((t->first == id) && 
+				compareNamesWoNamespace (t->second.get_name(), typn)) {
+				return &t->second;
+			}
+		}
+		return nullptr;
+	}
 	const_iterator t = end();
 	const_iterator i = type_multipmap::find (id);
 	while (i != end()) {
@@ -392,21 +443,18 @@ type_map::find (value_type::first_type id, const std::stringcase& typn) const
 /* tpy_file::tpy_file
  ************************************************************************/
 tpy_file::tpy_file (FILE* inp)
+	: use_cache (false)
 {
 	parse (inp);
 }
 
-/* tpy_file::parse
+/** Parses a file with the XML parser
+	@param info Parser information
+	@param inp File to parse
+	@return True if successful
  ************************************************************************/
-bool tpy_file::parse (FILE* inp)
+static bool parse_xml (parserinfo_type& info, FILE* inp)
 {
-	if (!inp) {
-		return false;
-	}
-
-	// Set up parser info
-	parserinfo_type info (project_info, sym_list, type_list);
-
 	// Initialize XML parser
 	char buf[BUFSIZ];
 	XML_Parser parser = XML_ParserCreate (NULL);
@@ -425,26 +473,24 @@ bool tpy_file::parse (FILE* inp)
 				"%s at line %" XML_FMT_INT_MOD "u\n",
 				XML_ErrorString (XML_GetErrorCode (parser)),
 				XML_GetCurrentLineNumber (parser));
+			XML_ParserFree(parser);
 			return false;
 		}
 	} while (!done);
 
 	// Finish up
 	XML_ParserFree(parser);
-	parse_finish();
 	return true;
 }
 
-/* tpy_file::parse
+/** Parses a memory region with the XML parser
+	@param info Parser information
+	@param p Pointer to memory region
+	@param len Length of memory region
+	@return True if successful
  ************************************************************************/
-bool tpy_file::parse (const char* p, int len)
+static bool parse_xml (parserinfo_type& info, const char* p, int len)
 {
-	if (!p || (len < 0)) {
-		return false;
-	}
-	// Set up parser info
-	parserinfo_type info (project_info, sym_list, type_list);
-
 	// Initialize XML parser
 	XML_Parser parser = XML_ParserCreate (NULL);
 	XML_SetUserData (parser, &info);
@@ -458,19 +504,1199 @@ bool tpy_file::parse (const char* p, int len)
 			"%s at line %" XML_FMT_INT_MOD "u\n",
 			XML_ErrorString (XML_GetErrorCode (parser)),
 			XML_GetCurrentLineNumber (parser));
+		XML_ParserFree(parser);
 		return false;
 	}
 
 	// Finish up
 	XML_ParserFree(parser);
+	return true;
+}
+
+/* tpy_file::parse
+ ************************************************************************/
+bool tpy_file::parse (FILE* inp)
+{
+	if (!inp) {
+		return false;
+	}
+	// Set up parser info
+	parserinfo_type info (project_info, sym_list, type_list);
+	if (!parse_xml (info, inp)) {
+		return false;
+	}
+	parse_finish();
+	return true;
+}
+
+/* tpy_file::parse
+ ************************************************************************/
+bool tpy_file::parse (const char* p, int len)
+{
+	if (!p || (len < 0)) {
+		return false;
+	}
+	// Set up parser info
+	parserinfo_type info (project_info, sym_list, type_list);
+	if (!parse_xml (info, p, len)) {
+		return false;
+	}
+	parse_finish();
+	return true;
+}
+
+/************************************************************************/
+/* Binary cache
+ ************************************************************************/
+
+/// Cache file extension, appended to the tpy file name
+static const char* const tpy_cache_ext = ".cache";
+/// Cache file magic
+static const char tpy_cache_magic[8] = {'T', 'P', 'Y', 'C', 'A', 'C', 'H', 'E'};
+/// Cache format version, increment when the layout changes
+static const unsigned int tpy_cache_version = 1;
+
+/** Hashes a memory region 8 bytes at a time
+ ************************************************************************/
+static unsigned long long tpy_cache_hash (const char* p, size_t len)
+{
+	unsigned long long h = 0xcbf29ce484222325ULL ^ len;
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		unsigned long long w;
+		memcpy (&w, p + i, 8);
+		h = (h ^ w) * 0x100000001b3ULL;
+		h ^= h >> 29;
+	}
+	for (; i < len; ++i) {
+		h = (h ^ (unsigned char)p[i]) * 0x100000001b3ULL;
+	}
+	return h ^ (h >> 32);
+}
+
+/** Builds the cache key of a tpy file: version, size, time and hash
+ ************************************************************************/
+static std::string tpy_cache_key (const char* p, size_t len, 
+	unsigned long long mtime)
+{
+	unsigned long long key[4] = {tpy_cache_version, len, mtime, 
+		tpy_cache_hash (p, len)};
+	return std::string ((const char*)key, sizeof (key));
+}
+
+/** Serializes the parsed tables into a byte buffer
+	@brief Cache writer
+ ************************************************************************/
+class cache_writer
+{
+public:
+	/// Add an unsigned integer
+	void put (unsigned int v) { buf.append ((const char*)&v, sizeof (v)); }
+	/// Add an integer
+	void put (int v) { buf.append ((const char*)&v, sizeof (v)); }
+	/// Add a string
+	void put (const std::stringcase& s) {
+		put ((unsigned int)s.size()); buf.append (s.c_str(), s.size()); }
+	/// Add an OPC list
+	void put (const opc_list& opc) {
+		put ((int)opc.get_opc_state());
+		put ((unsigned int)opc.get_properties().size());
+		for (const auto& prop : opc.get_properties()) {
+			put (prop.first); put (prop.second); } }
+	/// Add a base record
+	void put (const base_record& rec) {
+		put (rec.get_name()); put (rec.get_type_name());
+		put (rec.get_type_decoration()); put ((int)rec.get_type_pointer());
+		put (rec.get_opc()); }
+	/// Add a bit location
+	void put (const bit_location& loc) {
+		put (loc.get_bit_offset()); put (loc.get_bit_size()); }
+
+	/// Buffer
+	std::string	buf;
+};
+
+/** Deserializes the parsed tables from a byte buffer
+	@brief Cache reader
+ ************************************************************************/
+class cache_reader
+{
+public:
+	/// Constructor
+	cache_reader (const char* p, size_t len) : ptr (p), end (p + len) {}
+	/// Get an unsigned integer
+	bool get (unsigned int& v) { return get_raw (&v, sizeof (v)); }
+	/// Get an integer
+	bool get (int& v) { return get_raw (&v, sizeof (v)); }
+	/// Get a string
+	bool get (std::stringcase& s) {
+		unsigned int len = 0;
+		if (!get (len) || ((size_t)(end - ptr) < len)) return false;
+		s.assign (ptr, len); ptr += len; return true; }
+	/// Get an OPC list
+	bool get (opc_list& opc) {
+		int state = 0;
+		unsigned int num = 0;
+		if (!get (state) || !get (num)) return false;
+		opc.set_opc_state ((opc_enum)state);
+		for (unsigned int i = 0; i < num; ++i) {
+			property_el prop;
+			if (!get (prop.first) || !get (prop.second)) return false;
+			opc.add (prop);
+		}
+		return true; }
+	/// Get a base record
+	bool get (base_record& rec) {
+		unsigned int decor = 0;
+		int pointer = 0;
+		std::stringcase type_n;
+		if (!get (rec.get_name()) || !get (type_n) ||
+			!get (decor) || !get (pointer) || !get (rec.get_opc())) return false;
+		rec.set_type_name (type_n);
+		rec.set_type_decoration (decor);
+		rec.set_type_pointer (pointer != 0);
+		return true; }
+	/// Get a bit location
+	bool get (bit_location& loc) {
+		int ofs = 0;
+		int size = 0;
+		if (!get (ofs) || !get (size)) return false;
+		loc.set_bit_offset (ofs); loc.set_bit_size (size); return true; }
+	/// At end of buffer
+	bool at_end() const { return ptr == end; }
+
+protected:
+	/// Get raw bytes
+	bool get_raw (void* v, size_t len) {
+		if ((size_t)(end - ptr) < len) return false;
+		memcpy (v, ptr, len); ptr += len; return true; }
+
+	/// Read position
+	const char*	ptr;
+	/// End of buffer
+	const char*	end;
+};
+
+/* tpy_file::read_cache
+ ************************************************************************/
+bool tpy_file::read_cache (const char* filename, const std::string& key)
+{
+	// Map the cache file
+	HANDLE hFile = CreateFileA (filename, GENERIC_READ, FILE_SHARE_READ, 
+		NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	HANDLE hMap = NULL;
+	const char* p = NULL;
+	const size_t head = sizeof (tpy_cache_magic) + key.size() + 
+		2 * sizeof (unsigned long long);
+	if (GetFileSizeEx (hFile, &size) && ((size_t)size.QuadPart >= head)) {
+		hMap = CreateFileMappingA (hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMap) {
+			p = (const char*)MapViewOfFile (hMap, FILE_MAP_READ, 0, 0, 0);
+		}
+	}
+
+	// Check magic, key and payload
+	bool ret = false;
+	project_record proj;
+	symbol_list syms;
+	type_map types;
+	if (p && (memcmp (p, tpy_cache_magic, sizeof (tpy_cache_magic)) == 0) &&
+		(memcmp (p + sizeof (tpy_cache_magic), key.data(), key.size()) == 0)) {
+		unsigned long long len;
+		unsigned long long hash;
+		memcpy (&len, p + head - 2 * sizeof (len), sizeof (len));
+		memcpy (&hash, p + head - sizeof (hash), sizeof (hash));
+		if ((len == (unsigned long long)size.QuadPart - head) &&
+			(hash == tpy_cache_hash (p + head, (size_t)len))) {
+			ret = true;
+			cache_reader rd (p + head, (size_t)len);
+			// project information
+			std::stringcase s;
+			int port = 0;
+			ret = ret && rd.get (s); proj.set_netid (s);
+			ret = ret && rd.get (port); proj.set_port (port);
+			ret = ret && rd.get (s); proj.set_targetname (s);
+			ret = ret && rd.get (s); proj.set_cmpl_versionstr (s);
+			ret = ret && rd.get (s); proj.set_tcat_versionstr (s);
+			ret = ret && rd.get (s); proj.set_cpu_family (s);
+			// symbols
+			unsigned int num = 0;
+			ret = ret && rd.get (num);
+			for (unsigned int i = 0; ret && (i < num); ++i) {
+				symbol_record sym;
+				int ig = 0, io = 0, bs = 0;
+				ret = rd.get (sym) && rd.get (ig) && rd.get (io) && rd.get (bs);
+				sym.set_igroup (ig);
+				sym.set_ioffset (io);
+				sym.set_bytesize (bs);
+				syms.push_back (sym);
+			}
+			// types
+			ret = ret && rd.get (num);
+			for (unsigned int i = 0; ret && (i < num); ++i) {
+				unsigned int id = 0;
+				type_record typ;
+				int desc = 0;
+				unsigned int decor = 0;
+				unsigned int n = 0;
+				ret = rd.get (id) && rd.get ((base_record&)typ) && 
+					rd.get ((bit_location&)typ) && rd.get (desc) && 
+					rd.get (decor) && rd.get (n);
+				typ.set_type_description ((type_enum)desc);
+				typ.set_name_decoration (decor);
+				for (unsigned int j = 0; ret && (j < n); ++j) {
+					dimension dim;
+					ret = rd.get (dim.first) && rd.get (dim.second);
+					typ.get_array_dimensions().push_back (dim);
+				}
+				ret = ret && rd.get (n);
+				for (unsigned int j = 0; ret && (j < n); ++j) {
+					enum_pair e;
+					ret = rd.get (e.first) && rd.get (e.second);
+					typ.get_enum_list().insert (e);
+				}
+				ret = ret && rd.get (n);
+				for (unsigned int j = 0; ret && (j < n); ++j) {
+					item_record item;
+					ret = rd.get ((base_record&)item) && rd.get ((bit_location&)item);
+					typ.get_struct_list().push_back (item);
+				}
+				if (ret) types.insert (type_map::value_type (id, typ));
+			}
+			ret = ret && rd.at_end();
+		}
+	}
+	if (p) UnmapViewOfFile (p);
+	if (hMap) CloseHandle (hMap);
+	CloseHandle (hFile);
+
+	// Take over the tables
+	if (ret) {
+		project_info = proj;
+		sym_list.swap (syms);
+		type_list = types;
+		type_list.build_index();
+		layout_list.clear();
+	}
+	return ret;
+}
+
+/* tpy_file::write_cache
+ ************************************************************************/
+bool tpy_file::write_cache (const char* filename, const std::string& key) const
+{
+	cache_writer wr;
+	// project information
+	wr.put (project_info.get_netid());
+	wr.put (project_info.get_port());
+	wr.put (project_info.get_targetname());
+	wr.put (project_info.get_cmpl_versionstr());
+	wr.put (project_info.get_tcat_versionstr());
+	wr.put (project_info.get_cpu_family());
+	// symbols
+	wr.put ((unsigned int)sym_list.size());
+	for (const symbol_record& sym : sym_list) {
+		wr.put ((const base_record&)sym);
+		wr.put (sym.get_igroup());
+		wr.put (sym.get_ioffset());
+		wr.put (sym.get_bytesize());
+	}
+	// types
+	wr.put ((unsigned int)type_list.size());
+	for (const auto& t : type_list) {
+		const type_record& typ = t.second;
+		wr.put (t.first);
+		wr.put ((const base_record&)typ);
+		wr.put ((const bit_location&)typ);
+		wr.put ((int)typ.get_type_description());
+		wr.put (typ.get_name_decoration());
+		wr.put ((unsigned int)typ.get_array_dimensions().size());
+		for (const dimension& dim : typ.get_array_dimensions()) {
+			wr.put (dim.first);
+			wr.put (dim.second);
+		}
+		wr.put ((unsigned int)typ.get_enum_list().size());
+		for (const auto& e : typ.get_enum_list()) {
+			wr.put (e.first);
+			wr.put (e.second);
+		}
+		wr.put ((unsigned int)typ.get_struct_list().size());
+		for (const item_record& item : typ.get_struct_list()) {
+			wr.put ((const base_record&)item);
+			wr.put ((const bit_location&)item);
+		}
+	}
+
+	// write header and payload
+	FILE* outf = fopen (filename, "wb");
+	if (!outf) {
+		return false;
+	}
+	unsigned long long len = wr.buf.size();
+	unsigned long long hash = tpy_cache_hash (wr.buf.data(), wr.buf.size());
+	bool ret = 
+		(fwrite (tpy_cache_magic, sizeof (tpy_cache_magic), 1, outf) == 1) &&
+		(fwrite (key.data(), key.size(), 1, outf) == 1) &&
+		(fwrite (&len, sizeof (len), 1, outf) == 1) &&
+		(fwrite (&hash, sizeof (hash), 1, outf) == 1) &&
+		(wr.buf.empty() || 
+		 (fwrite (wr.buf.data(), wr.buf.size(), 1, outf) == 1));
+	ret = (fclose (outf) == 0) && ret;
+	if (!ret) {
+		remove (filename);
+	}
+	return ret;
+}
+
+/** Read-only view of a whole file mapped into memory. The mapping is
+	released when the object goes out of scope.
+	@brief Mapped file
+ ************************************************************************/
+class mapped_file
+{
+public:
+	/// Constructor
+	explicit mapped_file (const char* filename);
+	/// Destructor
+	~mapped_file();
+
+	/// Check if the file is mapped
+	operator bool() const { return ptr != NULL; }
+	/// Get pointer to file content
+	const char* data() const { return ptr; }
+	/// Get file size
+	int size() const { return len; }
+	/// Get the cache key of the file
+	bool get_cache_key (std::string& key) const;
+
+protected:
+	/// File handle
+	HANDLE		hFile;
+	/// Mapping handle
+	HANDLE		hMap;
+	/// Pointer to file content
+	const char*	ptr;
+	/// File size
+	int			len;
+
+private:
+	/// Disable copy constructor
+	mapped_file (const mapped_file&);
+	/// Disable assignment operator
+	mapped_file& operator= (const mapped_file&);
+};
+
+/* mapped_file::mapped_file
+ ************************************************************************/
+mapped_file::mapped_file (const char* filename)
+	: hFile (INVALID_HANDLE_VALUE), hMap (NULL), ptr (NULL), len (0)
+{
+	hFile = CreateFileA (filename, GENERIC_READ, FILE_SHARE_READ, 
+		NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx (hFile, &size) || (size.QuadPart <= 0) ||
+		(size.QuadPart > INT_MAX)) {
+		return;
+	}
+	hMap = CreateFileMappingA (hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!hMap) {
+		return;
+	}
+	ptr = (const char*)MapViewOfFile (hMap, FILE_MAP_READ, 0, 0, 0);
+	if (ptr) {
+		len = (int)size.QuadPart;
+	}
+}
+
+/* mapped_file::~mapped_file
+ ************************************************************************/
+mapped_file::~mapped_file()
+{
+	if (ptr) UnmapViewOfFile (ptr);
+	if (hMap) CloseHandle (hMap);
+	if (hFile != INVALID_HANDLE_VALUE) CloseHandle (hFile);
+}
+
+/* mapped_file::get_cache_key
+ ************************************************************************/
+bool mapped_file::get_cache_key (std::string& key) const
+{
+	FILETIME mtime;
+	if (!ptr || !GetFileTime (hFile, NULL, NULL, &mtime)) {
+		return false;
+	}
+	key = tpy_cache_key (ptr, (size_t)len, 
+		((unsigned long long)mtime.dwHighDateTime << 32) | 
+		mtime.dwLowDateTime);
+	return true;
+}
+
+/************************************************************************/
+/* ADS symbol upload
+ ************************************************************************/
+
+/// Magic number of a recorded upload file
+static const char tpy_upload_magic[8] = {'A', 'D', 'S', 'U', 'P', 'L', 'D', '1'};
+/// Length of the net id field of a recorded upload file
+static const size_t tpy_upload_netid_len = 24;
+/// Length of the header of a recorded upload file
+static const size_t tpy_upload_header_len = 
+	sizeof (tpy_upload_magic) + 4 + tpy_upload_netid_len + 4 + 4;
+/// Length of the fixed part of a symbol entry
+static const size_t tpy_upload_symbol_len = 30;
+/// Length of the fixed part of a data type entry
+static const size_t tpy_upload_type_len = 42;
+
+/** Reads the little endian fields of an ADS symbol upload entry
+ ************************************************************************/
+class upload_reader
+{
+public:
+	/// Constructor
+	upload_reader (const char* p, size_t len) : ptr (p), end (p + len) {}
+
+	/// Number of bytes left
+	size_t left() const { return (size_t)(end - ptr); }
+	/// Skip bytes
+	bool skip (size_t len) {
+		if (left() < len) return false;
+		ptr += len; return true; }
+	/// Read an unsigned integer of len bytes
+	bool get (unsigned int& val, size_t len = 4) {
+		if (left() < len) return false;
+		val = 0;
+		for (size_t i = 0; i < len && i < 4; ++i) 
+			val |= (unsigned int)(unsigned char)ptr[i] << (8 * i);
+		ptr += len; return true; }
+	/// Read a signed integer of len bytes
+	bool get_signed (int& val, size_t len) {
+		unsigned int u = 0;
+		if (!get (u, len)) return false;
+		if ((len > 0) && (len < 4) && (u & (1U << (8 * len - 1)))) {
+			u |= ~0U << (8 * len);
+		}
+		val = (int)u; return true; }
+	/// Read a string of len characters followed by a terminating zero
+	bool get (std::stringcase& s, size_t len) {
+		if (left() < len + 1) return false;
+		s.assign (ptr, len);
+		ptr += len + 1; return true; }
+	/// Current position
+	const char* pos() const { return ptr; }
+
+protected:
+	/// Current position
+	const char*	ptr;
+	/// End of data
+	const char*	end;
+};
+
+/** Adds an OPC property found in an upload to an OPC list.
+	The names are the same as for the properties of a tpy file.
+ ************************************************************************/
+static void add_upload_property (opc_list& opc, std::stringcase name, 
+	const std::stringcase& value)
+{
+	trim_space (name);
+	if (name.compare (opcExport) == 0) {
+		int num = strtol (value.c_str(), NULL, 10);
+		opc.set_opc_state (num ? publish : silent);
+	}
+	else if (name.compare (0, 8, opcProp) == 0) {
+		name.erase (0, 8);
+		trim_space (name);
+		if (name.compare (0, 1, opcBracket) == 0) name.erase (0, 1);
+		int num = strtol (name.c_str(), NULL, 10);
+		if (num > 0) {
+			opc.add (property_el (num, value));
+		}
+	}
+}
+
+/** Adds the OPC properties of a TwinCAT 2 comment of the form 
+	(* ~ (OPC : 1 : text) (OPC_PROP[0005] : value : text) *)
+ ************************************************************************/
+static void add_upload_comment (opc_list& opc, const std::stringcase& comment)
+{
+	std::stringcase::size_type pos = comment.find ('~');
+	while (pos != std::stringcase::npos) {
+		std::stringcase::size_type beg = comment.find ('(', pos);
+		if (beg == std::stringcase::npos) break;
+		std::stringcase::size_type fin = comment.find (')', beg);
+		if (fin == std::stringcase::npos) break;
+		pos = fin;
+		std::stringcase::size_type col1 = comment.find (':', beg);
+		if ((col1 == std::stringcase::npos) || (col1 > fin)) continue;
+		std::stringcase::size_type col2 = comment.find (':', col1 + 1);
+		if ((col2 == std::stringcase::npos) || (col2 > fin)) col2 = fin;
+		std::stringcase value = comment.substr (col1 + 1, col2 - col1 - 1);
+		trim_space (value);
+		add_upload_property (opc, comment.substr (beg + 1, col1 - beg - 1), value);
+	}
+}
+
+/** Reads the attributes of an upload entry into an OPC list
+ ************************************************************************/
+static bool read_upload_attributes (upload_reader& r, opc_list& opc)
+{
+	unsigned int num = 0;
+	if (!r.get (num, 2)) return false;
+	for (unsigned int i = 0; i < num; ++i) {
+		unsigned int nlen = 0;
+		unsigned int vlen = 0;
+		std::stringcase name;
+		std::stringcase value;
+		if (!r.get (nlen, 1) || !r.get (vlen, 1) || 
+			!r.get (name, nlen) || !r.get (value, vlen)) {
+			return false;
+		}
+		add_upload_property (opc, name, value);
+	}
+	return true;
+}
+
+/** Data type entry of an ADS symbol upload
+ ************************************************************************/
+struct upload_type
+{
+	/// Default constructor
+	upload_type() : size (0), offs (0), flags (0) {}
+	/// Bit size
+	int get_bit_size() const { 
+		return (flags & adsTypeFlagBitValues) ? size : 8 * size; }
+	/// Bit offset
+	int get_bit_offset() const { 
+		return (flags & adsTypeFlagBitValues) ? offs : 8 * offs; }
+
+	/// Size in bytes (bits)
+	int						size;
+	/// Offset in bytes (bits) within the parent type
+	int						offs;
+	/// Flags
+	unsigned int			flags;
+	/// Name
+	std::stringcase			name;
+	/// Type name
+	std::stringcase			type;
+	/// OPC properties
+	opc_list				opc;
+	/// Array dimensions
+	dimensions				dims;
+	/// Enumerated values
+	enum_map				enums;
+	/// Sub items
+	std::list<upload_type>	items;
+};
+
+/** Reads a data type entry (recursively for sub items)
+ ************************************************************************/
+static bool read_upload_type (const char* p, size_t len, upload_type& typ)
+{
+	upload_reader r (p, len);
+	unsigned int entrylen = 0, size = 0, offs = 0;
+	unsigned int nlen = 0, tlen = 0, clen = 0, ndim = 0, nitems = 0;
+	std::stringcase comment;
+	if ((len < tpy_upload_type_len) || !r.get (entrylen) || 
+		!r.skip (12) || !r.get (size) || !r.get (offs) || !r.skip (4) || 
+		!r.get (typ.flags) || !r.get (nlen, 2) || !r.get (tlen, 2) || 
+		!r.get (clen, 2) || !r.get (ndim, 2) || !r.get (nitems, 2) ||
+		!r.get (typ.name, nlen) || !r.get (typ.type, tlen) || 
+		!r.get (comment, clen) || (size > INT_MAX / 8) || (offs > INT_MAX / 8)) {
+		return false;
+	}
+	typ.size = (int)size;
+	typ.offs = (int)offs;
+	add_upload_comment (typ.opc, comment);
+	// array info
+	for (unsigned int i = 0; i < ndim; ++i) {
+		int lbound = 0;
+		unsigned int elements = 0;
+		if (!r.get_signed (lbound, 4) || !r.get (elements)) return false;
+		typ.dims.push_back (dimension (lbound, (int)elements));
+	}
+	// sub items
+	for (unsigned int i = 0; i < nitems; ++i) {
+		unsigned int sublen = 0;
+		upload_reader s (r.pos(), r.left());
+		if (!s.get (sublen) || (sublen > r.left())) return false;
+		typ.items.push_back (upload_type());
+		if (!read_upload_type (r.pos(), sublen, typ.items.back())) return false;
+		r.skip (sublen);
+	}
+	// optional parts, only attributes and enum values are used
+	if ((typ.flags & adsTypeFlagTypeGuid) && !r.skip (16)) return true;
+	if ((typ.flags & adsTypeFlagCopyMask) && !r.skip (size)) return true;
+	if (typ.flags & adsTypeFlagMethodInfos) {
+		unsigned int num = 0;
+		if (!r.get (num, 2)) return true;
+		for (unsigned int i = 0; i < num; ++i) {
+			unsigned int mlen = 0;
+			upload_reader m (r.pos(), r.left());
+			if (!m.get (mlen) || (mlen < 4) || !r.skip (mlen)) return true;
+		}
+	}
+	if ((typ.flags & adsTypeFlagAttributes) && 
+		!read_upload_attributes (r, typ.opc)) {
+		return true;
+	}
+	if (typ.flags & adsTypeFlagEnumInfos) {
+		unsigned int num = 0;
+		if (!r.get (num, 2)) return true;
+		for (unsigned int i = 0; i < num; ++i) {
+			unsigned int elen = 0;
+			std::stringcase ename;
+			int val = 0;
+			if (!r.get (elen, 1) || !r.get (ename, elen) || 
+				!r.get_signed (val, size < 4 ? size : 4) ||
+				((size > 4) && !r.skip (size - 4))) {
+				return true;
+			}
+			typ.enums.insert (enum_pair (val, ename));
+		}
+	}
+	return true;
+}
+
+/** Derives an implicit array type from a name of the form 
+	ARRAY [l1..u1, l2..u2] OF type
+ ************************************************************************/
+static bool get_implicit_array (const std::stringcase& name, int bitsize,
+	type_record& rec)
+{
+	if ((name.compare (0, 5, "ARRAY") != 0) || (bitsize <= 0)) {
+		return false;
+	}
+	std::stringcase::size_type beg = name.find ('[');
+	std::stringcase::size_type fin = name.find (']');
+	std::stringcase::size_type of = name.find (" OF ", fin);
+	if ((beg == std::stringcase::npos) || (fin == std::stringcase::npos) ||
+		(of == std::stringcase::npos)) {
+		return false;
+	}
+	const char* p = name.c_str() + beg + 1;
+	const char* e = name.c_str() + fin;
+	while (p < e) {
+		char* q = nullptr;
+		int lbound = strtol (p, &q, 10);
+		while (q < e && (isspace ((unsigned char)*q) || (*q == '.'))) ++q;
+		int ubound = strtol (q, &q, 10);
+		while (q < e && (isspace ((unsigned char)*q) || (*q == ','))) ++q;
+		if ((q == p) || (ubound < lbound)) return false;
+		rec.get_array_dimensions().push_back (dimension (lbound, ubound - lbound + 1));
+		p = q;
+	}
+	std::stringcase base = name.substr (of + 4);
+	trim_space (base);
+	rec.set_name (name);
+	rec.set_type_name (base);
+	rec.set_bit_size (bitsize);
+	rec.set_type_description (arraytype);
+	return true;
+}
+
+/* tpy_file::parse_upload
+ ************************************************************************/
+bool tpy_file::parse_upload (const char* syms, size_t symlen, 
+	const char* types, size_t typelen)
+{
+	if (!syms || !types) {
+		return false;
+	}
+	// data types
+	std::map<std::stringcase, int> implicit;
+	for (size_t pos = 0; pos + 4 <= typelen; ) {
+		upload_reader r (types + pos, typelen - pos);
+		unsigned int entrylen = 0;
+		if (!r.get (entrylen) || (entrylen == 0)) break;
+		upload_type typ;
+		if ((entrylen > typelen - pos) || 
+			!read_upload_type (types + pos, entrylen, typ)) {
+			return false;
+		}
+		pos += entrylen;
+		type_record rec;
+		rec.set_name (typ.name);
+		rec.set_type_name (typ.type);
+		rec.set_bit_size (typ.get_bit_size());
+		rec.get_opc() = typ.opc;
+		if (!typ.dims.empty()) {
+			rec.set_type_description (arraytype);
+			rec.get_array_dimensions() = typ.dims;
+		}
+		else if (!typ.enums.empty()) {
+			rec.set_type_description (enumtype);
+			rec.get_enum_list() = typ.enums;
+		}
+		else if (!typ.items.empty()) {
+			rec.set_type_description (structtype);
+			for (const upload_type& sub : typ.items) {
+				item_record item;
+				item.set_name (sub.name);
+				item.set_type_name (sub.type);
+				item.set_bit_offset (sub.get_bit_offset());
+				item.set_bit_size (sub.get_bit_size());
+				item.get_opc() = sub.opc;
+				rec.get_struct_list().push_back (item);
+				implicit[sub.type] = sub.get_bit_size();
+			}
+		}
+		else if (!typ.type.empty()) {
+			rec.set_type_description (simple);
+		}
+		// discard base types and type aliases which reference themselves
+		if ((rec.get_type_description() != unknown) &&
+			((rec.get_type_description() != simple) ||
+			 (rec.get_name() != rec.get_type_name()))) {
+			type_list.insert (type_map::value_type (0, rec));
+		}
+	}
+
+	// symbols
+	for (size_t pos = 0; pos + 4 <= symlen; ) {
+		upload_reader r (syms + pos, symlen - pos);
+		unsigned int entrylen = 0, igroup = 0, ioffs = 0, size = 0, flags = 0;
+		unsigned int nlen = 0, tlen = 0, clen = 0;
+		symbol_record sym;
+		std::stringcase type_n;
+		std::stringcase comment;
+		if (!r.get (entrylen) || (entrylen == 0)) break;
+		if ((entrylen < tpy_upload_symbol_len) || (entrylen > symlen - pos)) {
+			return false;
+		}
+		r = upload_reader (syms + pos + 4, entrylen - 4);
+		pos += entrylen;
+		if (!r.get (igroup) || !r.get (ioffs) || !r.get (size) || 
+			!r.skip (4) || !r.get (flags) || !r.get (nlen, 2) || 
+			!r.get (tlen, 2) || !r.get (clen, 2) ||
+			!r.get (sym.get_name(), nlen) || 
+			!r.get (type_n, tlen) || !r.get (comment, clen) ||
+			(size > INT_MAX / 8)) {
+			return false;
+		}
+		sym.set_type_name (type_n);
+		sym.set_igroup ((int)igroup);
+		sym.set_ioffset ((int)ioffs);
+		// the size of a bit symbol is in bits, as with the tpy bit size
+		int bitsize = (flags & adsSymFlagBitValue) ? (int)size : 8 * (int)size;
+		sym.set_bytesize (bitsize / 8);
+		add_upload_comment (sym.get_opc(), comment);
+		if ((!(flags & adsSymFlagTypeGuid) || r.skip (16)) &&
+			(flags & adsSymFlagAttributes)) {
+			read_upload_attributes (r, sym.get_opc());
+		}
+		// pointers and references are readonly and not followed
+		if ((flags & adsSymFlagReference) ||
+			(sym.get_type_name().compare (0, 11, "POINTER TO ") == 0) ||
+			(sym.get_type_name().compare (0, 13, "REFERENCE TO ") == 0)) {
+			sym.set_type_pointer (true);
+			sym.get_opc().get_properties()[OPC_PROP_RIGHTS] = "1";
+		}
+		else {
+			implicit[sym.get_type_name()] = bitsize;
+		}
+		sym_list.push_back (sym);
+	}
+
+	// add array types which were not uploaded
+	type_list.build_index();
+	std::vector<type_record> arrays;
+	for (const auto& imp : implicit) {
+		type_record rec;
+		if (!type_list.find (0, imp.first) && 
+			get_implicit_array (imp.first, imp.second, rec)) {
+			arrays.push_back (rec);
+		}
+	}
+	for (const type_record& rec : arrays) {
+		type_list.insert (type_map::value_type (0, rec));
+	}
 	parse_finish();
 	return true;
 }
 
+/* tpy_file::parse_upload
+ ************************************************************************/
+bool tpy_file::parse_upload (const char* p, size_t len)
+{
+	upload_reader r (p, len);
+	unsigned int port = 0, symlen = 0, typelen = 0;
+	std::stringcase netid;
+	if (!p || (len < tpy_upload_header_len) || 
+		(memcmp (p, tpy_upload_magic, sizeof (tpy_upload_magic)) != 0) ||
+		!r.skip (sizeof (tpy_upload_magic)) || !r.get (port) ||
+		!r.get (netid, tpy_upload_netid_len - 1) || 
+		!r.get (symlen) || !r.get (typelen) || 
+		(r.left() < (size_t)symlen + typelen)) {
+		return false;
+	}
+	netid.erase (std::find (netid.begin(), netid.end(), '\0'), netid.end());
+	if (!netid.empty()) {
+		project_info.set_netid (netid);
+		project_info.set_port ((int)port);
+	}
+	return parse_upload (r.pos(), symlen, r.pos() + symlen, typelen);
+}
+
+/* tpy_file::write_upload
+ ************************************************************************/
+bool tpy_file::write_upload (const char* filename, 
+	const ads_routing_info& route, const char* syms, size_t symlen, 
+	const char* types, size_t typelen)
+{
+	if (!filename || !syms || !types || 
+		(symlen > UINT_MAX) || (typelen > UINT_MAX)) {
+		return false;
+	}
+	std::string header (tpy_upload_magic, sizeof (tpy_upload_magic));
+	auto put = [&header] (unsigned int val) {
+		for (int i = 0; i < 4; ++i) header += (char)((val >> (8 * i)) & 0xFF); };
+	put ((unsigned int)route.get_port());
+	std::string netid (route.get_netid().c_str());
+	netid.resize (tpy_upload_netid_len, '\0');
+	netid[tpy_upload_netid_len - 1] = '\0';
+	header += netid;
+	put ((unsigned int)symlen);
+	put ((unsigned int)typelen);
+	FILE* fp = fopen (filename, "wb");
+	if (!fp) {
+		return false;
+	}
+	bool ret = (fwrite (header.data(), 1, header.size(), fp) == header.size()) &&
+		(fwrite (syms, 1, symlen, fp) == symlen) &&
+		(fwrite (types, 1, typelen, fp) == typelen);
+	return (fclose (fp) == 0) && ret;
+}
+
+/** Checks if a file is a recorded upload by its extension
+ ************************************************************************/
+static bool is_upload_file (const char* filename)
+{
+	size_t len = strlen (filename);
+	size_t extlen = strlen (adsUploadExt);
+	return (len > extlen) && (_stricmp (filename + len - extlen, adsUploadExt) == 0);
+}
+
+/* tpy_file::parse_file
+ ************************************************************************/
+bool tpy_file::parse_file (const char* filename)
+{
+	if (!filename || !*filename) {
+		return false;
+	}
+	// Map the whole file into memory and parse it in a single call
+	mapped_file inp (filename);
+	if (is_upload_file (filename)) {
+		return inp && parse_upload (inp.data(), (size_t)inp.size());
+	}
+	if (inp) {
+		std::string key;
+		if (use_cache && sym_list.empty() && (type_list.size() == 0) &&
+			inp.get_cache_key (key)) {
+			// Try the cache first and rebuild it when rejected
+			std::string cachename (filename);
+			cachename += tpy_cache_ext;
+			bool ret = read_cache (cachename.c_str(), key);
+			if (!ret) {
+				ret = parse (inp.data(), inp.size());
+				if (ret) write_cache (cachename.c_str(), key);
+			}
+			return ret;
+		}
+		return parse (inp.data(), inp.size());
+	}
+
+	// Fall back to reading the file in chunks
+	FILE* fp = fopen (filename, "r");
+	if (!fp) {
+		return false;
+	}
+	bool ret = parse (fp);
+	fclose (fp);
+	return ret;
+}
+
+/* tpy_file::parse_stream
+ ************************************************************************/
+bool tpy_file::parse_stream (const char* filename, tpy_stream& stream)
+{
+	// Set up parser info, completed symbols go to the stream
+	parserinfo_type info (project_info, sym_list, type_list);
+	info.stream = &stream;
+
+	mapped_file inp (filename);
+	if (inp) {
+		return parse_xml (info, inp.data(), inp.size());
+	}
+	FILE* fp = fopen (filename, "r");
+	if (!fp) {
+		return false;
+	}
+	bool ret = parse_xml (info, fp);
+	fclose (fp);
+	return ret;
+}
+
+/* tpy_stream::tpy_stream
+ ************************************************************************/
+tpy_stream::tpy_stream (tpy_file& tpyfile, size_t maxqueue)
+	: tpy (tpyfile), max_queue (maxqueue > 0 ? maxqueue : 1), 
+	loaded (false), keep (false), types_ready (false), parse_done (false), 
+	parse_ok (false), aborted (false)
+{
+}
+
+/* tpy_stream::~tpy_stream
+ ************************************************************************/
+tpy_stream::~tpy_stream()
+{
+	if (parser.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock (mux);
+			aborted = true;
+		}
+		cond.notify_all();
+		parser.join();
+	}
+}
+
+/* tpy_stream::start
+ ************************************************************************/
+bool tpy_stream::start (const char* filename)
+{
+	if (!filename || !*filename || parser.joinable() || loaded) {
+		return false;
+	}
+	// Parse the whole file up front, unless streaming is enabled
+	if (!tpy.get_use_stream() || !tpy.sym_list.empty() || 
+		(tpy.type_list.size() != 0) || is_upload_file (filename)) {
+		loaded = true;
+		parse_ok = tpy.parse_file (filename);
+		return parse_ok;
+	}
+	// A valid cache is loaded directly, otherwise it is rebuilt at the end
+	if (tpy.get_use_cache()) {
+		mapped_file inp (filename);
+		if (inp.get_cache_key (key)) {
+			cachename = filename;
+			cachename += tpy_cache_ext;
+			if (tpy.read_cache (cachename.c_str(), key)) {
+				loaded = true;
+				parse_ok = true;
+				return true;
+			}
+			keep = true;
+		}
+	}
+	// Start parser thread
+	std::string name (filename);
+	parser = std::thread ([this, name] () {
+		bool ok = tpy.parse_stream (name.c_str(), *this);
+		types_done();
+		{
+			std::lock_guard<std::mutex> lock (mux);
+			parse_done = true;
+			parse_ok = ok;
+		}
+		cond.notify_all();
+	});
+	return true;
+}
+
+/* tpy_stream::start
+ ************************************************************************/
+bool tpy_stream::start (FILE* inp)
+{
+	if (parser.joinable() || loaded) {
+		return false;
+	}
+	loaded = true;
+	parse_ok = tpy.parse (inp);
+	return parse_ok;
+}
+
+/* tpy_stream::wait_types
+ ************************************************************************/
+bool tpy_stream::wait_types()
+{
+	if (loaded) {
+		return parse_ok;
+	}
+	if (!parser.joinable()) {
+		return false;
+	}
+	std::unique_lock<std::mutex> lock (mux);
+	cond.wait (lock, [this] () { return types_ready; });
+	return !parse_done || parse_ok;
+}
+
+/* tpy_stream::finish
+ ************************************************************************/
+bool tpy_stream::finish()
+{
+	if (loaded) {
+		return parse_ok;
+	}
+	if (!parser.joinable()) {
+		return false;
+	}
+	// Drain remaining symbols, so that the parser does not block
+	{
+		std::lock_guard<std::mutex> lock (mux);
+		aborted = true;
+		queue.clear();
+	}
+	cond.notify_all();
+	parser.join();
+	loaded = true;
+	if (!parse_ok) {
+		return false;
+	}
+	tpy.parse_finish();
+	if (keep) {
+		tpy.write_cache (cachename.c_str(), key);
+	}
+	return true;
+}
+
+/* tpy_stream::types_done
+ ************************************************************************/
+void tpy_stream::types_done()
+{
+	{
+		std::lock_guard<std::mutex> lock (mux);
+		if (types_ready) return;
+	}
+	// Types are complete, index them before the consumer starts
+	tpy.type_list.build_index();
+	tpy.layout_list.clear();
+	plcname = tpy.project_info.get();
+	{
+		std::lock_guard<std::mutex> lock (mux);
+		types_ready = true;
+	}
+	cond.notify_all();
+}
+
+/* tpy_stream::symbol_done
+ ************************************************************************/
+void tpy_stream::symbol_done (symbol_record& sym)
+{
+	if (keep) {
+		tpy.sym_list.push_back (sym);
+	}
+	std::stringcase tcname = types_ready ? plcname : tpy.project_info.get();
+	if (!tcname.empty()) {
+		sym.get_opc().add (property_el (OPC_PROP_PLCNAME, tcname));
+	}
+	std::unique_lock<std::mutex> lock (mux);
+	// the queue is only bounded once the consumer can run
+	cond.wait (lock, [this] () { 
+		return aborted || !types_ready || (queue.size() < max_queue); });
+	if (aborted) {
+		return;
+	}
+	queue.push_back (sym);
+	lock.unlock();
+	cond.notify_all();
+}
+
+/* tpy_stream::pop
+ ************************************************************************/
+bool tpy_stream::pop (symbol_record& sym)
+{
+	std::unique_lock<std::mutex> lock (mux);
+	cond.wait (lock, [this] () { return !queue.empty() || parse_done; });
+	if (queue.empty()) {
+		return false;
+	}
+	sym = std::move (queue.front());
+	queue.pop_front();
+	lock.unlock();
+	cond.notify_all();
+	return true;
+}
+
+/* tpy_file::getopt
+ ************************************************************************/
+int tpy_file::getopt (int argc, const char* const argv[], bool argp[])
+{
+	int num = tag_processing::getopt (argc, argv, argp);
+	for (int i = 1; i < argc; ++i) {
+		if (argp && argp[i]) continue;
+		if (!argv[i]) continue;
+		std::stringcase arg (argv[i]);
+		int oldnum = num;
+		// use binary cache
+		if (arg == "-yc" || arg == "/yc") {
+			set_use_cache (true);
+			++num;
+		}
+		// always parse XML
+		else if (arg == "-nc" || arg == "/nc") {
+			set_use_cache (false);
+			++num;
+		}
+		// pipelined parsing
+		else if (arg == "-pp" || arg == "/pp") {
+			set_use_stream (true);
+			++num;
+		}
+		// include/exclude patterns and pattern file
+		else if (arg == "-fi" || arg == "/fi" || arg == "-fx" || arg == "/fx" ||
+				 arg == "-ff" || arg == "/ff") {
+			if  (i + 1 < argc && argv[i+1] && 
+				 argv[i+1][0] != '/' && argv[i+1][0] != '-') {
+				if (arg[2] == 'i') {
+					filter.add_include (argv[i+1]);
+				}
+				else if (arg[2] == 'x') {
+					filter.add_exclude (argv[i+1]);
+				}
+				else if (!filter.add_file (argv[i+1])) {
+					fprintf (stderr, "Unable to read filter %s\n", argv[i+1]);
+				}
+				if (argp) argp[i] = true;
+				i += 1;
+				num += 2;
+			}
+			else {
+				++num;
+			}
+		}
+		// number of threads used to expand the symbols
+		else if (arg == "-pt" || arg == "/pt") {
+			if  (i + 1 < argc && argv[i+1] && 
+				 argv[i+1][0] != '/' && argv[i+1][0] != '-') {
+				set_process_threads (atoi (argv[i+1]));
+				if (argp) argp[i] = true;
+				i += 1;
+				num += 2;
+			}
+			else {
+				++num;
+			}
+		}
+		// no set flag to indicated a processed option
+		if (argp && (num > oldnum)) {
+			argp[i] = true;
+		}
+	}
+	return num;
+}
+
 /* tpy_file::parse_finish
  ************************************************************************/
 void tpy_file::parse_finish ()
 {
+	type_list.build_index();
+	layout_list.clear();
 	std::stringcase tcname = project_info.get();
 	if (!tcname.empty()) {
 		for (auto sym = sym_list.begin(); sym != sym_list.end(); ++sym) {
@@ -484,13 +1710,102 @@ void tpy_file::parse_finish ()
 /* XML Parsing
  ************************************************************************/
 
+/** XML map a tag name onto its identifier. The length and the first 
+	character select at most two candidates, so that a tag name is
+	compared at most twice before it is dispatched.
+ ************************************************************************/
+static xml_tag get_xml_tag (const char* name)
+{
+	if (!name) return xmlTagUnknown;
+	const size_t len = strlen (name);
+	const char c = (char)tolower ((unsigned char)name[0]);
+	const char* s1 = nullptr;
+	xml_tag t1 = xmlTagUnknown;
+	const char* s2 = nullptr;
+	xml_tag t2 = xmlTagUnknown;
+	switch (len) {
+	case 4:
+		switch (c) {
+		case 'n': s1 = xmlName; t1 = xmlTagName; break;
+		case 'p': s1 = xmlPort; t1 = xmlTagPort; break;
+		case 't': s1 = xmlType; t1 = xmlTagType; 
+			s2 = xmlEnumText; t2 = xmlTagEnumText; break;
+		case 'e': s1 = xmlEnumEnum; t1 = xmlTagEnumEnum; break;
+		}
+		break;
+	case 5:
+		switch (c) {
+		case 'v': s1 = xmlValue; t1 = xmlTagValue; break;
+		case 'n': s1 = xmlNetId; t1 = xmlTagNetId; break;
+		}
+		break;
+	case 6:
+		switch (c) {
+		case 's': s1 = xmlSymbol; t1 = xmlTagSymbol; break;
+		case 'i': s1 = xmlIGroup; t1 = xmlTagIGroup; break;
+		case 'l': s1 = xmlArrayLBound; t1 = xmlTagArrayLBound; break;
+		case 'f': s1 = xmlFbInfo; t1 = xmlTagFbInfo; break;
+		}
+		break;
+	case 7:
+		switch (c) {
+		case 'a': s1 = xmlAdsInfo; t1 = xmlTagAdsInfo; break;
+		case 's': s1 = xmlSymbols; t1 = xmlTagSymbols; 
+			s2 = xmlSubItem; t2 = xmlTagSubItem; break;
+		case 'i': s1 = xmlIOffset; t1 = xmlTagIOffset; break;
+		case 'b': s1 = xmlBitSize; t1 = xmlTagBitSize; 
+			s2 = xmlBitOffs; t2 = xmlTagBitOffs; break;
+		case 'c': s1 = xmlEnumComment; t1 = xmlTagEnumComment; break;
+		}
+		break;
+	case 8:
+		switch (c) {
+		case 'd': s1 = xmlDataType; t1 = xmlTagDataType; break;
+		case 'p': s1 = xmlProperty; t1 = xmlTagProperty; break;
+		case 'e': s1 = xmlArrayElements; t1 = xmlTagArrayElements; 
+			s2 = xmlEnumInfo; t2 = xmlTagEnumInfo; break;
+		}
+		break;
+	case 9:
+		switch (c) {
+		case 'd': s1 = xmlDataTypes; t1 = xmlTagDataTypes; break;
+		case 'c': s1 = xmlCpuFamily; t1 = xmlTagCpuFamily; break;
+		case 'a': s1 = xmlArrayInfo; t1 = xmlTagArrayInfo; break;
+		}
+		break;
+	case 10:
+		switch (c) {
+		case 'p': s1 = xmlProperties; t1 = xmlTagProperties; break;
+		case 't': s1 = xmlTargetName; t1 = xmlTagTargetName; break;
+		}
+		break;
+	case 11:
+		if (c == 'r') { s1 = xmlRoutingInfo; t1 = xmlTagRoutingInfo; }
+		break;
+	case 12:
+		if (c == 'c') { s1 = xmlCompilerInfo; t1 = xmlTagCompilerInfo; }
+		break;
+	case 14:
+		switch (c) {
+		case 'p': s1 = xmlPlcProjectInfo; t1 = xmlTagPlcProjectInfo; break;
+		case 't': s1 = xmlTwinCATVersion; t1 = xmlTagTwinCATVersion; break;
+		}
+		break;
+	case 15:
+		if (c == 'c') { s1 = xmlCompilerVersion; t1 = xmlTagCompilerVersion; }
+		break;
+	}
+	if (s1 && (_strnicmp (name, s1, len) == 0)) return t1;
+	if (s2 && (_strnicmp (name, s2, len) == 0)) return t2;
+	return xmlTagUnknown;
+}
+
 /** XML get decoration number from attribute
  ************************************************************************/
 bool get_decoration (const char **atts, unsigned int& decoration)
 {
 	for (const char** pp = atts; pp && pp[0] && pp[1]; pp += 2) {
-		std::stringcase a (pp[0]);
-		if (a.compare (xmlAttrDecoration) == 0) {
+		if (_stricmp (pp[0], xmlAttrDecoration) == 0) {
 			decoration = strtol (pp[1], NULL, 16);
 			return true;
 		}
@@ -504,8 +1819,7 @@ bool get_pointer (const char **atts)
 {
 	unsigned int num = 0;
 	for (const char** pp = atts; pp && pp[0] && pp[1]; pp += 2) {
-		std::stringcase a (pp[0]);
-		if (a.compare (xmlAttrPointer) == 0) {
+		if (_stricmp (pp[0], xmlAttrPointer) == 0) {
 			std::stringcase val (pp[1]);
 			return (val == "true") || (val == "t") || (val == "1");
 		}
@@ -523,21 +1837,21 @@ static void XMLCALL startElement (void *userData, const char *name,
 		++pinfo->ignore;
 		return;
 	}
-	std::stringcase n (name ? name : "");
+	xml_tag t = get_xml_tag (name);
 
 	// Parse PLC project information
-	if (pinfo->verytop() && (n.compare (xmlPlcProjectInfo) == 0)) {
+	if (pinfo->verytop() && (t == xmlTagPlcProjectInfo)) {
 		pinfo->projects = true;
 	}
 
 	// Parse routing information
-	else if (n.compare (xmlRoutingInfo) == 0) {
+	else if (t == xmlTagRoutingInfo) {
 		if (pinfo->top()) {
 			++pinfo->routing;
 		}
 		else ++pinfo->ignore;
 	}
-	else if (n.compare (xmlAdsInfo) == 0) {
+	else if (t == xmlTagAdsInfo) {
 		if (pinfo->routing == 1) {
 			++pinfo->routing;
 		}
@@ -545,24 +1859,24 @@ static void XMLCALL startElement (void *userData, const char *name,
 	}
 	else if (pinfo->routing >= 2) {
 		// Net Id
-		if (n.compare (xmlNetId) == 0 && (pinfo->routing == 2)) {
+		if (t == xmlTagNetId && (pinfo->routing == 2)) {
 			pinfo->data = std::stringcase ("");
 			pinfo->routing = 3;
 		}
 		// Port
-		else if (n.compare (xmlPort) == 0 && (pinfo->routing == 2)) {
+		else if (t == xmlTagPort && (pinfo->routing == 2)) {
 			pinfo->data = std::stringcase ("");
 			pinfo->routing = 4;
 		}
 		// Target name
-		else if (n.compare (xmlTargetName) == 0 && (pinfo->routing == 2)) {
+		else if (t == xmlTagTargetName && (pinfo->routing == 2)) {
 			pinfo->data = std::stringcase ("");
 			pinfo->routing = 5;
 		}
 	}
 
 	// Parse compiler information
-	else if (n.compare (xmlCompilerInfo) == 0) {
+	else if (t == xmlTagCompilerInfo) {
 		if (pinfo->top()) {
 			++pinfo->compiler;
 		}
@@ -570,30 +1884,30 @@ static void XMLCALL startElement (void *userData, const char *name,
 	}
 	else if (pinfo->compiler >= 1) {
 		// Net Id
-		if (n.compare (xmlCompilerVersion) == 0 && (pinfo->compiler == 1)) {
+		if (t == xmlTagCompilerVersion && (pinfo->compiler == 1)) {
 			pinfo->data = std::stringcase ("");
 			pinfo->compiler = 2;
 		}
 		// Port
-		else if (n.compare (xmlTwinCATVersion) == 0 && (pinfo->compiler == 1)) {
+		else if (t == xmlTagTwinCATVersion && (pinfo->compiler == 1)) {
 			pinfo->data = std::stringcase ("");
 			pinfo->compiler = 3;
 		}
 		// CPU Family
-		else if (n.compare (xmlCpuFamily) == 0 && (pinfo->compiler == 1)) {
+		else if (t == xmlTagCpuFamily && (pinfo->compiler == 1)) {
 			pinfo->data = std::stringcase ("");
 			pinfo->compiler = 4;
 		}
 	}
 
 	// Parse symbol information
-	else if (n.compare (xmlSymbols) == 0) {
+	else if (t == xmlTagSymbols) {
 		if (pinfo->top()) {
 			++pinfo->symbols;
 		}
 		else ++pinfo->ignore;
 	}
-	else if (n.compare (xmlSymbol) == 0) {
+	else if (t == xmlTagSymbol) {
 		if (pinfo->symbols == 1) {
 			++pinfo->symbols;
 			pinfo->init();
@@ -602,52 +1916,53 @@ static void XMLCALL startElement (void *userData, const char *name,
 	}
 	else if (pinfo->symbols == 2) {
 		// name of symbol
-		if (n.compare (xmlName) == 0 && !pinfo->name_parse && 
+		if (t == xmlTagName && !pinfo->name_parse && 
 			!pinfo->opc_parse) {
 				pinfo->name_parse = 2;
 		}
 		// type of symbol
-		else if (n.compare (xmlType) == 0 && !pinfo->type_parse) {
+		else if (t == xmlTagType && !pinfo->type_parse) {
 			pinfo->type_parse = 2;
+			pinfo->type_data.clear();
 			unsigned int decor = 0;
 			get_decoration (atts, decor);
 			pinfo->sym.set_type_decoration (decor);
 			pinfo->sym.set_type_pointer (get_pointer (atts));
 		}
 		// opc properties
-		else if (n.compare (xmlProperties) == 0 && !pinfo->opc_parse &&
+		else if (t == xmlTagProperties && !pinfo->opc_parse &&
 			pinfo->name_parse <= 1 && pinfo->type_parse <= 1) {
 				pinfo->opc_parse = 1;
 		}
 		// opc property
-		else if (n.compare (xmlProperty) == 0 && pinfo->opc_parse == 1) {
+		else if (t == xmlTagProperty && pinfo->opc_parse == 1) {
 			pinfo->opc_parse = 2;
 			pinfo->opc_prop = property_el ();
 		}
 		// opc property name
-		else if (n.compare (xmlName) == 0 && pinfo->opc_parse == 2) {
+		else if (t == xmlTagName && pinfo->opc_parse == 2) {
 			pinfo->opc_parse = 3;
 			pinfo->opc_data = "";
 			pinfo->opc_cdata = 1;
 		}
 		// opc property value
-		else if (n.compare (xmlValue) == 0 && pinfo->opc_parse == 2) {
+		else if (t == xmlTagValue && pinfo->opc_parse == 2) {
 			pinfo->opc_parse = 4;
 			pinfo->opc_data = "";
 			pinfo->opc_cdata = 1;
 		}
 		// igroup
-		else if (n.compare (xmlIGroup) == 0 && !pinfo->igroup_parse) {
+		else if (t == xmlTagIGroup && !pinfo->igroup_parse) {
 			pinfo->igroup_parse = 2;
 			pinfo->data = std::stringcase ("");
 		}
 		// ioffset
-		else if (n.compare (xmlIOffset) == 0 && !pinfo->ioffset_parse) {
+		else if (t == xmlTagIOffset && !pinfo->ioffset_parse) {
 			pinfo->ioffset_parse = 2;
 			pinfo->data = std::stringcase ("");
 		}
 		// bitsize
-		else if (n.compare (xmlBitSize) == 0 && !pinfo->bitsize_parse) {
+		else if (t == xmlTagBitSize && !pinfo->bitsize_parse) {
 			pinfo->bitsize_parse = 2;
 			pinfo->data = std::stringcase ("");
 		}
@@ -657,13 +1972,13 @@ static void XMLCALL startElement (void *userData, const char *name,
 	}
 
 	// Parse data type information
-	else if (n.compare (xmlDataTypes) == 0) {
+	else if (t == xmlTagDataTypes) {
 		if (pinfo->top()) {
 			++pinfo->types;
 		}
 		else ++pinfo->ignore;
 	}
-	else if (n.compare (xmlDataType) == 0) {
+	else if (t == xmlTagDataType) {
 		if (pinfo->types == 1) {
 			++pinfo->types;
 			pinfo->init();
@@ -672,7 +1987,7 @@ static void XMLCALL startElement (void *userData, const char *name,
 	}
 	else if (pinfo->types == 2) {
 		// name of type
-		if (n.compare (xmlName) == 0 && !pinfo->name_parse && 
+		if (t == xmlTagName && !pinfo->name_parse && 
 			(pinfo->struct_parse <= 1) && !pinfo->opc_cur) {
 				pinfo->name_parse = 2;
 				unsigned int decor = 0;
@@ -680,97 +1995,99 @@ static void XMLCALL startElement (void *userData, const char *name,
 				pinfo->rec.set_name_decoration (decor);
 		}
 		// right hand type
-		else if (n.compare (xmlType) == 0 && !pinfo->type_parse && 
+		else if (t == xmlTagType && !pinfo->type_parse && 
 			pinfo->struct_parse <= 1) {
 				pinfo->type_parse = 2;
+				pinfo->type_data.clear();
 				unsigned int decor = 0;
 				get_decoration (atts, decor);
 				pinfo->rec.set_type_decoration (decor);
 		}
 		// bit size
-		else if (n.compare (xmlBitSize) == 0 && !pinfo->bitsize_parse &&
+		else if (t == xmlTagBitSize && !pinfo->bitsize_parse &&
 			pinfo->struct_parse <= 1) {
 				pinfo->bitsize_parse = 2;
 				pinfo->data = std::stringcase ("");
 		}
 		// array info
-		else if (n.compare (xmlArrayInfo) == 0) {
+		else if (t == xmlTagArrayInfo) {
 			pinfo->array_parse = 2;
 			pinfo->array_bounds = dimension (0, 0);
 		}
 		// lower array bound
-		else if (n.compare (xmlArrayLBound) == 0 && 
+		else if (t == xmlTagArrayLBound && 
 			pinfo->array_parse == 2) {
 				pinfo->array_parse = 3;
 				pinfo->array_data = std::stringcase ("");
 		}
 		// array elements
-		else if (n.compare (xmlArrayElements) == 0 && 
+		else if (t == xmlTagArrayElements && 
 			pinfo->array_parse == 2) {
 				pinfo->array_parse = 3;
 				pinfo->array_data = std::stringcase ("");
 		}
 		// enum
-		else if (n.compare (xmlEnumInfo) == 0) {
+		else if (t == xmlTagEnumInfo) {
 			pinfo->enum_parse = 2;
 			pinfo->enum_element = enum_pair (0, "");
 			pinfo->enum_comment.clear();
 		}
 		// enum tag
-		else if (n.compare (xmlEnumEnum) == 0 && 
+		else if (t == xmlTagEnumEnum && 
 			pinfo->enum_parse == 2) {
 				pinfo->enum_parse = 3;
 				pinfo->enum_data = std::stringcase ("");
 		}
 		// enum text
-		else if (n.compare (xmlEnumText) == 0 && 
+		else if (t == xmlTagEnumText && 
 			pinfo->enum_parse == 2) {
 				pinfo->enum_parse = 3;
 				pinfo->enum_data = std::stringcase ("");
 		}
 		// enum comment
-		else if (n.compare (xmlEnumComment) == 0 && 
+		else if (t == xmlTagEnumComment && 
 			pinfo->enum_parse == 2) {
 				pinfo->enum_parse = 3;
 				pinfo->enum_data = std::stringcase ("");
 		}
 		// structure
-		else if (n.compare (xmlSubItem) == 0) {
+		else if (t == xmlTagSubItem) {
 			pinfo->struct_parse = 2;
 			pinfo->struct_element = item_record();
 		}
 		// structure element name
-		else if (n.compare (xmlName) == 0 && pinfo->struct_parse == 2 && 
+		else if (t == xmlTagName && pinfo->struct_parse == 2 && 
 			!pinfo->opc_cur) {
 				pinfo->struct_parse = 3;
 		}
 		// structure element type
-		else if (n.compare (xmlType) == 0 && pinfo->struct_parse == 2 && 
+		else if (t == xmlTagType && pinfo->struct_parse == 2 && 
 			!pinfo->opc_cur) {
 				pinfo->struct_parse = 4;
+				pinfo->type_data.clear();
 				unsigned int decor = 0;
 				get_decoration (atts, decor);
 				pinfo->struct_element.set_type_decoration (decor);
 		}
 		// structure element bitsize
-		else if (n.compare (xmlBitSize) == 0 && pinfo->struct_parse == 2 && 
+		else if (t == xmlTagBitSize && pinfo->struct_parse == 2 && 
 			!pinfo->opc_cur) {
 				pinfo->struct_parse = 5;
 				pinfo->data = std::stringcase ("");
 		}
 		// structure element bitoffs
-		else if (n.compare (xmlBitOffs) == 0 && pinfo->struct_parse == 2 && 
+		else if (t == xmlTagBitOffs && pinfo->struct_parse == 2 && 
 			!pinfo->opc_cur) {
 				pinfo->struct_parse = 5;
 				pinfo->data = std::stringcase ("");
 		}
 		// function block
-		else if (n.compare (xmlFbInfo) == 0) {
+		else if (t == xmlTagFbInfo) {
 			pinfo->fb_parse = 1;
 			++pinfo->ignore;
 		}
 		// opc properties
-		else if (n.compare (xmlProperties) == 0 && !pinfo->opc_cur &&
+		else if (t == xmlTagProperties && !pinfo->opc_cur &&
 			pinfo->name_parse <= 1 &&
 			pinfo->type_parse <= 1 &&
 			pinfo->enum_parse <= 1 &&
@@ -782,20 +2099,20 @@ static void XMLCALL startElement (void *userData, const char *name,
 				else pinfo->opc_cur = &pinfo->rec.get_opc();
 		}
 		// opc property
-		else if (n.compare (xmlProperty) == 0 && pinfo->opc_cur &&
+		else if (t == xmlTagProperty && pinfo->opc_cur &&
 			pinfo->opc_parse == 1) {
 				pinfo->opc_parse = 2;
 				pinfo->opc_prop = property_el ();
 		}
 		// opc property name
-		else if (n.compare (xmlName) == 0 && pinfo->opc_cur &&
+		else if (t == xmlTagName && pinfo->opc_cur &&
 			pinfo->opc_parse == 2) {
 				pinfo->opc_parse = 3;
 				pinfo->opc_data = "";
 				pinfo->opc_cdata = 1;
 		}
 		// opc property value
-		else if (n.compare (xmlValue) == 0 && pinfo->opc_cur &&
+		else if (t == xmlTagValue && pinfo->opc_cur &&
 			pinfo->opc_parse == 2) {
 				pinfo->opc_parse = 4;
 				pinfo->opc_data = "";
@@ -819,35 +2136,35 @@ static void XMLCALL endElement (void *userData, const char *name)
 		--pinfo->ignore;
 		return;
 	}
-	std::stringcase n (name ? name : "");
+	xml_tag t = get_xml_tag (name);
 
 	// parsing PLC project information
-	if (n.compare (xmlPlcProjectInfo) == 0) {
+	if (t == xmlTagPlcProjectInfo) {
 		if (pinfo->top()) pinfo->projects = false;
 	}
 
 	// Parse routing information
-	else if (n.compare (xmlRoutingInfo) == 0) {
+	else if (t == xmlTagRoutingInfo) {
 		if (pinfo->routing == 1) --pinfo->routing;
 	}
-	else if (n.compare (xmlAdsInfo) == 0) {
+	else if (t == xmlTagAdsInfo) {
 		if (pinfo->routing == 2) --pinfo->routing;
 	}
 	else if (pinfo->routing >= 2) {
 		// Net Id
-		if (n.compare (xmlNetId) == 0 && (pinfo->routing == 3)) {
+		if (t == xmlTagNetId && (pinfo->routing == 3)) {
 			pinfo->routing = 2;
 			trim_space (pinfo->data);
 			pinfo->get_projectinfo().set_netid(pinfo->data);
 		}
 		// Port
-		else if (n.compare (xmlPort) == 0 && (pinfo->routing == 4)) {
+		else if (t == xmlTagPort && (pinfo->routing == 4)) {
 			pinfo->routing = 2;
 			int num = strtol (pinfo->data.c_str(), NULL, 10);
 			pinfo->get_projectinfo().set_port (num);
 		}
 		// Target name
-		else if (n.compare (xmlTargetName) == 0 && (pinfo->routing == 5)) {
+		else if (t == xmlTagTargetName && (pinfo->routing == 5)) {
 			pinfo->routing = 2;
 			trim_space (pinfo->data);
 			pinfo->get_projectinfo().set_targetname(pinfo->data);
@@ -855,24 +2172,24 @@ static void XMLCALL endElement (void *userData, const char *name)
 	}
 
 	// Parse compiler information
-	else if (n.compare (xmlCompilerInfo) == 0) {
+	else if (t == xmlTagCompilerInfo) {
 		if (pinfo->compiler == 1) --pinfo->compiler;
 	}
 	else if (pinfo->compiler >= 1) {
 		// compiler version
-		if (n.compare (xmlCompilerVersion) == 0 && (pinfo->compiler == 2)) {
+		if (t == xmlTagCompilerVersion && (pinfo->compiler == 2)) {
 			pinfo->compiler = 1;
 			trim_space (pinfo->data);
 			pinfo->get_projectinfo().set_cmpl_versionstr(pinfo->data);
 		}
 		// twincat version
-		else if (n.compare (xmlTwinCATVersion) == 0 && (pinfo->compiler == 3)) {
+		else if (t == xmlTagTwinCATVersion && (pinfo->compiler == 3)) {
 			pinfo->compiler = 1;
 			trim_space (pinfo->data);
 			pinfo->get_projectinfo().set_tcat_versionstr (pinfo->data);
 		}
 		// CPU family
-		else if (n.compare (xmlCpuFamily) == 0 && (pinfo->compiler == 4)) {
+		else if (t == xmlTagCpuFamily && (pinfo->compiler == 4)) {
 			pinfo->compiler = 1;
 			trim_space (pinfo->data);
 			pinfo->get_projectinfo().set_cpu_family (pinfo->data);
@@ -880,10 +2197,10 @@ static void XMLCALL endElement (void *userData, const char *name)
 	}
 
 	// parsing symbols
-	else if (n.compare (xmlSymbols) == 0) {
+	else if (t == xmlTagSymbols) {
 		if (pinfo->symbols == 1) --pinfo->symbols;
 	}
-	else if (n.compare (xmlSymbol) == 0) {
+	else if (t == xmlTagSymbol) {
 		if (pinfo->symbols == 2) {
 			--pinfo->symbols;
 			if (!pinfo->sym.get_name().empty()) {
@@ -891,27 +2208,33 @@ static void XMLCALL endElement (void *userData, const char *name)
 				if (pinfo->sym.get_type_pointer()) {
 					pinfo->sym.get_opc().get_properties()[OPC_PROP_RIGHTS] = "1";
 				}
-				pinfo->get_symbols().push_back (pinfo->sym);
+				if (pinfo->stream) {
+					pinfo->stream->symbol_done (pinfo->sym);
+				}
+				else {
+					pinfo->get_symbols().push_back (pinfo->sym);
+				}
 			}
 		}
 	}
 	else if (pinfo->symbols == 2) {
 		// parsed a name (trim space)
-		if (n.compare (xmlName) == 0 && pinfo->name_parse == 2) {
+		if (t == xmlTagName && pinfo->name_parse == 2) {
 			pinfo->name_parse = 1;
 			trim_space (pinfo->sym.get_name());
 		}
 		// parsed a type (trim space)
-		else if (n.compare (xmlType) == 0 && pinfo->type_parse == 2) {
+		else if (t == xmlTagType && pinfo->type_parse == 2) {
 			pinfo->type_parse = 1;
-			trim_space (pinfo->sym.get_type_name());
+			trim_space (pinfo->type_data);
+			pinfo->sym.set_type_name (pinfo->type_data);
 		}
 		// opc properties
-		else if (n.compare (xmlProperties) == 0 && pinfo->opc_parse == 1) {
+		else if (t == xmlTagProperties && pinfo->opc_parse == 1) {
 			pinfo->opc_parse = 0;
 		}
 		// opc property
-		else if (n.compare (xmlProperty) == 0 && pinfo->opc_parse == 2) {
+		else if (t == xmlTagProperty && pinfo->opc_parse == 2) {
 			pinfo->opc_parse = 1;
 			if (pinfo->opc_prop.first == -1) {
 				int num = strtol (pinfo->opc_prop.second.c_str(), NULL, 10);
@@ -922,7 +2245,7 @@ static void XMLCALL endElement (void *userData, const char *name)
 			}
 		}
 		// opc property name
-		else if (n.compare (xmlName) == 0 && pinfo->opc_parse == 3) {
+		else if (t == xmlTagName && pinfo->opc_parse == 3) {
 			pinfo->opc_parse = 2;
 			trim_space (pinfo->opc_data);
 			int num = 0;
@@ -937,31 +2260,34 @@ static void XMLCALL endElement (void *userData, const char *name)
 			pinfo->opc_prop.first = num;
 		}
 		// opc property value
-		else if (n.compare (xmlValue) == 0 && pinfo->opc_parse == 4) {
+		else if (t == xmlTagValue && pinfo->opc_parse == 4) {
 			pinfo->opc_parse = 2;
 			pinfo->opc_prop.second = pinfo->opc_data;
 		}
 		// parsed a igroup (convert to integer)
-		else if (n.compare (xmlIGroup) == 0 && pinfo->igroup_parse == 2) {
+		else if (t == xmlTagIGroup && pinfo->igroup_parse == 2) {
 			pinfo->igroup_parse = 1;
 			pinfo->sym.set_igroup (strtol (pinfo->data.c_str(), NULL, 10));
 		}
 		// parsed a ioffset (convert to integer)
-		else if (n.compare (xmlIOffset) == 0 && pinfo->ioffset_parse == 2) {
+		else if (t == xmlTagIOffset && pinfo->ioffset_parse == 2) {
 			pinfo->ioffset_parse = 1;
 			pinfo->sym.set_ioffset (strtol (pinfo->data.c_str(), NULL, 10));
 		}
 		// parsed a bitsize (convert to integer)
-		else if (n.compare (xmlBitSize) == 0 && pinfo->bitsize_parse == 2) {
+		else if (t == xmlTagBitSize && pinfo->bitsize_parse == 2) {
 			pinfo->bitsize_parse = 1;
 			pinfo->sym.set_bytesize (strtol (pinfo->data.c_str(), NULL, 10) / 8);
 		}
 	}
 	// parsing data types
-	else if (n.compare (xmlDataTypes) == 0) {
-		if (pinfo->types == 1) --pinfo->types;
+	else if (t == xmlTagDataTypes) {
+		if (pinfo->types == 1) {
+			--pinfo->types;
+			if (pinfo->stream) pinfo->stream->types_done();
+		}
 	}
-	else if (n.compare (xmlDataType) == 0) {
+	else if (t == xmlTagDataType) {
 		if (pinfo->types == 2) {
 			--pinfo->types;
 			pinfo->rec.set_type_description (pinfo->get_type_description());
@@ -975,43 +2301,44 @@ static void XMLCALL endElement (void *userData, const char *name)
 	}
 	else if (pinfo->types == 2) {
 		// parsed a name (trim space)
-		if (n.compare (xmlName) == 0 && pinfo->name_parse == 2) {
+		if (t == xmlTagName && pinfo->name_parse == 2) {
 			pinfo->name_parse = 1;
 			trim_space (pinfo->rec.get_name());
 		}
 		// parsed a type (trim space)
-		else if (n.compare (xmlType) == 0 && pinfo->type_parse == 2) {
+		else if (t == xmlTagType && pinfo->type_parse == 2) {
 			pinfo->type_parse = 1;
-			trim_space (pinfo->rec.get_type_name());
+			trim_space (pinfo->type_data);
+			pinfo->rec.set_type_name (pinfo->type_data);
 		}
 		// parsed a bit size
-		else if (n.compare (xmlBitSize) == 0 && pinfo->bitsize_parse == 2) {
+		else if (t == xmlTagBitSize && pinfo->bitsize_parse == 2) {
 			pinfo->bitsize_parse = 1;
 			pinfo->rec.set_bit_size (strtol (pinfo->data.c_str(), NULL, 10));
 		}
 		// parsed an array info
-		else if (n.compare (xmlArrayInfo) == 0 && pinfo->array_parse == 2) {
+		else if (t == xmlTagArrayInfo && pinfo->array_parse == 2) {
 			pinfo->array_parse = 1;
 			if (pinfo->array_bounds.second > 0) {
 				pinfo->rec.get_array_dimensions().push_back (pinfo->array_bounds);
 			}
 		}
 		// lower array bound
-		else if (n.compare (xmlArrayLBound) == 0 && 
+		else if (t == xmlTagArrayLBound && 
 			pinfo->array_parse == 3) {
 				pinfo->array_bounds.first = 
 					strtol (pinfo->array_data.c_str(), NULL, 10);
 				pinfo->array_parse = 2;
 		}
 		// array elements
-		else if (n.compare (xmlArrayElements) == 0 && 
+		else if (t == xmlTagArrayElements && 
 			pinfo->array_parse == 3) {
 				pinfo->array_bounds.second = 
 					strtol (pinfo->array_data.c_str(), NULL, 10);
 				pinfo->array_parse = 2;
 		}
 		// parsed an enum info
-		else if (n.compare (xmlEnumInfo) == 0 && pinfo->enum_parse == 2) {
+		else if (t == xmlTagEnumInfo && pinfo->enum_parse == 2) {
 			pinfo->enum_parse = 1;
 			pinfo->rec.get_enum_list().insert (pinfo->enum_element);
 			if (!pinfo->enum_comment.empty() && (pinfo->enum_element.first >= 0) &&
@@ -1020,60 +2347,61 @@ static void XMLCALL endElement (void *userData, const char *name)
 			}
 		}
 		// enum tag
-		else if (n.compare (xmlEnumEnum) == 0 && 
+		else if (t == xmlTagEnumEnum && 
 			pinfo->enum_parse == 3) {
 				pinfo->enum_element.first = 
 					strtol (pinfo->enum_data.c_str(), NULL, 10);
 				pinfo->enum_parse = 2;
 		}
 		// enum text
-		else if (n.compare (xmlEnumText) == 0 && 
+		else if (t == xmlTagEnumText && 
 			pinfo->enum_parse == 3) {
 				trim_space (pinfo->enum_data);
 				pinfo->enum_element.second = pinfo->enum_data;
 				pinfo->enum_parse = 2;
 		}
 		// enum comment
-		else if (n.compare (xmlEnumComment) == 0 && 
+		else if (t == xmlTagEnumComment && 
 			pinfo->enum_parse == 3) {
 				trim_space (pinfo->enum_data);
 				pinfo->enum_comment = pinfo->enum_data;
 				pinfo->enum_parse = 2;
 		}
 		// parsed a subitem
-		else if (n.compare (xmlSubItem) == 0 && pinfo->struct_parse == 2) {
+		else if (t == xmlTagSubItem && pinfo->struct_parse == 2) {
 			pinfo->struct_parse = 1;
 			pinfo->rec.get_struct_list().push_back (pinfo->struct_element);
 		}
 		// subitem name
-		else if (n.compare (xmlName) == 0 && pinfo->struct_parse == 3) {
+		else if (t == xmlTagName && pinfo->struct_parse == 3) {
 			trim_space (pinfo->struct_element.get_name());
 			pinfo->struct_parse = 2;
 		}
 		// subitem type
-		else if (n.compare (xmlType) == 0 && pinfo->struct_parse == 4) {
-			trim_space (pinfo->struct_element.get_type_name());
+		else if (t == xmlTagType && pinfo->struct_parse == 4) {
+			trim_space (pinfo->type_data);
+			pinfo->struct_element.set_type_name (pinfo->type_data);
 			pinfo->struct_parse = 2;
 		}
 		// subitem bitsize
-		else if (n.compare (xmlBitSize) == 0 && pinfo->struct_parse == 5) {
+		else if (t == xmlTagBitSize && pinfo->struct_parse == 5) {
 			pinfo->struct_element.set_bit_size (
 				strtol (pinfo->data.c_str(), NULL, 10));
 			pinfo->struct_parse = 2;
 		}
 		// subitem bitoffs
-		else if (n.compare (xmlBitOffs) == 0 && pinfo->struct_parse == 5) {
+		else if (t == xmlTagBitOffs && pinfo->struct_parse == 5) {
 			pinfo->struct_element.set_bit_offset (
 				strtol (pinfo->data.c_str(), NULL, 10));
 			pinfo->struct_parse = 2;
 		}
 		// opc properties
-		else if (n.compare (xmlProperties) == 0 && pinfo->opc_parse == 1) {
+		else if (t == xmlTagProperties && pinfo->opc_parse == 1) {
 			pinfo->opc_parse = 0;
 			pinfo->opc_cur = 0;
 		}
 		// opc property
-		else if (n.compare (xmlProperty) == 0 && pinfo->opc_parse == 2) {
+		else if (t == xmlTagProperty && pinfo->opc_parse == 2) {
 			pinfo->opc_parse = 1;
 			if (pinfo->opc_prop.first == -1) {
 				int num = strtol (pinfo->opc_prop.second.c_str(), NULL, 10);
@@ -1086,7 +2414,7 @@ static void XMLCALL endElement (void *userData, const char *name)
 			}
 		}
 		// opc property name
-		else if (n.compare (xmlName) == 0 && pinfo->opc_parse == 3) {
+		else if (t == xmlTagName && pinfo->opc_parse == 3) {
 			pinfo->opc_parse = 2;
 			trim_space (pinfo->opc_data);
 			int num = 0;
@@ -1101,7 +2429,7 @@ static void XMLCALL endElement (void *userData, const char *name)
 			pinfo->opc_prop.first = num;
 		}
 		// opc property value
-		else if (n.compare (xmlValue) == 0 && pinfo->opc_parse == 4) {
+		else if (t == xmlTagValue && pinfo->opc_parse == 4) {
 			pinfo->opc_parse = 2;
 			pinfo->opc_prop.second = pinfo->opc_data;
 		}
@@ -1181,7 +2509,7 @@ static void XMLCALL dataElement (void *userData, const char *data, int len)
 		}
 		// append string to type
 		else if (pinfo->type_parse == 2) {
-			pinfo->sym.get_type_name().append (data, len);
+			pinfo->type_data.append (data, len);
 		}
 		// append opc data
 		else if (pinfo->opc_parse >= 3) {
@@ -1204,7 +2532,7 @@ static void XMLCALL dataElement (void *userData, const char *data, int len)
 		}
 		// append string to type
 		else if (pinfo->type_parse == 2) {
-			pinfo->rec.get_type_name().append (data, len);
+			pinfo->type_data.append (data, len);
 		}
 		// append string to bitdata
 		else if (pinfo->bitsize_parse == 2) {
@@ -1224,7 +2552,7 @@ static void XMLCALL dataElement (void *userData, const char *data, int len)
 		}
 		// append struct element type
 		else if (pinfo->struct_parse == 4) {
-			pinfo->struct_element.get_type_name().append (data, len);
+			pinfo->type_data.append (data, len);
 		}
 		// append struct element bitsize
 		else if (pinfo->struct_parse == 5) {
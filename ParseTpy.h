@@ -1,6 +1,10 @@
 #pragma once
 #include "stdafx.h"
 #include "ParseUtil.h"
+#include <thread>
+#include <condition_variable>
+#include <type_traits>
+#include <deque>
 
 /** @file ParseTpy.h
 	Header which includes classes to parse a TwinCAT tpy file. 
@@ -184,10 +188,8 @@ public:
 	void set_name (std::stringcase n) { name = n; }
 	/// Get type name 
 	const std::stringcase& get_type_name() const { return type_n; }
-	/// Get type name 
-	std::stringcase& get_type_name() { return type_n; }
 	/// Set type name
-	void set_type_name (std::stringcase t) { type_n = t; }
+	void set_type_name (const std::interned_stringcase& t) { type_n = t; }
 	/// Get type decoration
 	unsigned int get_type_decoration () const { return type_decoration; }
 	/// Set type decoration 
@@ -205,8 +207,8 @@ public:
 protected:
 	/// name of type
 	std::stringcase		name;
-	/// type definition
-	std::stringcase		type_n;
+	/// type definition, interned since many records share it
+	std::interned_stringcase type_n;
 	/// decoration or type ID of type definition
 	unsigned int		type_decoration;
 	/// this is a pointer
@@ -325,12 +327,44 @@ public:
 	using type_multipmap::value_type;
 
 	/// Constructor
-	type_map() {}
-	/// insert a new element
+	type_map() : index_valid (false) {}
+	/// Copy constructor (index is not copied)
+	type_map (const type_map& tm) 
+		: type_multipmap (tm), index_valid (false) {}
+	/// Assignment operator (index is not copied)
+	type_map& operator= (const type_map& tm) {
+		type_multipmap::operator= (tm); 
+		index.clear(); index_valid = false; return *this; }
+
+	/// insert a new element (invalidates the index)
 	void insert (value_type val);
 	/// find an element
 	const value_type::second_type* 
 	find (value_type::first_type id, const std::stringcase& typn) const;
+	/// Build the hash index used by find, call after all types are inserted
+	void build_index();
+
+	/// const iterator
+	using type_multipmap::const_iterator;
+	/// Get first element
+	const_iterator begin() const { return type_multipmap::begin(); }
+	/// Get end of list
+	const_iterator end() const { return type_multipmap::end(); }
+	/// Get number of types
+	size_type size() const { return type_multipmap::size(); }
+
+protected:
+	/// Hash of a decoration and the case-folded name without namespace
+	static unsigned long long index_key (value_type::first_type id, 
+		const std::stringcase& typn);
+
+	/// Type index: candidates by key, in the order of the multimap
+	typedef std::unordered_map<unsigned long long, 
+		std::vector<const value_type*>> type_index;
+	/// Type index
+	type_index		index;
+	/// Type index is up to date
+	bool			index_valid;
 };
 
 
@@ -354,21 +388,311 @@ public:
 typedef std::list<symbol_record> symbol_list;
 
 
+/** This class stores the arguments of process calls, so that the type
+	trees of symbols can be expanded in parallel and the results be passed
+	to the process function in the original order.
+	@brief Batch of process arguments
+************************************************************************/
+class process_batch
+{
+public:
+	/// Default constructor
+	process_batch() : num (0) {}
+
+	/// Store a process argument
+	bool operator() (const ParseUtil::process_arg_tc& arg) {
+		list.push_back (entry (arg)); return true; }
+
+	/// Calls the process function for every stored argument in order
+	/// @param process Function class
+	/// @return Number of process calls which failed
+	template <class Function>
+	int replay (Function& process) const;
+
+	/// Number of processed variables as counted by process_symbols
+	int				num;
+
+protected:
+	/// Stored copy of a process argument
+	struct entry {
+		/// Constructor
+		explicit entry (const ParseUtil::process_arg_tc& arg)
+			: loc (arg.get_igroup(), arg.get_ioffset(), arg.get_bytesize()),
+			name (arg.get_var()), ptype (arg.get_process_type()), 
+			opc (arg.get_opc()), type_n (arg.get_type_name()), 
+			atomic (arg.is_atomic()) {}
+		/// Memory location
+		ParseUtil::memory_location	loc;
+		/// Variable name
+		ParseUtil::variable_name	name;
+		/// Process type
+		ParseUtil::process_type_enum ptype;
+		/// OPC list
+		ParseUtil::opc_list			opc;
+		/// Type name
+		std::interned_stringcase	type_n;
+		/// Atomic type
+		bool						atomic;
+	};
+	/// List of stored arguments
+	std::vector<entry>	list;
+};
+
+
+/** This class stores the flattened layout of a structure or function 
+	block type: the process arguments of all its leaves, relative to the 
+	memory location and variable name of an instance. A layout is only
+	valid for instances with the same default OPC list, byte size and
+	recursive level, such as the elements of an array.
+	@brief Flattened type layout
+************************************************************************/
+class type_layout
+{
+public:
+	/// Constructor
+	/// @param defopc Default list of OPC parameters
+	/// @param loc Memory location of variable
+	/// @param level Recursive level
+	/// @param tags Process rule
+	/// @param nostrings String rule
+	type_layout (const ParseUtil::opc_list& defopc, 
+		const ParseUtil::memory_location& loc, int level, 
+		ParseUtil::process_tag_enum tags, bool nostrings)
+		: built (false), key_opc (defopc), 
+		key_bytesize (loc.get_bytesize()), key_level (level), 
+		key_tags (tags), key_nostrings (nostrings) {}
+
+	/// Checks if an instance can use this layout
+	bool matches (const ParseUtil::opc_list& defopc, 
+		const ParseUtil::memory_location& loc, int level, 
+		ParseUtil::process_tag_enum tags, bool nostrings) const {
+		return (key_bytesize == loc.get_bytesize()) && (key_level == level) &&
+			(key_tags == tags) && (key_nostrings == nostrings) &&
+			(key_opc == defopc); }
+
+	/// Record the process argument of a leaf
+	/// @param arg Process argument
+	/// @param loc Memory location of the recorded instance
+	/// @param prefix Variable name of the recorded instance
+	void add (const ParseUtil::process_arg_tc& arg, 
+		const ParseUtil::memory_location& loc,
+		const ParseUtil::variable_name& prefix) {
+		list.push_back (entry (arg, loc, prefix)); }
+
+	/// Calls the process function for every leaf of an instance
+	/// @param process Function class
+	/// @param loc Memory location of the instance
+	/// @param prefix Variable name of the instance
+	/// @return Number of process calls which failed
+	template <class Function>
+	int replay (Function& process, const ParseUtil::memory_location& loc,
+		ParseUtil::variable_name& prefix) const;
+
+	/// Number of recorded leaves
+	int size() const { return (int)list.size(); }
+
+	/// Layout is complete
+	bool			built;
+
+protected:
+	/// Leaf of a layout
+	struct entry {
+		/// Constructor
+		entry (const ParseUtil::process_arg_tc& arg, 
+			const ParseUtil::memory_location& loc,
+			const ParseUtil::variable_name& prefix)
+			: offset (arg.get_ioffset() - loc.get_ioffset()), 
+			bytesize (arg.get_bytesize()),
+			suffix (arg.get_name().substr (prefix.get_name().length()),
+				arg.get_alias().substr (prefix.get_alias().length())),
+			ptype (arg.get_process_type()), opc (arg.get_opc()), 
+			type_n (arg.get_type_name()), atomic (arg.is_atomic()) {}
+		/// Offset relative to the instance
+		int							offset;
+		/// Size in bytes
+		int							bytesize;
+		/// Name and alias relative to the instance
+		ParseUtil::variable_name	suffix;
+		/// Process type
+		ParseUtil::process_type_enum ptype;
+		/// OPC list
+		ParseUtil::opc_list			opc;
+		/// Type name
+		std::interned_stringcase	type_n;
+		/// Atomic type
+		bool						atomic;
+	};
+	/// List of leaves
+	std::vector<entry>	list;
+
+	/// Default OPC list of the recorded instance
+	ParseUtil::opc_list	key_opc;
+	/// Byte size of the recorded instance
+	int					key_bytesize;
+	/// Recursive level of the recorded instance
+	int					key_level;
+	/// Process rule
+	ParseUtil::process_tag_enum key_tags;
+	/// String rule
+	bool				key_nostrings;
+};
+
+/** This class is passed as the process function while a type layout is
+	recorded. It stores the leaves and forwards them to the actual process 
+	function.
+	@brief Type layout recorder
+************************************************************************/
+class layout_recorder
+{
+public:
+	/// Forward function
+	typedef bool (*forward_func) (void* ctx, const ParseUtil::process_arg_tc& arg);
+
+	/// Constructor
+	layout_recorder (type_layout& l, const ParseUtil::memory_location& loc,
+		const ParseUtil::variable_name& prefix, forward_func f, void* ctx)
+		: layout (l), base (loc), name (prefix), func (f), context (ctx) {}
+
+	/// Record and forward a process argument
+	bool operator() (const ParseUtil::process_arg_tc& arg) {
+		layout.add (arg, base, name); return func (context, arg); }
+
+protected:
+	/// Layout which is recorded
+	type_layout&				layout;
+	/// Memory location of the recorded instance
+	ParseUtil::memory_location	base;
+	/// Variable name of the recorded instance
+	ParseUtil::variable_name	name;
+	/// Forward function
+	forward_func				func;
+	/// Forward context
+	void*						context;
+};
+
+
+/** This class is passed as the process function when a name filter is 
+	set. Only variables which are selected by the filter are forwarded.
+	@brief Filtered process function
+************************************************************************/
+template <class Function>
+class filtered_process
+{
+public:
+	/// Constructor
+	filtered_process (Function& func, const ParseUtil::name_filter& nf)
+		: process (func), filter (nf) {}
+
+	/// Forward a process argument if selected
+	bool operator() (const ParseUtil::process_arg_tc& arg) {
+		return filter.select (arg.get_name()) && process (arg); }
+
+protected:
+	/// Process function
+	Function&						process;
+	/// Name filter
+	const ParseUtil::name_filter&	filter;
+};
+
 /** This class holds the structure of a tpy file
 	@brief Tpy file parsing
 ************************************************************************/
+class tpy_stream;
+
 class tpy_file : public ParseUtil::tag_processing
 {
+	friend class tpy_stream;
 public:
 	/// Default constructor
-	tpy_file () {}
+	tpy_file () : use_cache (false), use_stream (false), process_threads (1) {}
 	/// Constructor
 	tpy_file (FILE* inp);
 
+	/// Parse a command line
+	/// Same as tag_processing::getopt, but also handles:
+	///
+	/// /yc: Use a binary cache of the parsed tpy file
+	/// /nc: Always parse the XML tpy file
+	/// /pp: Pipelined parsing, process symbols while the file is read
+	/// /fi 'pattern': Only process variables matching the pattern
+	/// /fx 'pattern': Do not process variables matching the pattern
+	/// /ff 'file': Read include/exclude patterns from a file
+	/// /pt 'num': Number of threads to expand symbols (0 for all cores)
+	/// @param argc Number of command line arguments
+	/// @param argv List of command line arguments, same format as in main()
+	/// @param argp Excluded/processed arguments (in/out), array length must be argc
+	/// @return Number of arguments processed
+	int getopt (int argc, const char* const argv[], bool argp[] = 0);
+
+	/// Get the cache rule
+	bool get_use_cache() const { return use_cache; }
+	/// Set the cache rule
+	void set_use_cache (bool cache) { use_cache = cache; }
+	/// Get the pipelined parsing rule
+	bool get_use_stream() const { return use_stream; }
+	/// Set the pipelined parsing rule (see tpy_stream)
+	void set_use_stream (bool stream) { use_stream = stream; }
+	/// Get the name filter
+	const ParseUtil::name_filter& get_filter() const { return filter; }
+	/// Get the name filter
+	ParseUtil::name_filter& get_filter() { return filter; }
+	/// Check if a symbol is processed (published and selected by the filter)
+	bool select_symbol (const symbol_record& sym) const {
+		return (get_export_all() || 
+			(sym.get_opc().get_opc_state() == ParseUtil::publish)) &&
+			(filter.empty() || filter.select_symbol (sym.get_name())); }
+	/// Get the number of threads used by process_symbols
+	int get_process_threads() const { return process_threads; }
+	/// Set the number of threads used by process_symbols (0 for all cores)
+	void set_process_threads (int threads) { 
+		process_threads = threads > 0 ? threads : 
+			(int)std::thread::hardware_concurrency(); }
+
 	/// Parse a file
 	bool parse (FILE* inp);
 	/// Parse a memory region
 	bool parse (const char* p, int len);
+	/// Parse a file by mapping it into memory (falls back to reading it)
+	/// When the cache is enabled, a valid cache file next to the tpy file
+	/// is loaded instead, otherwise it is (re)written after parsing.
+	/// Files with the extension .upload are read as recorded ADS uploads
+	bool parse_file (const char* filename);
+
+	/** Loads the symbol and data type tables of an ADS symbol upload
+	(index groups ADSIGRP_SYM_UPLOAD and ADSIGRP_SYM_DT_UPLOAD) instead 
+	of a tpy file. OPC properties are taken from the attributes and the 
+	comments. Array types which are not part of the data type table are
+	derived from their names.
+	@param syms Symbol table
+	@param symlen Length of symbol table
+	@param types Data type table
+	@param typelen Length of data type table
+	@return True if successful
+	@brief Parse an ADS symbol upload
+	*/
+	bool parse_upload (const char* syms, size_t symlen, 
+		const char* types, size_t typelen);
+	/** Loads a recorded ADS symbol upload, see write_upload
+	@param p Pointer to recorded upload
+	@param len Length of recorded upload
+	@return True if successful
+	@brief Parse a recorded ADS symbol upload
+	*/
+	bool parse_upload (const char* p, size_t len);
+	/** Records an ADS symbol upload in a file, together with the 
+	routing information of the PLC. 
+	@param filename Name of upload file
+	@param route ADS routing information
+	@param syms Symbol table
+	@param symlen Length of symbol table
+	@param types Data type table
+	@param typelen Length of data type table
+	@return True if successful
+	@brief Write a recorded ADS symbol upload
+	*/
+	static bool write_upload (const char* filename, 
+		const ads_routing_info& route, const char* syms, size_t symlen, 
+		const char* types, size_t typelen);
 
 	/// Return list of symbols
 	const symbol_list& get_symbols() const { return sym_list; }
@@ -376,8 +700,14 @@ public:
 	const type_map& get_types() const { return type_list; }
 	/// Return project information
 	const project_record& get_project_info() const { return project_info; }
+	/// Return project information
+	project_record& get_project_info() { return project_info; }
 
 	/** Iterates over the symbol list and processes all specified tags.
+	If more than one process thread is set, the symbols are expanded
+	in parallel, but the process function is called in the same order
+	and from the calling thread only. Symbols which are not selected by 
+	the name filter are skipped before their type tree is expanded.
 	@param process Function class
 	@param prefix Prefix which is added to all variable names
 	@return Number of processes variables
@@ -408,7 +738,8 @@ public:
 	@param defopc Default list of OPC parameters
 	@param loc Memory location of variable
 	@param process Function class
-	@param varname Name of variable of the specified type (default is "")
+	@param varname Name of variable of the specified type, segments are
+	appended and removed again while descending into the type
 	@param level Recursive level (stops when reaching 100, default 0)
 	@return Number of processes variables
 	@brief Process the type tree of a type
@@ -416,8 +747,7 @@ public:
 	template <class Function>
 	int process_type_tree (const type_record& typ, 
 		ParseUtil::opc_list defopc, const ParseUtil::memory_location& loc, 
-		Function& process, 
-		const ParseUtil::variable_name& varname = ParseUtil::variable_name(), 
+		Function& process, ParseUtil::variable_name& varname, 
 		int level = 0) const;
 
 	/** Starts with a type and resolves the type information 
@@ -428,7 +758,8 @@ public:
 	@param defopc Default list of OPC parameters
 	@param loc Memory location of variable
 	@param process Function class
-	@param varname Name of variable of the specified type (default is "")
+	@param varname Name of variable of the specified type, segments are
+	appended and removed again while descending into the type
 	@param level Recursive level (stops when reaching 100, default 0)
 	@return Number of processes variables
 	@brief Process the type tree of a type
@@ -436,8 +767,7 @@ public:
 	template <class Function>
 	int process_type_tree (const std::stringcase& typ, unsigned int id, 
 		const ParseUtil::opc_list& defopc, const ParseUtil::memory_location& loc, 
-		Function& process, 
-		const ParseUtil::variable_name& varname = ParseUtil::variable_name(), 
+		Function& process, ParseUtil::variable_name& varname, 
 		int level = 0) const;
 
 protected:
@@ -447,13 +777,97 @@ protected:
 	symbol_list		sym_list;
 	/// List of types
 	type_map		type_list;
+	/// Use binary cache when parsing a file
+	bool			use_cache;
+	/// Process symbols while parsing a file
+	bool			use_stream;
+	/// Number of threads used to expand symbols
+	int				process_threads;
+	/// Include/exclude patterns of processed variables
+	ParseUtil::name_filter	filter;
+
+	/// Map of type layouts
+	typedef std::unordered_map<const type_record*, 
+		std::shared_ptr<type_layout>> type_layout_map;
+	/// Layouts of structure and function block types
+	mutable type_layout_map	layout_list;
+	/// Mutex for layout list
+	mutable std::mutex		layout_mux;
+
+	/** Loads the parsed tables from a cache file. The cache is rejected,
+	if its version or the size, time and hash of the tpy file do not match.
+	@param filename Name of cache file
+	@param key Cache key of the tpy file
+	@return True if successful
+	@brief Read binary cache
+	*/
+	bool read_cache (const char* filename, const std::string& key);
+	/** Saves the parsed tables to a cache file.
+	@param filename Name of cache file
+	@param key Cache key of the tpy file
+	@return True if successful
+	@brief Write binary cache
+	*/
+	bool write_cache (const char* filename, const std::string& key) const;
 
 	/** This function is called at the end of parsing.
 	Here we set the TC server name in the OPC variables for each symbol
+	and build the type index
 	@brief finish up the parsing
 	*/
 	void parse_finish();
 
+	/** Parses a file and hands each completed symbol to a stream
+	instead of adding it to the symbol list. parse_finish is not called.
+	@param filename Name of tpy file
+	@param stream Stream receiving types and symbols
+	@return True if successful
+	@brief Parse a file into a stream
+	*/
+	bool parse_stream (const char* filename, tpy_stream& stream);
+
+	/** Processes the symbol list serially or in parallel
+	@param process Function class
+	@param prefix Prefix which is added to all variable names
+	@return Number of processes variables
+	@brief Process the type tree of all symbols
+	*/
+	template <class Function>
+	int process_symbol_list (Function& process, 
+		const std::stringcase& prefix) const;
+
+	/** Expands the symbols in chunks on a pool of worker threads into 
+	process batches. The batches are replayed in the original symbol order
+	by the calling thread.
+	@param process Function class
+	@param prefix Prefix which is added to all variable names
+	@return Number of processes variables
+	@brief Process the type tree of all symbols in parallel
+	*/
+	template <class Function>
+	int process_symbols_parallel (Function& process, 
+		const std::stringcase& prefix) const;
+
+	/** Processes a structure or function block instance through its
+	flattened layout. The first instance with a given default OPC list, 
+	size and level is processed normally, the second one is recorded
+	and later ones are replayed from the layout.
+	@param typ Type to resolve
+	@param defopc Default list of OPC parameters
+	@param loc Memory location of variable
+	@param process Function class
+	@param varname Name of variable of the specified type
+	@param level Recursive level
+	@param num Number of processes variables (return)
+	@return True if processed, false if the normal path has to be used
+	@brief Process the type tree of a structure using its layout
+	*/
+	template <class Function>
+	bool process_layout (const type_record& typ, 
+		const ParseUtil::opc_list& defopc, const ParseUtil::memory_location& loc, 
+		Function& process, ParseUtil::variable_name& varname, 
+		int level, int& num) const;
+
 	/** Resolves the type information for an array. Calls the process 
 	function for each index with an argument of type process_arg.
 	@param typ Name of type to resolve
@@ -461,7 +875,8 @@ protected:
 	@param defopc Default list of OPC parameters
 	@param loc Memory location of variable
 	@param process Function class
-	@param varname Name of variable of the specified type (default is "")
+	@param varname Name of variable of the specified type, segments are
+	appended and removed again while descending into the type
 	@param level Recursive level (stops when reaching 100, default 0)
 	@return Number of processes variables
 	@brief Process the type tree of a type
@@ -469,7 +884,102 @@ protected:
 	template <class Function>
 	int process_array (const type_record& typ, dimensions dim, 
 		const ParseUtil::opc_list& defopc, const ParseUtil::memory_location& loc, 
-		Function& process, const ParseUtil::variable_name& varname, int level) const;
+		Function& process, ParseUtil::variable_name& varname, int level) const;
+};
+
+/** This class parses a tpy file on a background thread and processes
+	the symbols while the file is still being read. The parser hands 
+	completed symbols through a bounded queue to the calling thread, 
+	which expands them as soon as all types are known. Symbols are only 
+	kept in the symbol list when the binary cache is rebuilt. 
+	If pipelined parsing is disabled, or a valid cache is found, the file 
+	is loaded up front and processed by tpy_file::process_symbols.
+	@brief Pipelined parsing and processing of a tpy file
+ ************************************************************************/
+class tpy_stream
+{
+public:
+	/// Constructor
+	/// @param tpyfile tpy file to parse into
+	/// @param maxqueue Maximum number of queued symbols
+	explicit tpy_stream (tpy_file& tpyfile, size_t maxqueue = 1024);
+	/// Destructor, stops the parser thread
+	~tpy_stream();
+
+	/// Start parsing a file
+	/// @param filename Name of tpy file
+	/// @return True if successful
+	bool start (const char* filename);
+	/// Parse an open file up front
+	/// @param inp File to parse
+	/// @return True if successful
+	bool start (FILE* inp);
+	/// Wait until the project information and all types are available
+	/// @return False if parsing failed
+	bool wait_types();
+	/** Processes the symbols as they are parsed. Should be called once
+	after wait_types.
+	@param process Function class
+	@param prefix Prefix which is added to all variable names
+	@return Number of processes variables
+	@brief Process the type tree of all symbols
+	*/
+	template <class Function>
+	int process (Function& process, 
+		const std::stringcase& prefix = std::stringcase());
+	/// Wait for the parser thread and finish up the tpy file
+	/// @return True if the whole file was parsed successfully
+	bool finish();
+
+	/// Called by the parser when all types are parsed
+	void types_done();
+	/// Called by the parser for every symbol
+	void symbol_done (symbol_record& sym);
+
+protected:
+	/// Process the symbols from the queue
+	template <class Function>
+	int process_queue (Function& process, const std::stringcase& prefix);
+	/// Get the next parsed symbol, blocks until one is available
+	/// @return False if parsing has finished
+	bool pop (symbol_record& sym);
+
+	/// tpy file
+	tpy_file&		tpy;
+	/// Parser thread
+	std::thread		parser;
+	/// Mutex for queue and state
+	std::mutex		mux;
+	/// Condition variable for queue and state
+	std::condition_variable cond;
+	/// Queue of parsed symbols
+	std::deque<symbol_record> queue;
+	/// Maximum queue length
+	size_t			max_queue;
+	/// File was loaded up front
+	bool			loaded;
+	/// Keep symbols to write the cache
+	bool			keep;
+	/// All types are parsed
+	bool			types_ready;
+	/// Parser thread is done
+	bool			parse_done;
+	/// Parser result
+	bool			parse_ok;
+	/// Queued symbols are discarded
+	bool			aborted;
+	/// PLC name added to the OPC list of each symbol
+	std::stringcase	plcname;
+	/// Name of cache file
+	std::string		cachename;
+	/// Cache key of tpy file
+	std::string		key;
+
+private:
+	/// Disable copy constructor
+	tpy_stream (const tpy_stream&);
+	/// Disable assignment operator
+	tpy_stream& operator= (const tpy_stream&);
 };
 
 /** @} */
@@ -91,6 +91,45 @@ const char* const xmlValue = "Value";
 /// Description
 const char* const xmlDesc = "Desc";
 
+/** Identifiers of the XML tags which are dispatched by the tpy parser.
+	Tag names are mapped once per callback and then compared as integers.
+ ************************************************************************/
+enum xml_tag {
+	/// Tag which is not handled by the parser
+	xmlTagUnknown = 0,
+	xmlTagPlcProjectInfo,	///< PlcProjectInfo
+	xmlTagRoutingInfo,		///< RoutingInfo
+	xmlTagCompilerInfo,		///< CompilerInfo
+	xmlTagAdsInfo,			///< AdsInfo
+	xmlTagDataTypes,		///< DataTypes
+	xmlTagDataType,			///< DataType
+	xmlTagSymbols,			///< Symbols
+	xmlTagSymbol,			///< Symbol
+	xmlTagProperties,		///< Properties
+	xmlTagProperty,			///< Property
+	xmlTagCompilerVersion,	///< CompilerVersion
+	xmlTagTwinCATVersion,	///< TwinCATVersion
+	xmlTagCpuFamily,		///< CpuFamily
+	xmlTagNetId,			///< NetId
+	xmlTagPort,				///< Port
+	xmlTagTargetName,		///< TargetName
+	xmlTagName,				///< Name
+	xmlTagType,				///< Type
+	xmlTagIGroup,			///< IGroup
+	xmlTagIOffset,			///< IOffset
+	xmlTagBitSize,			///< BitSize
+	xmlTagBitOffs,			///< BitOffs
+	xmlTagArrayInfo,		///< ArrayInfo
+	xmlTagArrayLBound,		///< LBound
+	xmlTagArrayElements,	///< Elements
+	xmlTagSubItem,			///< SubItem
+	xmlTagFbInfo,			///< FbInfo
+	xmlTagEnumInfo,			///< EnumInfo
+	xmlTagEnumText,			///< Text
+	xmlTagEnumEnum,			///< Enum
+	xmlTagEnumComment,		///< Comment
+	xmlTagValue				///< Value
+};
 
 /// OPC
 const char* const opcExport = "opc";
@@ -100,4 +139,32 @@ const char* const opcProp = "opc_prop";
 const char* const opcBracket = "[";
 /** @} */
 
+/** @defgroup parsetpyconstupload  ADS symbol upload constants
+ ************************************************************************/
+/** @{ */
+
+/// File extension of a recorded ADS symbol upload
+const char* const adsUploadExt = ".upload";
+/// Symbol flag: size is in bits
+const unsigned int adsSymFlagBitValue = 0x0002;
+/// Symbol flag: reference
+const unsigned int adsSymFlagReference = 0x0004;
+/// Symbol flag: type GUID follows
+const unsigned int adsSymFlagTypeGuid = 0x0008;
+/// Symbol flag: attributes follow
+const unsigned int adsSymFlagAttributes = 0x1000;
+/// Data type flag: offset and size are in bits
+const unsigned int adsTypeFlagBitValues = 0x0020;
+/// Data type flag: type GUID follows
+const unsigned int adsTypeFlagTypeGuid = 0x0080;
+/// Data type flag: copy mask follows
+const unsigned int adsTypeFlagCopyMask = 0x0200;
+/// Data type flag: method infos follow
+const unsigned int adsTypeFlagMethodInfos = 0x0800;
+/// Data type flag: attributes follow
+const unsigned int adsTypeFlagAttributes = 0x1000;
+/// Data type flag: enum infos follow
+const unsigned int adsTypeFlagEnumInfos = 0x2000;
+/** @} */
+
 }
\ No newline at end of file
@@ -132,6 +132,8 @@ int main (int argc, char *argv[])
 			"       -ps only output atomic types\n"
 			"       -pc only output structured types\n"
 			"       -ns suppress string variables\n"
+			"       -yc uses/updates a binary cache of the parsed tpy file\n"
+			"       -pt 'num' expands symbols with num threads\n"
 			"       -p 'prefix' Add a prefix to the variable name\n"
 			"       -i 'tpyfile' input file name (stdin when omitted)\n"
 		    "       -o 'outfile' output listing (stdout when omitted)\n");
@@ -159,7 +161,8 @@ int main (int argc, char *argv[])
 
 	// parse tpy file
 	clock_t t1 = clock();
-	if (!tpyfile.parse (inpf)) {
+	if (!(inpf == stdin ? tpyfile.parse (inpf) : 
+		tpyfile.parse_file (inpfilename.c_str()))) {
 		fprintf (stderr, "Unable to parse %s\n", inpfilename.c_str());
 		return 1;
 	}
@@ -9,17 +9,256 @@ namespace ParseTpy {
 	int tpy_file::process_symbols (Function& process, 
 		const std::stringcase& prefix) const
 	{
+		if (!get_filter().empty()) {
+			filtered_process<Function> filtered (process, get_filter());
+			return process_symbol_list (filtered, prefix);
+		}
+		return process_symbol_list (process, prefix);
+	}
+
+/* tpy_file::process_symbol_list
+ ************************************************************************/
+	template <class Function>
+	int tpy_file::process_symbol_list (Function& process, 
+		const std::stringcase& prefix) const
+	{
+		if (get_process_threads() > 1) {
+			return process_symbols_parallel (process, prefix);
+		}
 		int num = 0;
 		for (symbol_list::const_iterator sym = get_symbols().begin();
 			sym != get_symbols().end(); ++sym, ++num) {
-			if (get_export_all() || 
-				(sym->get_opc().get_opc_state() == publish)) {
+			if (select_symbol (*sym)) {
 				int ret = process_type_tree (*sym, process, prefix);
 				num += ret;
 			}
 		}
 		return num;
 	}
+
+/* tpy_stream::process
+ ************************************************************************/
+	template <class Function>
+	int tpy_stream::process (Function& process, 
+		const std::stringcase& prefix)
+	{
+		if (loaded) {
+			return parse_ok ? tpy.process_symbols (process, prefix) : 0;
+		}
+		if (!tpy.get_filter().empty()) {
+			filtered_process<Function> filtered (process, tpy.get_filter());
+			return process_queue (filtered, prefix);
+		}
+		return process_queue (process, prefix);
+	}
+
+/* tpy_stream::process_queue
+ ************************************************************************/
+	template <class Function>
+	int tpy_stream::process_queue (Function& process, 
+		const std::stringcase& prefix)
+	{
+		int num = 0;
+		symbol_record sym;
+		while (pop (sym)) {
+			if (tpy.select_symbol (sym)) {
+				num += tpy.process_type_tree (sym, process, prefix);
+			}
+			++num;
+		}
+		return num;
+	}
+
+/* tpy_file::process_symbols_parallel
+ ************************************************************************/
+	template <class Function>
+	int tpy_file::process_symbols_parallel (Function& process, 
+		const std::stringcase& prefix) const
+	{
+		// Symbols per batch and number of batches ahead of the consumer
+		const size_t chunk = 64;
+		const size_t window = 4 * (size_t)get_process_threads();
+
+		std::vector<const symbol_record*> syms;
+		syms.reserve (get_symbols().size());
+		for (const symbol_record& sym : get_symbols()) {
+			syms.push_back (&sym);
+		}
+		const size_t chunks = (syms.size() + chunk - 1) / chunk;
+		std::vector<process_batch> batches (chunks);
+		std::vector<bool> ready (chunks, false);
+		size_t next = 0;
+		size_t consumed = 0;
+		std::mutex mux;
+		std::condition_variable cv;
+		std::exception_ptr error;
+
+		// Worker: expands a chunk of symbols into its batch
+		auto worker = [&] () {
+			try {
+				for (;;) {
+					size_t c;
+					{
+						std::unique_lock<std::mutex> lock (mux);
+						cv.wait (lock, [&] () { 
+							return (next >= chunks) || (next < consumed + window); });
+						if (next >= chunks) return;
+						c = next++;
+					}
+					process_batch& batch = batches[c];
+					size_t end = (c + 1) * chunk < syms.size() ? 
+						(c + 1) * chunk : syms.size();
+					for (size_t i = c * chunk; i < end; ++i, ++batch.num) {
+						if (select_symbol (*syms[i])) {
+							batch.num += process_type_tree (*syms[i], batch, prefix);
+						}
+					}
+					{
+						std::lock_guard<std::mutex> lock (mux);
+						ready[c] = true;
+					}
+					cv.notify_all();
+				}
+			}
+			catch (...) {
+				// keep the first exception and stop the other workers
+				{
+					std::lock_guard<std::mutex> lock (mux);
+					if (!error) error = std::current_exception();
+					next = chunks;
+				}
+				cv.notify_all();
+			}
+		};
+
+		// Stops and joins the workers, also when an exception is thrown
+		struct worker_guard {
+			std::vector<std::thread>& threads;
+			std::mutex& mux;
+			std::condition_variable& cv;
+			size_t& next;
+			size_t chunks;
+			~worker_guard() {
+				{
+					std::lock_guard<std::mutex> lock (mux);
+					next = chunks;
+				}
+				cv.notify_all();
+				for (std::thread& t : threads) {
+					if (t.joinable()) t.join();
+				}
+			}
+		};
+
+		int num = 0;
+		{
+			std::vector<std::thread> workers;
+			worker_guard guard = { workers, mux, cv, next, chunks };
+			for (int i = 0; i < get_process_threads(); ++i) {
+				workers.push_back (std::thread (worker));
+			}
+
+			// Consumer: replay batches in symbol order
+			for (size_t c = 0; c < chunks; ++c) {
+				{
+					std::unique_lock<std::mutex> lock (mux);
+					cv.wait (lock, [&] () { return ready[c] || error; });
+					if (error) break;
+				}
+				num += batches[c].num - batches[c].replay (process);
+				batches[c] = process_batch();
+				{
+					std::lock_guard<std::mutex> lock (mux);
+					++consumed;
+				}
+				cv.notify_all();
+			}
+		}
+		// all workers are joined, pass on the exception of a worker
+		if (error) {
+			std::rethrow_exception (error);
+		}
+		return num;
+	}
+
+/* tpy_file::process_layout
+ ************************************************************************/
+	template <class Function>
+	bool tpy_file::process_layout (const type_record& typ, 
+		const ParseUtil::opc_list& defopc, const ParseUtil::memory_location& loc, 
+		Function& process, ParseUtil::variable_name& varname, 
+		int level, int& num) const
+	{
+		if (!loc.isValid()) {
+			return false;
+		}
+		std::shared_ptr<type_layout> layout;
+		{
+			std::lock_guard<std::mutex> lock (layout_mux);
+			std::shared_ptr<type_layout>& slot = layout_list[&typ];
+			if (!slot || !slot->matches (defopc, loc, level, 
+				get_process_tags(), get_no_strings())) {
+				// first instance: remember it and process normally
+				slot = std::make_shared<type_layout> (defopc, loc, level,
+					get_process_tags(), get_no_strings());
+				return false;
+			}
+			layout = slot;
+		}
+		// replay
+		if (layout->built) {
+			num = layout->size() - layout->replay (process, loc, varname);
+			return true;
+		}
+		// second instance: record
+		auto forward = [] (void* ctx, const ParseUtil::process_arg_tc& arg) -> bool {
+			return (*(Function*)ctx) (arg); };
+		std::shared_ptr<type_layout> rec = std::make_shared<type_layout> (
+			defopc, loc, level, get_process_tags(), get_no_strings());
+		layout_recorder recorder (*rec, loc, varname, forward, &process);
+		num = process_type_tree (typ, defopc, loc, recorder, varname, level);
+		rec->built = true;
+		{
+			std::lock_guard<std::mutex> lock (layout_mux);
+			layout_list[&typ] = rec;
+		}
+		return true;
+	}
+
+/* type_layout::replay
+ ************************************************************************/
+	template <class Function>
+	int type_layout::replay (Function& process, 
+		const ParseUtil::memory_location& loc,
+		ParseUtil::variable_name& prefix) const
+	{
+		int fail = 0;
+		ParseUtil::variable_name::mark_type m = prefix.mark();
+		for (const entry& e : list) {
+			ParseUtil::memory_location el (loc.get_igroup(), 
+				loc.get_ioffset() + e.offset, e.bytesize);
+			prefix.append (e.suffix);
+			ParseUtil::process_arg_tc arg (el, prefix, e.ptype, e.opc, 
+				e.type_n, e.atomic);
+			if (!process (arg)) ++fail;
+			prefix.restore (m);
+		}
+		return fail;
+	}
+
+/* process_batch::replay
+ ************************************************************************/
+	template <class Function>
+	int process_batch::replay (Function& process) const
+	{
+		int fail = 0;
+		for (const entry& e : list) {
+			ParseUtil::process_arg_tc arg (e.loc, e.name, e.ptype, e.opc, 
+				e.type_n, e.atomic);
+			if (!process (arg)) ++fail;
+		}
+		return fail;
+	}
 	
 /* tpy_file::process_type_tree
  ************************************************************************/
@@ -56,12 +295,22 @@ namespace ParseTpy {
 	template <class Function>
 	int tpy_file::process_type_tree (const type_record& typ, 
 		ParseUtil::opc_list defopc, const ParseUtil::memory_location& loc, 
-		Function& process, const ParseUtil::variable_name& varname, 
+		Function& process, ParseUtil::variable_name& varname, 
 		int level) const
 	{
 		// Check recursive level
 		if (level > 100) return 0;
 
+		// Use the flattened layout of repeated structures
+		if (((typ.get_type_description() == structtype) ||
+			 (typ.get_type_description() == functionblock)) &&
+			!std::is_same<Function, layout_recorder>::value) {
+			int num = 0;
+			if (process_layout (typ, defopc, loc, process, varname, level, num)) {
+				return num;
+			}
+		}
+
 		// need to make sure that we don't add opc definitions when the array type was
 		// implicitly defined through a declaration of form A : ARRAY[n...m] OF ...
 		// multiple implicit array types of the same index range and base type will
@@ -107,8 +356,8 @@ namespace ParseTpy {
 				if (!withinhex) {
 					// add HOPR/LOPR
 					if (max >= min) {
-						defopc.get_properties().insert (property_el (102, std::to_string (max).c_str()));
-						defopc.get_properties().insert (property_el (103, std::to_string (min).c_str()));
+						defopc.add (property_el (102, std::to_string (max).c_str()));
+						defopc.add (property_el (103, std::to_string (min).c_str()));
 					}
 					process_arg_tc arg (loc, varname, pt_int, defopc, typ.get_type_name(), true);
 					return process (arg) ? 1 : 0;
@@ -118,8 +367,7 @@ namespace ParseTpy {
  					// add opc property for enum values
 					for (enum_map::const_iterator e = typ.get_enum_list().begin(); 
 						e != typ.get_enum_list().end(); ++e) {
-							defopc.get_properties().insert (
-								property_el (8510 + e->first, e->second));
+							defopc.add (property_el (8510 + e->first, e->second));
 					}
 					process_arg_tc arg (loc, varname, pt_enum, defopc, typ.get_type_name(), true);
 					return process (arg) ? 1 : 0;
@@ -144,12 +392,13 @@ namespace ParseTpy {
 						continue;
 					}
 					// Add a dot to the variable name
-					ParseUtil::variable_name n (varname);
-					n.append (i->get_name(), i->get_opc(), "."); 
+					ParseUtil::variable_name::mark_type m = varname.mark();
+					varname.append (i->get_name(), i->get_opc(), "."); 
 					opc_list o (defopc);
 					o.add (i->get_opc());
 					num += process_type_tree (i->get_type_name(), 
-						i->get_type_decoration(), o, el_loc, process, n, level + 1);
+						i->get_type_decoration(), o, el_loc, process, varname, level + 1);
+					varname.restore (m);
 				}
 				return num; 
 			}
@@ -164,7 +413,7 @@ namespace ParseTpy {
 	template <class Function>
 	int tpy_file::process_type_tree (const std::stringcase& typ, unsigned int id,
 		const ParseUtil::opc_list& defopc, const ParseUtil::memory_location& loc, 
-		Function& process, const ParseUtil::variable_name& varname, int level) const
+		Function& process, ParseUtil::variable_name& varname, int level) const
 	{
 		const type_record* t = nullptr;
 
@@ -217,7 +466,7 @@ namespace ParseTpy {
 	template <class Function>
 	int tpy_file::process_array (const type_record& typ, dimensions dim, 
 		const ParseUtil::opc_list& defopc, const ParseUtil::memory_location& loc, 
-		Function& process, const ParseUtil::variable_name& varname, int level) const
+		Function& process, ParseUtil::variable_name& varname, int level) const
 	{
 		// This is an array where all dimensions have been processed
 		if (dim.empty()) {
@@ -270,9 +519,10 @@ namespace ParseTpy {
 				}
 				char buf[40];
 				sprintf_s (buf, sizeof (buf), "[%i]", i);
-				ParseUtil::variable_name narr (varname);
-				narr.append (buf, "");
-				num += process_array (ntyp, dim, defopc, el_loc, process, narr, level);
+				ParseUtil::variable_name::mark_type m = varname.mark();
+				varname.append (buf, "");
+				num += process_array (ntyp, dim, defopc, el_loc, process, varname, level);
+				varname.restore (m);
 			}
 			return num;
 		}
@@ -18,6 +18,10 @@ const char* const replacement_rules::suffix = "}";
 	************************************************************************/
 std::stringcase replacement_rules::apply_replacement_rules(const std::stringcase& arg) const
 {
+	// most names contain no variables: return after a single scan
+	if (arg.find(prefix) == stringcase::npos) {
+		return arg;
+	}
 	stringcase ret(arg);
 	stringcase var;
 	stringcase val;
@@ -124,6 +128,37 @@ void optarg::setup (int size)
 
 
 
+/* OPC list members: detach
+ ************************************************************************/
+ void opc_list::detach() 
+ {
+	 if (!opc_prop) {
+		 opc_prop = std::make_shared<property_map>();
+	 }
+	 else if (opc_prop.use_count() > 1) {
+		 opc_prop = std::make_shared<property_map> (*opc_prop);
+	 }
+ }
+
+/* OPC list members: empty_properties
+ ************************************************************************/
+ const property_map& opc_list::empty_properties() 
+ {
+	 static const property_map empty;
+	 return empty;
+ }
+
+/* OPC list members: add
+ ************************************************************************/
+ void opc_list::add (const property_el& el) 
+ {
+	 // insert does not override, so only copy when the key is new
+	 if (get_properties().find (el.first) == get_properties().end()) {
+		 detach();
+		 opc_prop->insert (el);
+	 }
+ }
+
 /* OPC list members: add
  ************************************************************************/
  void opc_list::add (const opc_list& o) 
@@ -131,9 +166,18 @@ void optarg::setup (int size)
 	 if (o.opc != no_change) {
 		 opc = o.opc;
 	 }
-	 for (property_map::const_iterator i = o.opc_prop.begin();
-		 i != o.opc_prop.end(); ++i) {
-			 opc_prop[i->first] = i->second;
+	 if (!o.opc_prop || o.opc_prop->empty() || (o.opc_prop == opc_prop)) {
+		 return;
+	 }
+	 // share the other list when there is nothing to merge with
+	 if (!opc_prop || opc_prop->empty()) {
+		 opc_prop = o.opc_prop;
+		 return;
+	 }
+	 detach();
+	 for (property_map::const_iterator i = o.opc_prop->begin();
+		 i != o.opc_prop->end(); ++i) {
+			 (*opc_prop)[i->first] = i->second;
 	 }
  }
  
@@ -168,8 +212,11 @@ void optarg::setup (int size)
  ************************************************************************/
 bool opc_list::get_property (int prop, std::stringcase& val) const
 {
-	property_map::const_iterator i = opc_prop.find (prop);
-	if (i == opc_prop.end()) {
+	if (!opc_prop) {
+		return false;
+	}
+	property_map::const_iterator i = opc_prop->find (prop);
+	if (i == opc_prop->end()) {
 		return false;
 	}
 	val = i->second;
@@ -334,6 +381,131 @@ std::stringcase process_arg_tc::get_full () const
 }
 
 
+/* pattern_trie::add
+ ************************************************************************/
+void pattern_trie::add (const std::stringcase& pattern)
+{
+	int n = 0;
+	for (const char* p = pattern.c_str(); *p; ++p) {
+		int next;
+		if (*p == '*') {
+			if (nodes[n].loop) continue;
+			next = nodes[n].star;
+		}
+		else if (*p == '?') {
+			next = nodes[n].any;
+		}
+		else {
+			auto i = nodes[n].next.find ((char)tolower ((unsigned char)*p));
+			next = (i == nodes[n].next.end()) ? -1 : i->second;
+		}
+		if (next < 0) {
+			next = (int)nodes.size();
+			nodes.push_back (trie_node());
+			if (*p == '*') {
+				nodes[next].loop = true;
+				nodes[n].star = next;
+			}
+			else if (*p == '?') {
+				nodes[n].any = next;
+			}
+			else {
+				nodes[n].next[(char)tolower ((unsigned char)*p)] = next;
+			}
+		}
+		n = next;
+	}
+	if (!nodes[n].end) {
+		nodes[n].end = true;
+		++num;
+	}
+}
+
+/* pattern_trie::activate
+ ************************************************************************/
+void pattern_trie::activate (std::vector<int>& act, int n) const
+{
+	while (n >= 0) {
+		for (int a : act) {
+			if (a == n) return;
+		}
+		act.push_back (n);
+		n = nodes[n].star;
+	}
+}
+
+/* pattern_trie::match
+ ************************************************************************/
+bool pattern_trie::match (const std::stringcase& name, bool below) const
+{
+	if (num == 0) {
+		return false;
+	}
+	std::vector<int> act;
+	std::vector<int> next;
+	activate (act, 0);
+	for (const char* p = name.c_str(); *p; ++p) {
+		// a parent structure or array matches
+		if ((*p == '.') || (*p == '[')) {
+			for (int a : act) {
+				if (nodes[a].end) return true;
+			}
+		}
+		next.clear();
+		char c = (char)tolower ((unsigned char)*p);
+		for (int a : act) {
+			const trie_node& node = nodes[a];
+			auto i = node.next.find (c);
+			if (i != node.next.end()) activate (next, i->second);
+			if (node.any >= 0) activate (next, node.any);
+			if (node.loop) activate (next, a);
+		}
+		if (next.empty()) {
+			return false;
+		}
+		act.swap (next);
+	}
+	for (int a : act) {
+		const trie_node& node = nodes[a];
+		if (node.end) return true;
+		// an element below the name could still match
+		if (below && (node.loop || (node.any >= 0) || 
+			(node.next.find ('.') != node.next.end()) || 
+			(node.next.find ('[') != node.next.end()))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* name_filter::add_file
+ ************************************************************************/
+bool name_filter::add_file (const char* filename)
+{
+	FILE* inp = filename ? fopen (filename, "r") : NULL;
+	if (!inp) {
+		return false;
+	}
+	char buf[1024];
+	while (fgets (buf, sizeof (buf), inp)) {
+		std::stringcase line (buf);
+		trim_space (line);
+		if (line.empty() || (line[0] == '#')) {
+			continue;
+		}
+		if (line[0] == '!') {
+			line.erase (0, 1);
+			trim_space (line);
+			if (!line.empty()) add_exclude (line);
+		}
+		else {
+			add_include (line);
+		}
+	}
+	fclose (inp);
+	return true;
+}
+
 /* tag_processing::getopt
  ************************************************************************/
 int tag_processing::getopt (int argc, const char* const argv[], bool argp[])
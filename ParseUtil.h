@@ -138,7 +138,9 @@ typedef std::map<int, std::stringcase> property_map;
  ************************************************************************/
 typedef std::pair<int, std::stringcase> property_el;
 
-/** This class stores OPC properties.
+/** This class stores OPC properties. The property map is shared between
+	copies and only copied when a copy is modified, so that passing OPC 
+	lists down the type tree is cheap.
 	@brief OPC list
 ************************************************************************/
 class opc_list 
@@ -148,25 +150,31 @@ public:
 	opc_list() : opc (no_change) {}
 	/// Constructor
 	opc_list (opc_enum state, const property_map& map) 
-		: opc(state), opc_prop(map) {}
+		: opc(state), opc_prop (std::make_shared<property_map> (map)) {}
 
 	/// Get opc state
 	opc_enum get_opc_state () const { return opc; }
 	/// Set opc state 
 	void set_opc_state (opc_enum state) {opc = state; }
 	/// Get opc property list
-	const property_map& get_properties () const { return opc_prop; }
-	/// Get opc property list
-	property_map& get_properties () { return opc_prop; }
+	const property_map& get_properties () const { 
+		return opc_prop ? *opc_prop : empty_properties(); }
+	/// Get opc property list (for modification)
+	property_map& get_properties () { detach(); return *opc_prop; }
 	/// Get the specified property
 	const property_map::const_iterator get_property (int key) const {
-		return opc_prop.find (key); }
+		return get_properties().find (key); }
 
 	/// Add an OPC property
-	void add (const property_el& el) { opc_prop.insert (el); }
+	void add (const property_el& el);
 	/// Add an OPC list
 	void add (const opc_list& o);
 
+	/// Same state and properties
+	bool operator== (const opc_list& o) const {
+		return (opc == o.opc) && ((opc_prop == o.opc_prop) ||
+			(get_properties() == o.get_properties())); }
+
 	/// Is this item published?
 	bool is_published () const;
 	/// Is readonly?
@@ -179,10 +187,15 @@ public:
 	bool get_property (int prop, double& val) const;
 
 protected:
+	/// Make the property map private to this list before a modification
+	void detach();
+	/// Empty property map
+	static const property_map& empty_properties();
+
 	/// OPC state
 	opc_enum		opc;
-	/// List of OPC properties
-	property_map	opc_prop;
+	/// List of OPC properties (shared, null if empty)
+	std::shared_ptr<property_map> opc_prop;
 };
 
 
@@ -217,6 +230,18 @@ public:
 	/// Append
 	void append (const std::stringcase& n, const opc_list& opc, 
 		const std::stringcase& sep = ".");
+	/// Append name and alias of another variable
+	void append (const variable_name& v) {
+		name += v.name; alias += v.alias; }
+
+	/// Lengths of name and alias
+	typedef std::pair<std::stringcase::size_type, 
+		std::stringcase::size_type> mark_type;
+	/// Get the current lengths, so that appended segments can be removed
+	mark_type mark() const { return mark_type (name.size(), alias.size()); }
+	/// Remove all segments which were appended after the mark
+	void restore (const mark_type& m) { 
+		name.resize (m.first); alias.resize (m.second); }
 
 protected:
 	/// variable name
@@ -425,6 +450,97 @@ protected:
 	const memory_location&	memloc;
 };
 
+/** This class stores a set of name patterns in a trie. A pattern can use
+	'*' for any sequence and '?' for any single character. Patterns also 
+	match all elements below a matching structure or array. Names are 
+	matched by a single walk through the trie and case insensitive.
+	@brief Pattern trie
+************************************************************************/
+class pattern_trie
+{
+public:
+	/// Default constructor
+	pattern_trie() : nodes (1), num (0) {}
+
+	/// Check if there are any patterns
+	bool empty() const { return num == 0; }
+	/// Remove all patterns
+	void clear() { nodes.assign (1, trie_node()); num = 0; }
+	/// Add a pattern
+	void add (const std::stringcase& pattern);
+	/// Check if a name or one of its parents matches a pattern
+	/// @param name Variable name
+	/// @param below Also true, if names below the variable can match
+	/// @return True if matched
+	bool match (const std::stringcase& name, bool below = false) const;
+
+protected:
+	/// Trie node
+	struct trie_node {
+		/// Constructor
+		trie_node() : any (-1), star (-1), loop (false), end (false) {}
+		/// Next node by (lower case) character
+		std::map<char, int>	next;
+		/// Next node for '?'
+		int				any;
+		/// Next node for '*'
+		int				star;
+		/// Node stays active for any character ('*' node)
+		bool			loop;
+		/// A pattern ends at this node
+		bool			end;
+	};
+	/// Add a node and its '*' successors to a list of active nodes
+	void activate (std::vector<int>& act, int n) const;
+
+	/// List of nodes, the first one is the root
+	std::vector<trie_node>	nodes;
+	/// Number of patterns
+	int				num;
+};
+
+/** This class selects variables by include and exclude patterns. 
+	Without include patterns all variables which are not excluded are 
+	selected.
+	@brief Name filter
+************************************************************************/
+class name_filter
+{
+public:
+	/// Default constructor
+	name_filter() {}
+
+	/// Check if there are any patterns
+	bool empty() const { return include.empty() && exclude.empty(); }
+	/// Remove all patterns
+	void clear() { include.clear(); exclude.clear(); }
+	/// Add an include pattern
+	void add_include (const std::stringcase& pattern) { include.add (pattern); }
+	/// Add an exclude pattern
+	void add_exclude (const std::stringcase& pattern) { exclude.add (pattern); }
+	/// Add the patterns of a file, one name or pattern per line
+	/// Empty lines and lines starting with '#' are ignored, 
+	/// lines starting with '!' are exclude patterns
+	/// @param filename Name of file
+	/// @return True if successful
+	bool add_file (const char* filename);
+
+	/// Check if a variable is selected
+	bool select (const std::stringcase& name) const {
+		return !exclude.match (name) && 
+			(include.empty() || include.match (name)); }
+	/// Check if a symbol or any variable below it can be selected
+	bool select_symbol (const std::stringcase& name) const {
+		return !exclude.match (name) && 
+			(include.empty() || include.match (name, true)); }
+
+protected:
+	/// Include patterns
+	pattern_trie	include;
+	/// Exclude patterns
+	pattern_trie	exclude;
+};
+
 /** Enumerated type to describe the tag processing
 	@brief Tag preoicessing enum
 ************************************************************************/
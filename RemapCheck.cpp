@@ -0,0 +1,72 @@
+#include "stdafx.h"
+#include "tcComms.h"
+
+using namespace std;
+using namespace TcComms;
+
+/** @file RemapCheck.cpp
+	Source for the check of remapping records to a reloaded tpy file
+ ************************************************************************/
+
+/** Number of mismatches
+ ************************************************************************/
+static int errors = 0;
+
+/** Remaps a symbol and compares the result and the new address
+	@param symbols TCat symbols of the reloaded tpy file
+	@param name Name of the TCat symbol
+	@param type Data type of the TCat symbol
+	@param addr Address of the TCat symbol before the reload
+	@param result Expected result
+	@param expected Expected address after the remap
+ ************************************************************************/
+static void check (const tc_symbol_map& symbols, const char* name,
+				   const char* type, DataPar addr, tc_remap_enum result,
+				   DataPar expected)
+{
+	tc_remap_enum ret = tc_remap_symbol (symbols, name, type, addr);
+	if ((ret != result) ||
+		((ret != tc_remap_enum::removed) && !(addr == expected))) {
+		fprintf (stderr, "Mismatch for %s: result %i, address %lu/%lu:%lu\n",
+			name, (int)ret, addr.indexGroup, addr.indexOffset, addr.length);
+		++errors;
+	}
+}
+
+/** Main program
+ ************************************************************************/
+int main (int argc, char *argv[])
+{
+	// symbols of the reloaded tpy file
+	tc_symbol_map symbols;
+	symbols["MAIN.nSame"] = { { 16448, 0, 2 }, "INT" };
+	symbols["MAIN.fMoved"] = { { 16448, 16, 8 }, "LREAL" };
+	symbols["GVL.bMoved"] = { { 16416, 4, 1 }, "BOOL" };
+	symbols["MAIN.sResized"] = { { 16448, 24, 41 }, "STRING(40)" };
+	symbols["MAIN.nRetyped"] = { { 16448, 68, 4 }, "DINT" };
+
+	// unchanged
+	check (symbols, "MAIN.nSame", "INT", { 16448, 0, 2 },
+		tc_remap_enum::unchanged, { 16448, 0, 2 });
+	// names compare case insensitive
+	check (symbols, "main.nsame", "int", { 16448, 0, 2 },
+		tc_remap_enum::unchanged, { 16448, 0, 2 });
+	// moved offset
+	check (symbols, "MAIN.fMoved", "LREAL", { 16448, 8, 8 },
+		tc_remap_enum::moved, { 16448, 16, 8 });
+	// moved group and offset
+	check (symbols, "GVL.bMoved", "BOOL", { 16448, 4, 1 },
+		tc_remap_enum::moved, { 16416, 4, 1 });
+	// gone
+	check (symbols, "MAIN.nGone", "INT", { 16448, 2, 2 },
+		tc_remap_enum::removed, { 0, 0, 0 });
+	// changed size
+	check (symbols, "MAIN.sResized", "STRING(40)", { 16448, 24, 40 },
+		tc_remap_enum::removed, { 0, 0, 0 });
+	// changed type with the same size
+	check (symbols, "MAIN.nRetyped", "UDINT", { 16448, 68, 4 },
+		tc_remap_enum::removed, { 0, 0, 0 });
+
+	printf ("Mismatches                        = %9d\n", errors);
+	return errors ? 2 : 0;
+}
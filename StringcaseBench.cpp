@@ -0,0 +1,185 @@
+#include "stdafx.h"
+#include <chrono>
+
+using namespace std;
+
+#pragma warning (disable: 4996)
+
+/** @file StringcaseBench.cpp
+	Source for the benchmark of the case insensitive string functions
+ ************************************************************************/
+
+/** Reference compare, case folding one character at a time
+	@param s1 first string
+	@param s2 second string
+	@param n Number of characters
+	@return <0 smaller, 0 equal, >0 greater
+ ************************************************************************/
+static int reference_compare (const char* s1, const char* s2, size_t n)
+{
+	for (size_t i = 0; i < n; ++i) {
+		int d = tolower ((unsigned char)s1[i]) - tolower ((unsigned char)s2[i]);
+		if (d) return d;
+	}
+	return 0;
+}
+
+/** Sign of a compare result
+ ************************************************************************/
+static int sign (int d)
+{
+	return (d > 0) - (d < 0);
+}
+
+/** Generates symbol like names with mixed case
+	@param names List of names (output)
+	@param num Number of names
+ ************************************************************************/
+static void make_names (vector<stringcase>& names, int num)
+{
+	static const char* const parts[] = {
+		"MAIN", "Axis", "Status", "bEnable", "fPosition", "Ctrl",
+		"GVL_Io", "Temperature", "nErrorId", "Raw", "sName", "Valve" };
+	const int nparts = sizeof (parts) / sizeof (parts[0]);
+	unsigned int seed = 12345;
+	char buf[256];
+	names.reserve (num);
+	for (int i = 0; i < num; ++i) {
+		seed = seed * 1103515245 + 12345;
+		sprintf (buf, "%s.%s[%d].%s.%s_%d", parts[(seed >> 8) % nparts],
+			parts[(seed >> 12) % nparts], i % 64,
+			parts[(seed >> 16) % nparts], parts[(seed >> 20) % nparts], i);
+		names.push_back (buf);
+	}
+}
+
+/** Flips the case of every letter of a name
+ ************************************************************************/
+static stringcase flip_case (const stringcase& s)
+{
+	stringcase ret (s);
+	for (auto& c : ret) {
+		c = isupper ((unsigned char)c) ? (char)tolower ((unsigned char)c) :
+			(char)toupper ((unsigned char)c);
+	}
+	return ret;
+}
+
+/** Returns the time in nanoseconds per operation
+ ************************************************************************/
+static double ns_per_op (chrono::steady_clock::time_point start,
+						 size_t ops)
+{
+	double ns = chrono::duration<double, nano>
+		(chrono::steady_clock::now() - start).count();
+	return ops ? ns / ops : 0.0;
+}
+
+/** Main program
+ ************************************************************************/
+int main (int argc, char *argv[])
+{
+	int num = 200000;
+	int repeat = 5;
+	bool help = false;
+	for (int i = 1; i < argc; ++i) {
+		stringcase arg (argv[i]);
+		if ((arg == "-n" || arg == "/n") && i + 1 < argc) {
+			num = atoi (argv[++i]);
+		}
+		else if ((arg == "-r" || arg == "/r") && i + 1 < argc) {
+			repeat = atoi (argv[++i]);
+		}
+		else {
+			help = true;
+		}
+	}
+	if (help || (num <= 0) || (repeat <= 0)) {
+		printf ("Usage: StringcaseBench [-n 'names'] [-r 'repeat']\n"
+			"       Benchmarks compare, find and hash of case insensitive strings\n"
+			"       -n 'names' Number of symbol names (default 200000)\n"
+			"       -r 'repeat' Number of passes over all names (default 5)\n");
+		return 1;
+	}
+	vector<stringcase> names;
+	make_names (names, num);
+	vector<stringcase> flipped;
+	flipped.reserve (names.size());
+	for (const auto& s : names) {
+		flipped.push_back (flip_case (s));
+	}
+
+	// check compare and hash against the reference
+	int errors = 0;
+	hash<stringcase> hasher;
+	for (size_t i = 0; i < names.size(); ++i) {
+		const stringcase& a = names[i];
+		const stringcase& b = names[(i * 7919) % names.size()];
+		size_t n = (a.size() < b.size() ? a.size() : b.size());
+		if (sign (case_fold_compare (a.data(), b.data(), n)) !=
+			sign (reference_compare (a.data(), b.data(), n)) ||
+			(a != flipped[i]) || (hasher (a) != hasher (flipped[i]))) {
+			if (errors++ < 10) {
+				fprintf (stderr, "Mismatch for %s and %s\n", a.c_str(), b.c_str());
+			}
+		}
+	}
+	// find matches the first character case sensitively, so that
+	// the generated DTYP and properties stay unchanged
+	if ((stringcase ("RAW").find ("raw") != stringcase::npos) ||
+		(stringcase ("Raw").find ("rAW") != stringcase::npos) ||
+		(stringcase ("raw").find ("rAW") != 0)) {
+		fprintf (stderr, "Mismatch for find of raw\n");
+		++errors;
+	}
+
+	// compare: ordered map lookups with flipped case
+	size_t found = 0;
+	auto start = chrono::steady_clock::now();
+	map<stringcase, int> ordered;
+	for (int i = 0; i < num; ++i) {
+		ordered[names[i]] = i;
+	}
+	for (int r = 0; r < repeat; ++r) {
+		for (const auto& s : flipped) {
+			found += ordered.count (s);
+		}
+	}
+	double tcompare = ns_per_op (start, (size_t)num * (repeat + 1));
+
+	// find: substring search as done when parsing properties
+	size_t pos = 0;
+	start = chrono::steady_clock::now();
+	for (int r = 0; r < repeat; ++r) {
+		for (const auto& s : names) {
+			size_t p = s.find ("status");
+			if (p != stringcase::npos) pos += p;
+			p = s.find ('[');
+			if (p != stringcase::npos) pos += p;
+		}
+	}
+	double tfind = ns_per_op (start, (size_t)num * repeat);
+
+	// hash: unordered map lookups with flipped case
+	start = chrono::steady_clock::now();
+	unordered_map<stringcase, int> unordered;
+	for (int i = 0; i < num; ++i) {
+		unordered[names[i]] = i;
+	}
+	for (int r = 0; r < repeat; ++r) {
+		for (const auto& s : flipped) {
+			found += unordered.count (s);
+		}
+	}
+	double thash = ns_per_op (start, (size_t)num * (repeat + 1));
+
+	printf ("Names                             = %9d\n", num);
+	printf ("Passes                            = %9d\n", repeat);
+	printf ("Map insert/lookup (compare)       = %9.1f ns\n", tcompare);
+	printf ("Substring and character find      = %9.1f ns\n", tfind);
+	printf ("Hash map insert/lookup (hash)     = %9.1f ns\n", thash);
+	printf ("Lookups found                     = %9llu\n", (unsigned long long)found);
+	printf ("Find checksum                     = %9llu\n", (unsigned long long)pos);
+	printf ("Mismatches                        = %9d\n", errors);
+	return errors ? 2 : 0;
+}
@@ -5,6 +5,7 @@
 #include "TpyToEpicsConst.h"
 #include "TpyToEpics.h"
 #include <filesystem>
+#include <cstdarg>
 
 using namespace std;
 using namespace std::experimental::filesystem::v1; 
@@ -107,93 +108,85 @@ int epics_conversion::getopt (int argc, const char* const argv[], bool argp[])
  ************************************************************************/
 string epics_conversion::to_epics (const stringcase& name) const
 {
-	stringcase n (name);
-	stringcase::size_type pos;
-
 	// apply replacement rules
+	const stringcase* pn = &name;
+	stringcase replaced;
 	if (HasRules()) {
-		n = apply_replacement_rules (n);
+		replaced = apply_replacement_rules (name);
+		pn = &replaced;
 	}
+	const stringcase& n = *pn;
 
 	// eliminate leading dot
+	stringcase::size_type start = 0;
 	if (no_leading_dot || (conv_rule == ligo_std) || (conv_rule == ligo_vac)) {
-		std::stringcase::size_type pos;
 		if (!n.empty() && (n[0] == '.')) {
-			n.erase (0, 1);
+			start = 1;
 		}
 		// TwinCAT 3 doesn't use an empty name for globals
-		else if ((pos = n.find ('.')) != std::stringcase::npos) {
-			n.erase (0, pos + 1);
-		}
-	}
-
-	// apply conversion rules
-	switch (conv_rule) {
-		// ligo standard
-	case ligo_std:
-		// replace first dot with colon
-		pos = n.find ('.');
-		if (pos != stringcase::npos) {
-			n[pos] = ':';
-		}
-		// replace second dot with dash
-		pos = n.find ('.');
-		if (pos != stringcase::npos) {
-			n[pos] = '-';
+		else if ((start = n.find ('.')) != std::stringcase::npos) {
+			start += 1;
 		}
-		// replace remaining dots with underscore
-		while ((pos = n.find ('.')) != stringcase::npos) {
-			n[pos] = '_';
-		}
-		break;
-		// ligo standard
-	case ligo_vac:
-		// replace first underscore with colon
-		pos = n.find ('_');
-		if (pos != stringcase::npos) {
-			n[pos] = ':';
-		}
-		// replace second underscore with dash
-		pos = n.find ('_');
-		if (pos != stringcase::npos) {
-			n[pos] = '-';
-		}
-		// replace dots with underscore
-		while ((pos = n.find ('.')) != stringcase::npos) {
-			n[pos] = '_';
-		}
-		break;
-		// replace all dots with underscores
-	case no_dot:
-		while ((pos = n.find ('.')) != stringcase::npos) {
-			n[pos] = '_';
-		}
-		break;
-		// do nothing
-	case no_conversion:
-	default:
-		break;
-	}
-	// force case if necessary
-	if (case_epics_names != preserve_case) {
-		for (pos = 0; pos < n.size(); ++pos) {
-			n[pos] = (case_epics_names == upper_case) ? toupper (n[pos]) : tolower (n[pos]);
+		else {
+			start = 0;
+		}
+	}
+
+	// single pass over the name applying the conversion rules, 
+	// case conversion and array index rules in that order
+	string ret;
+	ret.reserve (get_prefix().size() + n.size() - start);
+	ret.append (get_prefix().c_str(), get_prefix().size());
+	int count = 0;
+	for (stringcase::size_type pos = start; pos < n.size(); ++pos) {
+		char c = n[pos];
+		switch (conv_rule) {
+			// ligo standard: first dot to colon, second dot to dash, 
+			// remaining dots to underscore
+		case ligo_std:
+			if (c == '.') {
+				c = (count == 0) ? ':' : ((count == 1) ? '-' : '_');
+				++count;
+			}
+			break;
+			// ligo vacuum: first underscore to colon, second underscore to 
+			// dash, dots to underscore
+		case ligo_vac:
+			if (c == '_') {
+				c = (count == 0) ? ':' : ((count == 1) ? '-' : '_');
+				++count;
+			}
+			else if (c == '.') {
+				c = '_';
+			}
+			break;
+			// replace all dots with underscores
+		case no_dot:
+			if (c == '.') {
+				c = '_';
+			}
+			break;
+			// do nothing
+		case no_conversion:
+		default:
+			break;
 		}
-	}
-	// replace array brackets with underscore if necessary
-	if (no_array_index) {
-		while ((pos = n.find ('[')) != stringcase::npos) {
-			n[pos] = '_';
+		// force case if necessary
+		if (case_epics_names != preserve_case) {
+			c = (case_epics_names == upper_case) ? toupper (c) : tolower (c);
 		}
-		while ((pos = n.find (']')) != stringcase::npos) {
-			n.erase (pos, 1);
+		// replace array brackets with underscore if necessary
+		if (no_array_index) {
+			if (c == '[') {
+				c = '_';
+			}
+			else if (c == ']') {
+				continue;
+			}
 		}
+		ret.push_back (c);
 	}
-	
-	// add prefix
-	n = get_prefix() + n;
-	
-	return string (n.c_str());
+	return ret;
 }
 
 
@@ -238,6 +231,7 @@ split_io_support& split_io_support::operator= (const split_io_support& iosup)
 	outf = iosup.outf;
 	outf_in = iosup.outf_in;
 	outf_io = iosup.outf_io;
+	filenames = iosup.filenames;
 	iosup.outf = nullptr;
 	iosup.outf_in = nullptr;
 	iosup.outf_io = nullptr;
@@ -314,7 +308,7 @@ void split_io_support::set_filename (const stringcase& fn)
 				file_io_s = ".io";
 			}
 			stringcase fname (outfilename + file_io_s + file_num_io_s + ".db");
-			outf_io = fopen (fname.c_str(), "w");
+			outf_io = open_output (fname);
 			if (!outf_io) {
 				fprintf (stderr, "Failed to open output %s.\n", fname.c_str());
 				error = true;
@@ -323,7 +317,7 @@ void split_io_support::set_filename (const stringcase& fn)
 			outf = outf_io;
 			if (split_io) {
 				fname = outfilename + file_in_s + file_num_in_s + ".db";
-				outf_in = fopen (fname.c_str(), "w");
+				outf_in = open_output (fname);
 				if (!outf_io) {
 					fprintf (stderr, "Failed to open output %s.\n", fname.c_str());
 					error = true;
@@ -332,7 +326,7 @@ void split_io_support::set_filename (const stringcase& fn)
 			}
 		}
 		else {
-			outf_io = fopen (outfilename.c_str(), "w");
+			outf_io = open_output (outfilename);
 			if (!outf_io) {
 				fprintf (stderr, "Failed to open output %s.\n", outfilename.c_str());
 				error = true;
@@ -353,6 +347,23 @@ void split_io_support::set_filename (const stringcase& fn)
 	}
 }
 
+/// Size of the stdio buffer of database and listing files
+static const size_t output_buffer_size = 1 << 20;
+
+/* Open an output file
+   split_io_support::open_output
+************************************************************************/
+FILE* split_io_support::open_output (const stringcase& fname)
+{
+	FILE* fp = fopen (fname.c_str(), "w");
+	if (fp) {
+		// large buffer, so that records are written in few calls
+		setvbuf (fp, nullptr, _IOFBF, output_buffer_size);
+		filenames.push_back (fname);
+	}
+	return fp;
+}
+
 /* Flush file content
    split_io_support::flush
 ************************************************************************/
@@ -389,7 +400,7 @@ bool split_io_support::increment (bool readonly)
 					file_num_in_s = buf;
 					fclose (outf_in);
 					stringcase fname = outfilename + file_in_s + file_num_in_s + ".db";
-					outf_in = fopen (fname.c_str(), "w");
+					outf_in = open_output (fname);
 					if (!outf_in) {
 						fprintf (stderr, "Failed to open output %s.\n", fname.c_str());
 						error = true;
@@ -404,7 +415,7 @@ bool split_io_support::increment (bool readonly)
 					file_num_io_s = buf;
 					fclose (outf_io);
 					stringcase fname (outfilename + file_io_s + file_num_io_s + ".db");
-					outf_io = fopen (fname.c_str(), "w");
+					outf_io = open_output (fname);
 					if (!outf_io) {
 						fprintf (stderr, "Failed to open output %s.\n", fname.c_str());
 						error = true;
@@ -421,7 +432,7 @@ bool split_io_support::increment (bool readonly)
 				file_num_io_s = buf;
 				fclose (outf_io);
 				stringcase fname (outfilename + file_io_s + file_num_io_s + ".db");
-				outf_io = fopen (fname.c_str(), "w");
+				outf_io = open_output (fname);
 				if (!outf_io) {
 					fprintf (stderr, "Failed to open output %s.\n", fname.c_str());
 					error = true;
@@ -447,6 +458,100 @@ bool split_io_support::increment (bool readonly)
 }
 
 
+/* Constructor
+   output_writer::output_writer
+************************************************************************/
+output_writer::output_writer (int threads)
+	: pending (0), done (false), errors (0)
+{
+	if (threads <= 0) {
+		threads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	if (threads <= 0) threads = 1;
+	if (threads > 8) threads = 8;
+	queues.resize (threads);
+	for (int i = 0; i < threads; ++i) {
+		workers.push_back (std::thread (&output_writer::run, this, (size_t)i));
+	}
+}
+
+/* Destructor
+   output_writer::~output_writer
+************************************************************************/
+output_writer::~output_writer()
+{
+	{
+		std::lock_guard<std::mutex> lock (mux);
+		done = true;
+	}
+	cond.notify_all();
+	for (auto& t : workers) {
+		if (t.joinable()) t.join();
+	}
+}
+
+/* Queue a file
+   output_writer::write
+************************************************************************/
+void output_writer::write (const stringcase& fname, std::string&& data)
+{
+	// same file name (ignoring case) always goes to the same thread
+	size_t h = 0;
+	for (auto c : fname) {
+		h = 31 * h + (unsigned char)tolower (c);
+	}
+	{
+		std::lock_guard<std::mutex> lock (mux);
+		queues[h % queues.size()].push_back (file_job (fname, std::move (data)));
+		++pending;
+	}
+	cond.notify_all();
+}
+
+/* Wait for all files
+   output_writer::wait
+************************************************************************/
+bool output_writer::wait()
+{
+	std::unique_lock<std::mutex> lock (mux);
+	idle.wait (lock, [this] { return pending == 0; });
+	return errors == 0;
+}
+
+/* Thread loop
+   output_writer::run
+************************************************************************/
+void output_writer::run (size_t idx)
+{
+	std::unique_lock<std::mutex> lock (mux);
+	while (true) {
+		cond.wait (lock, [this, idx] { return done || !queues[idx].empty(); });
+		if (queues[idx].empty()) {
+			return;
+		}
+		file_job job (std::move (queues[idx].front()));
+		queues[idx].pop_front();
+		lock.unlock();
+		FILE* fp = fopen (job.first.c_str(), "w");
+		if (!fp) {
+			fprintf (stderr, "Failed to open %s.\n", job.first.c_str());
+			++errors;
+		}
+		else {
+			if (fwrite (job.second.data(), 1, job.second.size(), fp) != 
+				job.second.size()) {
+				fprintf (stderr, "Failed to write %s.\n", job.first.c_str());
+				++errors;
+			}
+			fclose (fp);
+		}
+		lock.lock();
+		if (--pending == 0) {
+			idle.notify_all();
+		}
+	}
+}
+
 /* Open a file
    multi_io_support::operator
 ************************************************************************/
@@ -472,6 +577,13 @@ bool multi_io_support::open (const std::stringcase& fname,
 	}
 	path newfile ((filestat == io_filestat::read ? indirname : outdirname).c_str());
 	newfile /= fname.c_str();
+	// output is formatted into memory and written in the background
+	if (filestat == io_filestat::write) {
+		filename = newfile.string().c_str();
+		buffer.clear();
+		file_num_out += 1;
+		return true;
+	}
 	FILE* fio = fopen (newfile.string().c_str(), io.c_str());
 	if (!fio) {
 		filestat = io_filestat::closed;
@@ -501,9 +613,51 @@ void multi_io_support::close()
 {
 	if (filehandle) fclose (filehandle);
 	filehandle = 0;
+	if (filestat == io_filestat::write) {
+		if (!writer) {
+			writer = std::make_shared<output_writer> (writer_threads);
+		}
+		writer->write (filename, std::move (buffer));
+		buffer.clear();
+	}
 	filestat = io_filestat::closed;
 }
 
+/* Format into the output buffer
+   multi_io_support::print
+************************************************************************/
+int multi_io_support::print (const char* format, ...)
+{
+	if (filestat != io_filestat::write) {
+		return -1;
+	}
+	char buf[1024];
+	va_list args;
+	va_start (args, format);
+	int len = vsnprintf (buf, sizeof (buf), format, args);
+	va_end (args);
+	if ((len < 0) || (len < (int)sizeof (buf))) {
+		if (len > 0) buffer.append (buf, len);
+		return len;
+	}
+	// longer than the stack buffer: format directly into the output
+	size_t pos = buffer.size();
+	buffer.resize (pos + len + 1);
+	va_start (args, format);
+	vsnprintf (&buffer[pos], len + 1, format, args);
+	va_end (args);
+	buffer.resize (pos + len);
+	return len;
+}
+
+/* Wait for all output files
+   multi_io_support::wait_written
+************************************************************************/
+bool multi_io_support::wait_written()
+{
+	return !writer || writer->wait();
+}
+
 /* Set input directory name
    multi_io_support::set_indirname
 ************************************************************************/
@@ -532,6 +686,259 @@ void multi_io_support::set_outdirname (const std::stringcase& dname)
 }
 
 
+/* Constants
+   output_cache::manifest_ext
+************************************************************************/
+const char* const output_cache::manifest_ext = ".cache";
+
+/// Manifest header, increment the version when the format changes
+static const char* const output_cache_magic = "tcIoc output cache 1";
+
+/// Generator revision, increment whenever the generated records, listings
+/// or macros change, so that the outputs of an older build are not reused
+static const unsigned long long output_cache_generator = 1;
+
+/* Get the manifest name
+   output_cache::get_manifest
+************************************************************************/
+stringcase output_cache::get_manifest (const stringcase& output, bool dir)
+{
+	if (!dir) {
+		return output + manifest_ext;
+	}
+	path fname (output.c_str());
+	fname /= "macros";
+	return fname.string().c_str() + stringcase (manifest_ext);
+}
+
+/* Parse command line arguments
+   output_cache::getopt
+************************************************************************/
+int output_cache::getopt (int argc, const char* const argv[], bool argp[])
+{
+	int num = 0;
+	for (int i = 1; i < argc; ++i) {
+		if (argp && argp[i]) continue;
+		if (!argv[i]) {
+			if (argp) argp[i] = true;
+			continue;
+		}
+		std::stringcase arg (argv[i]);
+		int oldnum = num;
+		// reuse outputs when nothing changed
+		if (arg == "-yo" || arg == "/yo") {
+			set_use_cache (true);
+			++num;
+		}
+		// always regenerate
+		else if (arg == "-no" || arg == "/no") {
+			set_use_cache (false);
+			++num;
+		}
+		// now set flag to indicated a processed option
+		if (argp && (num > oldnum)) {
+			argp[i] = true;
+		}
+	}
+	return num;
+}
+
+/* Hash a memory region 8 bytes at a time
+   output_cache::hash
+************************************************************************/
+unsigned long long output_cache::hash (const char* p, size_t len, 
+									   unsigned long long seed)
+{
+	unsigned long long h = 0xcbf29ce484222325ULL ^ seed ^ len;
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		unsigned long long w;
+		memcpy (&w, p + i, 8);
+		h = (h ^ w) * 0x100000001b3ULL;
+		h ^= h >> 29;
+	}
+	for (; i < len; ++i) {
+		h = (h ^ (unsigned char)p[i]) * 0x100000001b3ULL;
+	}
+	return h ^ (h >> 32);
+}
+
+/* Hash the content of a file
+   output_cache::hash_file
+************************************************************************/
+bool output_cache::hash_file (const stringcase& fname, unsigned long long& h)
+{
+	// text mode, so that the hash matches the formatted content
+	FILE* fp = fopen (fname.c_str(), "r");
+	if (!fp) {
+		return false;
+	}
+	// chain the hashes of fixed size chunks, so that the file is not
+	// held in memory
+	unsigned long long hchunks = 0;
+	char chunk[65536];
+	size_t n;
+	while ((n = fread (chunk, 1, sizeof (chunk), fp)) > 0) {
+		hchunks = hash (chunk, n, hchunks);
+	}
+	bool ret = !ferror (fp);
+	fclose (fp);
+	h = hchunks;
+	return ret;
+}
+
+/* Set the key
+   output_cache::set_key
+************************************************************************/
+void output_cache::set_key (unsigned long long tpyhash, 
+							const stringcase& opts, 
+							const replacement_table& rules)
+{
+	content = tpyhash;
+	// outputs of a different generator or build are not reused
+	options = hash (opts.c_str(), opts.size(), 
+		output_cache_generator ^ ((unsigned long long)svn_revision << 32));
+	for (const auto& rule : rules) {
+		options = hash (rule.first.c_str(), rule.first.size(), options);
+		options = hash (rule.second.c_str(), rule.second.size(), options);
+	}
+}
+
+/* Add options to the key
+   output_cache::append_key
+************************************************************************/
+void output_cache::append_key (const stringcase& opts)
+{
+	options = hash (opts.c_str(), opts.size(), options);
+}
+
+/* Read a manifest
+   output_cache::read
+************************************************************************/
+bool output_cache::read (const stringcase& manifest)
+{
+	oldfiles.clear();
+	oldcontent = oldoptions = 0;
+	FILE* fp = fopen (manifest.c_str(), "r");
+	if (!fp) {
+		return false;
+	}
+	char line[1024];
+	bool ret = fgets (line, sizeof (line), fp) &&
+		(strncmp (line, output_cache_magic, strlen (output_cache_magic)) == 0);
+	while (ret && fgets (line, sizeof (line), fp)) {
+		size_t len = strlen (line);
+		while ((len > 0) && ((line[len-1] == '\n') || (line[len-1] == '\r'))) {
+			line[--len] = 0;
+		}
+		unsigned long long h1 = 0, h2 = 0;
+		int n = 0;
+		// key: content and options hash
+		if (sscanf_s (line, "key %llx %llx", &h1, &h2) == 2) {
+			oldcontent = h1;
+			oldoptions = h2;
+		}
+		// file: input hash, output hash and name
+		else if ((sscanf_s (line, "file %llx %llx %n", &h1, &h2, &n) == 2) && 
+			(n > 0) && line[n]) {
+			oldfiles[line + n] = hash_pair (h1, h2);
+		}
+		// stats: counters of the generating run
+		else {
+			ret = sscanf_s (line, "stats %i %i %i", 
+				&stats[0], &stats[1], &stats[2]) == 3;
+		}
+	}
+	fclose (fp);
+	if (!ret) {
+		oldfiles.clear();
+		oldcontent = oldoptions = 0;
+	}
+	return ret;
+}
+
+/* Write a manifest
+   output_cache::write
+************************************************************************/
+bool output_cache::write (const stringcase& manifest) const
+{
+	FILE* fp = fopen (manifest.c_str(), "w");
+	if (!fp) {
+		return false;
+	}
+	fprintf (fp, "%s\n", output_cache_magic);
+	fprintf (fp, "key %016llx %016llx\n", content, options);
+	fprintf (fp, "stats %i %i %i\n", stats[0], stats[1], stats[2]);
+	for (const auto& f : newfiles) {
+		fprintf (fp, "file %016llx %016llx %s\n", 
+			f.second.first, f.second.second, f.first.c_str());
+	}
+	bool ret = !ferror (fp);
+	fclose (fp);
+	return ret;
+}
+
+/* Check the whole manifest
+   output_cache::is_current
+************************************************************************/
+bool output_cache::is_current() const
+{
+	if (!use_cache || oldfiles.empty() || 
+		(oldcontent != content) || (oldoptions != options)) {
+		return false;
+	}
+	for (const auto& f : oldfiles) {
+		unsigned long long h;
+		if (!hash_file (f.first, h) || (h != f.second.second)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Check a single file
+   output_cache::is_current
+************************************************************************/
+bool output_cache::is_current (const stringcase& fname, 
+							   unsigned long long input)
+{
+	if (!use_cache || (oldoptions != options)) {
+		return false;
+	}
+	auto f = oldfiles.find (fname);
+	unsigned long long h;
+	if ((f == oldfiles.end()) || (f->second.first != input) ||
+		!hash_file (fname, h) || (h != f->second.second)) {
+		return false;
+	}
+	newfiles[fname] = f->second;
+	return true;
+}
+
+/* Add a file from its content
+   output_cache::add_file
+************************************************************************/
+void output_cache::add_file (const stringcase& fname, 
+							 unsigned long long input, const std::string& data)
+{
+	newfiles[fname] = hash_pair (input, hash (data.data(), data.size()));
+}
+
+/* Add a file
+   output_cache::add_file
+************************************************************************/
+bool output_cache::add_file (const stringcase& fname, 
+							 unsigned long long input)
+{
+	unsigned long long h;
+	if (!hash_file (fname, h)) {
+		return false;
+	}
+	newfiles[fname] = hash_pair (input, h);
+	return true;
+}
+
+
 /* Option processing
    epics_list_processing::epics_list_processing
 ************************************************************************/
@@ -715,7 +1122,8 @@ epics_macrofiles_processing::epics_macrofiles_processing (
 		int argc, const char* const argv[], bool argp[])
 	: epics_conversion (argc, argv, argp), 
 	  multi_io_support (dname, argc, argv, argp),
-	   plcname (pname), macros (macrofile_type::all), isTwinCAT3 (tcat3), rec_num (0)
+	   plcname (pname), macros (macrofile_type::all), isTwinCAT3 (tcat3), rec_num (0),
+	   file_num_reused (0), cache (nullptr)
 {
 	mygetopt (argc, argv, argp); 
 }
@@ -894,15 +1302,154 @@ std::stringcase epics_macrofiles_processing::to_filename (
 ************************************************************************/
 const std::stringcase epics_macrofiles_processing::errorstruct = "ErrorStruct";
 const std::stringcase epics_macrofiles_processing::errorlistext2 = "_Errors.exp";
-const std::regex epics_macrofiles_processing::errormatchregex2 (
-	"[^:]*:\\s*ErrorMessagesArray\\s*:=\\s*([^;]*);[^;]*", 
-	std::regex_constants::icase);
-const std::regex epics_macrofiles_processing::errorsearchregex ( 
-	"'((\\$[\\$'LlNnPpRrTt\\d])|[^'\\$])*'", std::regex_constants::icase);
 const std::stringcase epics_macrofiles_processing::errorlistext31 = "_Errors.TcGVL";
-const std::regex epics_macrofiles_processing::errormatchregex31 (
-	"[^:]*:\\s*ErrorMessagesArray\\s*:=\\s*\\[\\s*([^\\]]*)\\]\\s*;[^;]*", 
-	std::regex_constants::icase);
+
+/** Removes the escape sequences of a TwinCAT string literal in the same 
+    order as before: control characters, then $$ and $', then $t
+ ************************************************************************/
+static std::stringcase unescape_error_message (const char* p, const char* e)
+{
+	std::string s1;
+	s1.reserve (e - p);
+	// trim control characters: $L, $N, $P, $R and $nn
+	for (const char* q = p; q < e; ++q) {
+		if ((*q == '$') && (q + 1 < e) && q[1] && strchr ("LlNnPpRr", q[1])) {
+			++q;
+		}
+		else if ((*q == '$') && (q + 1 < e) && isdigit ((unsigned char)q[1])) {
+			++q;
+			if ((q + 1 < e) && isdigit ((unsigned char)q[1])) ++q;
+		}
+		else {
+			s1.push_back (*q);
+		}
+	}
+	// unescape $' and $$, then $t
+	for (int pass = 0; pass < 2; ++pass) {
+		std::string s2;
+		s2.reserve (s1.size());
+		for (size_t i = 0; i < s1.size(); ++i) {
+			if ((s1[i] == '$') && (i + 1 < s1.size())) {
+				char c = s1[i+1];
+				if ((pass == 0) && ((c == '$') || (c == '\''))) {
+					s2.push_back (c);
+					++i;
+					continue;
+				}
+				if ((pass == 1) && ((c == 't') || (c == 'T'))) {
+					s2.push_back (' ');
+					++i;
+					continue;
+				}
+			}
+			s2.push_back (s1[i]);
+		}
+		s1.swap (s2);
+	}
+	return s1.c_str();
+}
+
+/* Parse a list of error messages
+   epics_macrofiles_processing::parse_error_list()
+************************************************************************/
+bool epics_macrofiles_processing::parse_error_list (const char* p, 
+	size_t len, bool tcat3, error_list& list)
+{
+	// The entire file must match (whitespace is already replaced by blanks)
+	// TwinCAT 2.11: ... : ErrorMessagesArray := 'msg', ...; ...
+	// TwinCAT 3.1:  ... : ErrorMessagesArray := [ 'msg', ... ] ; ...
+	// where the leading part has no colon and the trailing part no semicolon
+	const char* const end = p + len;
+	auto skip = [end] (const char* q) {
+		while ((q < end) && isspace ((unsigned char)*q)) ++q;
+		return q; };
+	const char* s = (const char*)memchr (p, ':', len);
+	if (!s) return false;
+	s = skip (s + 1);
+	static const char key[] = "ErrorMessagesArray";
+	const size_t keylen = sizeof (key) - 1;
+	if (((size_t)(end - s) < keylen) || (_strnicmp (s, key, keylen) != 0)) {
+		return false;
+	}
+	s = skip (s + keylen);
+	if ((end - s < 2) || (s[0] != ':') || (s[1] != '=')) return false;
+	s = skip (s + 2);
+	const char* first = s;
+	const char* last = nullptr;
+	if (tcat3) {
+		if ((s == end) || (*s != '[')) return false;
+		first = skip (s + 1);
+		last = (const char*)memchr (first, ']', end - first);
+		if (!last) return false;
+		s = skip (last + 1);
+	}
+	else {
+		last = (const char*)memchr (first, ';', end - first);
+		if (!last) return false;
+		s = last;
+	}
+	if ((s == end) || (*s != ';') || memchr (s + 1, ';', end - s - 1)) {
+		return false;
+	}
+
+	// iterate over the single quote strings; a $ escapes the next 
+	// character if it is one of $'LlNnPpRrTt or a digit
+	for (const char* q = first; q < last; ++q) {
+		if (*q != '\'') continue;
+		const char* r = q + 1;
+		while (r < last) {
+			if ((*r == '$') && (r + 1 < last) && 
+				((r[1] && strchr ("$'LlNnPpRrTt", r[1])) || 
+				 isdigit ((unsigned char)r[1]))) {
+				r += 2;
+			}
+			else if ((*r != '\'') && (*r != '$')) {
+				++r;
+			}
+			else {
+				break;
+			}
+		}
+		if ((r < last) && (*r == '\'')) {
+			list.push_back (unescape_error_message (q + 1, r));
+			q = r;
+		}
+	}
+	return true;
+}
+
+/* Read a list of error messages
+   epics_macrofiles_processing::read_error_list()
+************************************************************************/
+const error_list* epics_macrofiles_processing::read_error_list (
+	const std::stringcase& fname)
+{
+	// each file is only read once per run
+	auto cached = errorlists.find (fname);
+	if (cached != errorlists.end()) {
+		return cached->second.first ? &cached->second.second : nullptr;
+	}
+	error_list_entry& entry = errorlists[fname];
+	if (!open (fname, "r", true)) {
+		return nullptr;
+	}
+	entry.first = true;
+	// read file with list of error messages
+	FILE* fp = get_file();
+	fseek (fp, 0L, SEEK_END);
+	size_t sz = ftell (fp);
+	fseek (fp, 0L, SEEK_SET);
+	if (sz > 1000000) sz = 1000000; // let's not get too crazy
+	std::string buf (sz, '\0');
+	sz = fread (&buf[0], sizeof (char), sz, fp);
+	buf.resize (sz);
+	for (auto& c : buf) {
+		if (isspace ((unsigned char)c)) c = ' '; // get rid of LF/CR
+	}
+	close();
+	parse_error_list (buf.data(), buf.size(), isTwinCAT3, entry.second);
+	return &entry.second;
+}
 
 /* Process a record
    epics_macrofiles_processing::process_record()
@@ -921,12 +1468,11 @@ bool epics_macrofiles_processing::process_record (const macro_record& mrec,
 
 	// Check if we need to read a _Errors.exp file containing a list of 
 	// error messages
-	bool havelist = false;
-	std::vector<std::stringcase> errlist;
+	static const error_list noerrors;
+	const error_list* perrlist = nullptr;
 	if (mrec.haserror && 
 		((get_macrofile_type() == macrofile_type::all) ||
 		(get_macrofile_type() == macrofile_type::errors))) {
-		bool succ = false;
 		std::stringcase fname;
 		if (isTwinCAT3) {
 			fname = "ADL\\";
@@ -937,100 +1483,57 @@ bool epics_macrofiles_processing::process_record (const macro_record& mrec,
 			else {
 				fname += mrec.record.type_n.substr(pos+1) + errorlistext31;
 			}
-			succ = open (fname, "r", true);
-			// check if we have a field name
-			if (!succ && !get_plcname().empty() &&
-				mrec.record.name.rfind (get_plcname()) == 
-				mrec.record.name.length() - get_plcname().length()) {
-				std::stringcase::size_type pos = fname.rfind ("Struct");
-				if (pos != stringcase::npos) {
-					fname.insert (pos, get_plcname(), 0, 1);
-				}
-				succ = open (fname, "r", true);
-			}
 		}
 		else {
 			fname = mrec.record.type_n + errorlistext2;
-			succ = open (fname, "r", true);
-			// check if we have a field name
-			if (!succ && !get_plcname().empty() &&
-				mrec.record.name.rfind (get_plcname()) == 
-					mrec.record.name.length() - get_plcname().length()) {
-				std::stringcase::size_type pos = fname.rfind ("Struct");
-				if (pos != stringcase::npos) {
-					fname.insert (pos, get_plcname(), 0, 1);
-				}
-				succ = open (fname, "r", true);
+		}
+		perrlist = read_error_list (fname);
+		// check if we have a field name
+		if (!perrlist && !get_plcname().empty() &&
+			mrec.record.name.rfind (get_plcname()) == 
+			mrec.record.name.length() - get_plcname().length()) {
+			std::stringcase::size_type pos = fname.rfind ("Struct");
+			if (pos != stringcase::npos) {
+				fname.insert (pos, get_plcname(), 0, 1);
 			}
+			perrlist = read_error_list (fname);
 		}
-		if (!succ) {
+		if (!perrlist) {
 			if (missing.find (fname) == missing.end()) {
 				missing.insert (fname);
 				fprintf (stderr, "Cannot open %s\n", fname.c_str());
 			}
 		}
-		else {
-			havelist = true;
-			// read file with list of error messages
-			FILE* fp = get_file();
-			fseek (fp, 0L, SEEK_END);
-			size_t sz = ftell (fp);
-			fseek (fp, 0L, SEEK_SET);
-			if (sz > 1000000) sz = 1000000; // let's not get too crazy
-			unsigned char* buf = new unsigned char [sz+1];
-			sz = fread (buf, sizeof (char), sz, fp);
-			buf[sz] = 0;
-			for (size_t i = 0; i < sz; ++i) {
-				if (isspace (buf[i])) buf[i] = ' '; // get rid of LF/CR
-			}
-			// check if it is formatted correctly
-			std::cmatch match;
-			if (std::regex_match ((const char*)buf, (const char*)buf+sz, match, 
-				isTwinCAT3 ? errormatchregex31 : errormatchregex2)) {
-				for (auto i = ++match.begin(); i != match.end(); ++i) {
-					std::string found = i->str();
-					// search and iterate over single quote strings
-					std::regex_iterator<std::string::iterator> rit 
-						(found.begin(), found.end(), errorsearchregex);
-					std::regex_iterator<std::string::iterator> rend;
-					while (rit != rend) {
-						// found one
-						std::stringcase msg = rit->str().c_str();
-						// trim single quotes
-						msg.erase (0, 1);
-						msg.erase (msg.length()-1, 1);
-						// trim control characters
-						msg = std::regex_replace (msg, std::regex ("\\$([LlNnPpRr]|\\d\\d?)"), "");
-						// unescape $' and $$
-						msg = std::regex_replace (msg, std::regex ("\\$([\\$'])"), "$1");
-						// unesacpe $t
-						msg = std::regex_replace (msg, std::regex ("\\$([tT])"), " ");
-						//printf ("found an error message `%s`\n", msg.c_str());
-						errlist.push_back (msg);
-						++rit;
-					}
-				}
-			}
-			delete [] buf;
-			close();
+	}
+	const error_list& errlist = perrlist ? *perrlist : noerrors;
+
+	// skip the file if it is unchanged
+	std::stringcase outname = to_filename (mrec.record.name) + ".aml";
+	std::stringcase fullname;
+	unsigned long long input = 0;
+	if (cache && cache->get_use_cache()) {
+		input = hash_record (mrec, level, errlist);
+		fullname = (path (get_outdirname().c_str()) / outname.c_str()).string().c_str();
+		if (cache->is_current (fullname, input)) {
+			++file_num_reused;
+			return true;
 		}
 	}
 
 	// open output file
-	if (!open (to_filename (mrec.record.name) + ".aml", "w")) {
+	if (!open (outname, "w")) {
 		fprintf (stderr, "Failed to process %s.\n", mrec.record.name.c_str());
 		return false;
 	}
 
 	// write output file
-	FILE* fp = get_file();
 	if (get_plcname().empty()) {
-		fprintf (fp, "PLC=Unknown\n");
+		print ("PLC=Unknown\n");
 	}
 	else {
-		fprintf (fp, "PLC=%s,\n", get_plcname().c_str());
+		print ("PLC=%s,\n", get_plcname().c_str());
 	}
-	fprintf (fp, "CHN=%s,\n", mrec.record.name.c_str());
+	print ("CHN=%s,\n", mrec.record.name.c_str());
 
 	// get ifo
 	auto colon = mrec.record.name.find (':');
@@ -1068,25 +1571,25 @@ bool epics_macrofiles_processing::process_record (const macro_record& mrec,
 			sys = "";
 		}
 	}
-	fprintf (fp, "IFO=%s,\n", ifo.c_str());
+	print ("IFO=%s,\n", ifo.c_str());
 	std::stringcase lifo = ifo;
 	for (unsigned int i = 0; i < lifo.length(); ++i) lifo[i] = tolower (lifo[i]);
-	fprintf (fp, "ifo=%s,\n", lifo.c_str());
-	fprintf (fp, "SYS=%s,\n", sys.c_str());
-	fprintf (fp, "SUB=%s,\n", sub.c_str());
-	fprintf (fp, "LVL=%i,\n", level);
+	print ("ifo=%s,\n", lifo.c_str());
+	print ("SYS=%s,\n", sys.c_str());
+	print ("SUB=%s,\n", sub.c_str());
+	print ("LVL=%i,\n", level);
 
 	// screen names
-	fprintf (fp, "itself=%s,\n", to_filename (mrec.record.name).c_str());
-	fprintf (fp, "related=%s,\n", to_filename (mrec.record.name).c_str());
-	fprintf (fp, "back=%s,\n", to_filename (mrec.back.name).c_str());
+	print ("itself=%s,\n", to_filename (mrec.record.name).c_str());
+	print ("related=%s,\n", to_filename (mrec.record.name).c_str());
+	print ("back=%s,\n", to_filename (mrec.back.name).c_str());
 	// write has errors
-	fprintf (fp, "haserrors=%i,\n", mrec.haserror ? 1 : 0);
+	print ("haserrors=%i,\n", mrec.haserror ? 1 : 0);
 	if (mrec.haserror && (mrec.erroridx >= 0) && (mrec.erroridx < (int)mrec.fields.size())) {
-		fprintf (fp, "errfld=%s,\n", mrec.fields[mrec.erroridx].name.c_str());
+		print ("errfld=%s,\n", mrec.fields[mrec.erroridx].name.c_str());
 	}
 	else {
-		fprintf (fp, "errfld=,\n");
+		print ("errfld=,\n");
 	}
 
 	// Error messages
@@ -1095,7 +1598,7 @@ bool epics_macrofiles_processing::process_record (const macro_record& mrec,
 		int num = 0;
 		for (auto i = errlist.begin(); (i != errlist.end()) && (num < 32); ++i, ++num) {
 			// write error message
-			fprintf (fp, "err%i=\"%s\",\n", num, i->c_str());
+			print ("err%i=\"%s\",\n", num, i->c_str());
 			// check if we have a field name
 			if (!get_plcname().empty() &&
 				mrec.record.name.rfind (get_plcname()) == 
@@ -1112,7 +1615,7 @@ bool epics_macrofiles_processing::process_record (const macro_record& mrec,
 					}
 				}
 				if (issuberr) {
-					fprintf (fp, "nxt%i=%s,\n", num, suberr.c_str());
+					print ("nxt%i=%s,\n", num, suberr.c_str());
 				}
 			}
 			else {
@@ -1134,12 +1637,12 @@ bool epics_macrofiles_processing::process_record (const macro_record& mrec,
 					//}
 				}
 				if (pinfo) {
-					fprintf (fp, "nxt%i=%s,\n", num, to_filename (pinfo->name).c_str());
+					print ("nxt%i=%s,\n", num, to_filename (pinfo->name).c_str());
 				}
 			}
 		}
 		// write list length
-		fprintf (fp, "errors=%i,\n", num);
+		print ("errors=%i,\n", num);
 	}
 
 	// Fields
@@ -1153,22 +1656,22 @@ bool epics_macrofiles_processing::process_record (const macro_record& mrec,
 			// set field type
 			switch (i.ptype) {
 			case pt_bool:
-				fprintf (fp, "fio%i=%s,\n", num, i.readonly ? "bi" : "bo");
+				print ("fio%i=%s,\n", num, i.readonly ? "bi" : "bo");
 				break;
 			case pt_enum:
-				fprintf (fp, "fio%i=%s,\n", num, i.readonly ? "mbbi" : "mbbo");
+				print ("fio%i=%s,\n", num, i.readonly ? "mbbi" : "mbbo");
 				break;
 			case pt_int:
-				fprintf (fp, "fio%i=%s,\n", num, i.readonly ? "longin" : "longout");
+				print ("fio%i=%s,\n", num, i.readonly ? "longin" : "longout");
 				break;
 			case pt_real:
-				fprintf (fp, "fio%i=%s,\n", num, i.readonly ? "ai" : "ao");
+				print ("fio%i=%s,\n", num, i.readonly ? "ai" : "ao");
 				break;
 			case pt_string:
-				fprintf (fp, "fio%i=%s,\n", num, i.readonly ? "stringin" : "stringout");
+				print ("fio%i=%s,\n", num, i.readonly ? "stringin" : "stringout");
 				break;
 			case pt_binary:
-				fprintf (fp, "fio%i=%s,\n", num, "link");
+				print ("fio%i=%s,\n", num, "link");
 				break;
 			case pt_invalid:
 			default:
@@ -1176,20 +1679,48 @@ bool epics_macrofiles_processing::process_record (const macro_record& mrec,
 			}
 			// set field name
 			if (i.ptype == pt_binary) {
-				fprintf (fp, "fld%i=%s,\n", num, to_filename (i.name).c_str());
+				print ("fld%i=%s,\n", num, to_filename (i.name).c_str());
 			}
 			else {
-				fprintf (fp, "fld%i=%s,\n", num, i.name.c_str());
+				print ("fld%i=%s,\n", num, i.name.c_str());
 			}
 			++num;
 		}
-		fprintf (fp, "fields=%i,\n", num);
+		print ("fields=%i,\n", num);
 	}
 
+	if (cache && cache->get_use_cache()) {
+		cache->add_file (fullname, input, get_buffer());
+	}
 	close();
 	return true;
 }
 
+/* Hash the input of a macro file
+   epics_macrofiles_processing::hash_record()
+************************************************************************/
+unsigned long long epics_macrofiles_processing::hash_record (
+	const macro_record& mrec, int level, 
+	const error_list& errlist) const
+{
+	char buf[100];
+	sprintf_s (buf, sizeof (buf), "%i %i %i %i %i|", static_cast<int>(macros), 
+		isTwinCAT3 ? 1 : 0, level, mrec.haserror ? 1 : 0, mrec.erroridx);
+	std::stringcase s (buf);
+	(((s += get_plcname()) += '|') += mrec.record.name) += '|';
+	(s += mrec.back.name) += '|';
+	for (const auto& i : mrec.fields) {
+		sprintf_s (buf, sizeof (buf), "%i %i ", static_cast<int>(i.ptype), 
+			i.readonly ? 1 : 0);
+		(((s += buf) += i.name) += ' ') += i.type_n;
+		s += '|';
+	}
+	for (const auto& i : errlist) {
+		(s += i) += '|';
+	}
+	return output_cache::hash (s.c_str(), s.size());
+}
+
 
 /* Option processing
    epics_db_processing::epics_db_processing
@@ -1199,7 +1730,8 @@ epics_db_processing::epics_db_processing (
 		int argc, const char* const argv[], bool argp[])
 	: epics_conversion (argc, argv, argp), 
 	  split_io_support (fname, argc, argv, argp),
-	  device_support (device_support_tc_name)
+	  device_support (device_support_tc_name),
+	  record_sink (nullptr), record_file (true)
 {
 	mygetopt (argc, argv, argp); 
 }
@@ -1303,7 +1835,7 @@ bool epics_db_processing::operator() (const process_arg& arg)
 		return false;
 	}
 	// now print header
-	fprintf(get_file(), "record(%s,\"%s\") {\n", tname.c_str(), epicsname.c_str());
+	process_record_begin (tname, epicsname);
 
 	// check OPC_PROP_DESC
 	if (arg.get_opc().get_property (OPC_PROP_DESC, s)) {
@@ -1526,18 +2058,43 @@ bool epics_db_processing::operator() (const process_arg& arg)
 		}
 	}
 	// end with closing bracket
-	fprintf(get_file(), "}\n");
+	process_record_end();
 	return true;
 }
 
+/* Start a record
+epics_db_processing::process_record_begin
+************************************************************************/
+bool epics_db_processing::process_record_begin (const stringcase& rtype, 
+												const std::string& name)
+{
+	if (record_file) {
+		fprintf (get_file(), "record(%s,\"%s\") {\n", rtype.c_str(), name.c_str());
+	}
+	return record_sink ? record_sink->record_begin (rtype, name) : true;
+}
+
+/* Finish a record
+epics_db_processing::process_record_end
+************************************************************************/
+bool epics_db_processing::process_record_end()
+{
+	if (record_file) {
+		fprintf (get_file(), "}\n");
+	}
+	return record_sink ? record_sink->record_end() : true;
+}
+
 /* Process a field
 epics_db_processing::process_field_string
 ************************************************************************/
 bool epics_db_processing::process_field_string (stringcase name, 
 												stringcase val)
 {
-	fprintf (get_file(), "\tfield(%s,\"%s\")\n", name.c_str(), val.c_str());
-	return true;
+	if (record_file) {
+		fprintf (get_file(), "\tfield(%s,\"%s\")\n", name.c_str(), val.c_str());
+	}
+	return record_sink ? record_sink->record_field (name, val) : true;
 }
 
 /* Process a field
@@ -1584,8 +2141,7 @@ bool epics_db_processing::process_field_alarm (stringcase name,
 {
 	if ((severity == EPICS_DB_NOALARM) || (severity == EPICS_DB_MINOR) || 
 		(severity == EPICS_DB_MAJOR)) {
-		fprintf (get_file(), "\tfield(%s,\"%s\")\n", name.c_str(), severity.c_str());
-		return true;
+		return process_field_string (name, severity);
 	}
 	else {
 		fprintf (stderr, "Unknown alarm severity %s for %s\n", severity.c_str(), name.c_str());
@@ -1,6 +1,11 @@
 #pragma once
 #include "stdafx.h"
 #include "ParseTpy.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
 
 /** @file TpyToEpics.h
 	Header which includes classes to convert a parsed TwinCAT tpy into
@@ -233,8 +238,13 @@ public:
 	int get_processed_readonly() const { return rec_num_in; }
 	/// Get number of processed input/ouput channels
 	int get_processed_io() const { return rec_num_io; }
+	/// Get names of all files opened for writing
+	const std::vector<std::stringcase>& get_filenames() const { 
+		return filenames; }
 
 protected:
+	/// Open an output file and remember its name
+	FILE* open_output (const std::stringcase& fname);
 	/// Set output filename
 	void set_filename (const std::stringcase& fname);
 	/// Close files
@@ -300,6 +310,8 @@ protected:
 	std::stringcase		file_in_s;
 	/// Contains the file extenstion for input/output files
 	std::stringcase		file_io_s;
+	/// Names of all files opened for writing
+	std::vector<std::stringcase>	filenames;
 private:
 };
 
@@ -313,6 +325,59 @@ enum class io_filestat {
 	write
 };
 
+/** Writes files on a pool of background threads. The file content is
+    formatted in memory and handed over as a whole, so that each file is 
+    written with a single call. Files with the same name are always 
+    written by the same thread in the order they were submitted.
+	@brief Background file writer
+************************************************************************/
+class output_writer {
+public:
+	/// Constructor
+	/// @param threads Number of threads, 0 uses all cores (up to 8)
+	explicit output_writer (int threads = 0);
+	/// Destructor, waits for all pending files
+	~output_writer();
+
+	/// Queue a file for writing
+	/// @param fname Name of the file
+	/// @param data File content
+	void write (const std::stringcase& fname, std::string&& data);
+	/// Wait until all queued files are written
+	/// @return True if no errors were encountered
+	bool wait();
+	/// Get number of files which could not be written
+	int get_errors() const { return errors; }
+
+protected:
+	/// Disable copy constructor
+	output_writer (const output_writer&);
+	/// Disable assignment operator
+	output_writer& operator= (const output_writer&);
+
+	/// A file name and its content
+	typedef std::pair<std::stringcase, std::string> file_job;
+	/// Thread loop
+	void run (size_t idx);
+
+	/// Mutex protecting the queues
+	std::mutex		mux;
+	/// Signals new jobs and shutdown
+	std::condition_variable	cond;
+	/// Signals completed jobs
+	std::condition_variable	idle;
+	/// Job queue of each thread
+	std::vector<std::deque<file_job>>	queues;
+	/// Worker threads
+	std::vector<std::thread>	workers;
+	/// Number of queued or active jobs
+	int				pending;
+	/// Shutdown
+	bool			done;
+	/// Number of errors
+	std::atomic<int>	errors;
+};
+
 /** Multi file IO support
     Supports a directory argument and opens files within
 	@brief Multiple IO support
@@ -322,12 +387,13 @@ public:
 	/// Default constructor
 	multi_io_support ()
 		: filestat (io_filestat::closed), filehandle(0), 
-		file_num_in(0), file_num_out(0) {}
+		file_num_in(0), file_num_out(0), writer_threads(0) {}
 
 	/// Constructor
 	explicit multi_io_support (const std::stringcase& dname)
 		: filestat (io_filestat::closed), filehandle(0), file_num_in(0), 
-		file_num_out(0) { set_outdirname (dname); set_indirname (dname); }
+		file_num_out(0), writer_threads(0) { 
+		set_outdirname (dname); set_indirname (dname); }
 	/// Constructor
 	/// Command line arguments will override default parameters when specified
 	/// The format is the same as the arguments passed to the main program
@@ -339,7 +405,7 @@ public:
 	multi_io_support (const std::stringcase& dname,
 		int argc, const char* const argv[], bool argp[] = 0)
 		: filestat (io_filestat::closed), filehandle(0), file_num_in(0), 
-		file_num_out(0) { 
+		file_num_out(0), writer_threads(0) { 
 		getopt (argc, argv, argp); set_outdirname (dname); set_indirname (dname); }
 	/// Destructor
 	~multi_io_support () {close(); }
@@ -350,9 +416,23 @@ public:
 	bool open (const std::stringcase& fname, const std::stringcase& io = "w",
 			bool superrmsg = false);
 	/// Close file
+	/// Output files are handed to a background writer
 	void close();
-	/// Get file handle
+	/// Get file handle, only valid for reading
 	FILE* get_file () const {return filehandle; }
+	/// Format into the output buffer of a file opened for writing
+	/// @param format printf style format string
+	/// @return Number of characters written, or negative on error
+	int print (const char* format, ...);
+	/// Get the output buffer of a file opened for writing
+	const std::string& get_buffer() const { return buffer; }
+	/// Wait until all output files are written
+	/// @return True if no errors were encountered
+	bool wait_written();
+	/// Get number of background writer threads (0 = all cores, up to 8)
+	int get_writer_threads() const { return writer_threads; }
+	/// Set number of background writer threads, before the first file is written
+	void set_writer_threads (int threads) { writer_threads = threads; }
 
 	/// Set output directory name
 	void set_outdirname (const std::stringcase& dname);
@@ -413,9 +493,145 @@ protected:
 	int				file_num_in;
 	/// Current file number of processed input/output channels (records)
 	int				file_num_out;
+	/// Content of the file opened for writing
+	std::string		buffer;
+	/// Number of background writer threads
+	int				writer_threads;
+	/// Background writer, shared between copies
+	std::shared_ptr<output_writer>	writer;
 };
 
 
+/** Content-addressed cache of generated output files. A manifest stores
+    a key computed from the tpy file content, the options, the 
+    replacement rules and the generator revision, together with the 
+    content hash of every file that was written. Outputs are reused when
+    the key matches and none of the files were modified since. Files can
+    also be tracked individually by a hash of their input, so that macro
+    files are only rewritten for the structures which changed.
+	@brief Output cache
+************************************************************************/
+class output_cache {
+public:
+	/// Default constructor
+	output_cache() : use_cache (false), content (0), options (0), 
+		oldcontent (0), oldoptions (0) {
+		stats[0] = stats[1] = stats[2] = 0; }
+
+	/// Parse a command line
+	/// The format is the same as the arguments passed to the main program
+	/// argv[0] is program name and will be ignored
+	/// The argp boolean array can be used to pass in a list of already
+	/// processed (and to be ignored) command line arguments. This list,
+	/// if supplied, must be at least argc long. Upon return, newly processed
+	/// arguments are also marked as processed in this list. The arguments are:
+	///
+	/// /yo: Reuse previously generated outputs when nothing changed
+	/// /no: Always regenerate all outputs
+	///
+	/// Command line arguments can use '-' instead of a '/'. Capitalization does
+	/// not matter. getopt will only override arguments that are specifically 
+	/// specified. It relies on the contructors to provide the defaults.
+	/// @param argc Number of command line arguments
+	/// @param argv List of command line arguments, same format as in main()
+	/// @param argp Excluded/processed arguments (in/out), array length must be argc
+	/// @return Number of arguments processed
+	int getopt (int argc, const char* const argv[], bool argp[] = 0);
+
+	/// Is the output cache used?
+	bool get_use_cache() const { return use_cache; }
+	/// Set the output cache use
+	void set_use_cache (bool cache) { use_cache = cache; }
+
+	/// Set the key, it includes the generator revision and the build
+	/// @param tpyhash Hash of the tpy file content
+	/// @param opts Option string
+	/// @param rules Replacement rules
+	void set_key (unsigned long long tpyhash, const std::stringcase& opts,
+		const ParseUtil::replacement_table& rules);
+	/// Add more options to the key, e.g., for a listing generated 
+	/// alongside the database
+	/// @param opts Option string
+	void append_key (const std::stringcase& opts);
+	/// Read a manifest
+	/// @param manifest Name of the manifest file
+	/// @return True if read successfully
+	bool read (const std::stringcase& manifest);
+	/// Write a manifest with the key and all added files
+	/// @param manifest Name of the manifest file
+	/// @return True if written successfully
+	bool write (const std::stringcase& manifest) const;
+
+	/// Checks if the manifest was generated with the same key and
+	/// if all of its files are unchanged
+	bool is_current() const;
+	/// Checks if a file was generated from the same input with the 
+	/// same options and is unchanged; it is added to the new manifest
+	/// @param fname Name of output file
+	/// @param input Hash of the input which generates the file
+	bool is_current (const std::stringcase& fname, unsigned long long input);
+	/// Add a file to the new manifest after it was written
+	/// @param fname Name of output file
+	/// @param input Hash of the input which generates the file
+	/// @return True if the file could be read
+	bool add_file (const std::stringcase& fname, unsigned long long input = 0);
+	/// Add a file to the new manifest from its content
+	/// @param fname Name of output file
+	/// @param input Hash of the input which generates the file
+	/// @param data Content of the file
+	void add_file (const std::stringcase& fname, unsigned long long input,
+		const std::string& data);
+	/// Get the number of files in the manifest
+	int size() const { return static_cast<int>(oldfiles.size()); }
+
+	/// Get a statistics counter
+	int get_stats (int idx) const { 
+		return (idx >= 0) && (idx < 3) ? stats[idx] : 0; }
+	/// Set the statistics counters
+	void set_stats (int n0, int n1 = 0, int n2 = 0) {
+		stats[0] = n0; stats[1] = n1; stats[2] = n2; }
+
+	/// Hash a memory region
+	static unsigned long long hash (const char* p, size_t len, 
+		unsigned long long seed = 0);
+	/// Hash the content of a file
+	static bool hash_file (const std::stringcase& fname, 
+		unsigned long long& h);
+
+	/// Get the manifest name of an output
+	/// @param output Name of output file or directory
+	/// @param dir True if output is a directory of macro files
+	/// @return Manifest name
+	static std::stringcase get_manifest (const std::stringcase& output, 
+		bool dir = false);
+
+	/// Manifest file extension (".cache")
+	static const char* const manifest_ext;
+
+protected:
+	/// Hash of input and of output content
+	typedef std::pair<unsigned long long, unsigned long long> hash_pair;
+	/// Map of file names to hashes
+	typedef std::map<std::stringcase, hash_pair> file_map;
+
+	/// Use cache
+	bool			use_cache;
+	/// Hash of the tpy content of this run
+	unsigned long long	content;
+	/// Hash of the options and rules of this run
+	unsigned long long	options;
+	/// Statistics counters
+	int				stats[3];
+	/// Content hash read from the manifest
+	unsigned long long	oldcontent;
+	/// Options hash read from the manifest
+	unsigned long long	oldoptions;
+	/// Files read from the manifest
+	file_map		oldfiles;
+	/// Files of the new manifest
+	file_map		newfiles;
+};
+
 /** This enum describes the type of listing to produce
      @brief Listing type enum
 ************************************************************************/
@@ -565,6 +781,18 @@ typedef std::stack<macro_record> macro_stack;
  ************************************************************************/
 typedef std::unordered_set<std::stringcase> filename_set;
 
+/** A list of error messages
+ ************************************************************************/
+typedef std::vector<std::stringcase> error_list;
+
+/** An error list and a flag indicating if its file exists
+ ************************************************************************/
+typedef std::pair<bool, error_list> error_list_entry;
+
+/** Error lists by file name
+ ************************************************************************/
+typedef std::unordered_map<std::stringcase, error_list_entry> error_list_map;
+
 /** Class for generatig macro files to be used by medm
 	@brief Macro file processing
 ************************************************************************/
@@ -575,21 +803,17 @@ public:
 	static const std::stringcase errorstruct;
 	/// TwinCAT 2.11: File extension identifying a list of error msgs ("_Errors.exp")
 	static const std::stringcase errorlistext2;
-	/// TwinCAT 2.11: Regular expression to match the entire error record defintition
-	static const std::regex errormatchregex2;
 	/// TwinCAT 3.1: File extension identifying a list of error msgs ("_Errors.TcGVL")
 	static const std::stringcase errorlistext31;
-	/// TwinCAT 3.1: Regular expression to match the entire error record defintition
-	static const std::regex errormatchregex31;
-	/// TwinCAT 2.11/3.1: Regular expression to search for the actual error messages
-	static const std::regex errorsearchregex;
 
 	/// Default constructor
-	epics_macrofiles_processing() : macros (macrofile_type::all), isTwinCAT3 (false), rec_num (0) {}
+	epics_macrofiles_processing() : macros (macrofile_type::all), isTwinCAT3 (false), 
+		rec_num (0), file_num_reused (0), cache (nullptr) {}
 	/// Constructor
 	/// @param mt Type of macro
 	explicit epics_macrofiles_processing (macrofile_type mt) 
-		: macros (mt), isTwinCAT3 (false), rec_num (0) {}
+		: macros (mt), isTwinCAT3 (false), rec_num (0), file_num_reused (0),
+		cache (nullptr) {}
 	/// Constructor
 	/// Command line arguments will override default parameters when specified
 	/// The format is the same as the arguments passed to the main program
@@ -666,10 +890,32 @@ public:
 
 	/// Get number of processed channels
 	int get_processed_total() const { return rec_num; }
+	/// Get number of unchanged files which were not rewritten
+	int get_reused_total() const { return file_num_reused; }
+
+	/// Get the output cache
+	output_cache* get_output_cache() const { return cache; }
+	/// Set the output cache, macro files are only rewritten when changed
+	void set_output_cache (output_cache* c) { cache = c; }
 
 protected:
 	/// Process top of stack
 	bool process_record (const macro_record& mrec, int level = 0);
+	/// Hash the input of a macro file
+	unsigned long long hash_record (const macro_record& mrec, int level,
+		const error_list& errlist) const;
+	/// Get the error messages of a file, each file is only read once
+	/// @param fname Name of error list file
+	/// @return List of error messages, nullptr if the file doesn't exist
+	const error_list* read_error_list (const std::stringcase& fname);
+	/// Parse the error messages from a file content
+	/// @param p File content with whitespace replaced by blanks
+	/// @param len Length of file content
+	/// @param tcat3 TwinCAT 3.1 format
+	/// @param list List of error messages (out)
+	/// @return True if the content is formatted correctly
+	static bool parse_error_list (const char* p, size_t len, bool tcat3,
+		error_list& list);
 
 	/// Listing type
 	macrofile_type	macros;
@@ -683,6 +929,12 @@ protected:
 	int				rec_num;
 	/// set of missing input files
 	filename_set	missing;
+	/// Error lists which were already read
+	error_list_map	errorlists;
+	/// Number of unchanged files
+	int				file_num_reused;
+	/// Output cache
+	output_cache*	cache;
 };
 
 /** This enum describes the type of listing to produce
@@ -695,6 +947,31 @@ enum device_support_type {
 	device_support_tc_name
 };
 
+/** Interface for receiving EPICS records directly, e.g., to create them
+	in memory instead of writing and reparsing a database file
+	@brief EPICS database record sink
+************************************************************************/
+class epics_record_sink {
+public:
+	/// Destructor
+	virtual ~epics_record_sink() {}
+	/// Start a new record
+	/// @param rtype Record type
+	/// @param name Record name
+	/// @return True if successful
+	virtual bool record_begin (const std::stringcase& rtype, 
+		const std::string& name) = 0;
+	/// Set a field of the current record
+	/// @param name Name of field
+	/// @param val Value of field
+	/// @return True if successful
+	virtual bool record_field (const std::stringcase& name, 
+		const std::stringcase& val) = 0;
+	/// Finish the current record
+	/// @return True if successful
+	virtual bool record_end() = 0;
+};
+
 /** Class for generatig an EPICS database record 
 	@brief pics database record processing
 ************************************************************************/
@@ -702,7 +979,8 @@ class epics_db_processing :
 	public epics_conversion, public split_io_support {
 public:
 	/// Default constructor
-	epics_db_processing () : device_support (device_support_tc_name) {}
+	epics_db_processing () : device_support (device_support_tc_name),
+		record_sink (nullptr), record_file (true) {}
 
 	/// Constructor
 	/// Command line arguments will override default parameters when specified
@@ -751,12 +1029,33 @@ public:
 	void set_device_support (device_support_type devsup) {
 		device_support = devsup; }
 
+	/// Get the record sink
+	epics_record_sink* get_record_sink() const { return record_sink; }
+	/// Set a sink which receives all records
+	/// @param sink Record sink (nullptr for none)
+	/// @param file Also write the records to the database file
+	void set_record_sink (epics_record_sink* sink, bool file = true) {
+		record_sink = sink; record_file = file || !sink; }
+	/// Is the database file written?
+	bool is_record_file() const { return record_file; }
+	/// Skip writing the database file, e.g., when a cached one is reused
+	void set_record_file (bool file) { record_file = file; }
+
 	/// Process a variable
 	/// @param arg Process argument describign the variable and type
 	/// @return True if successfully processed
 	bool operator() (const ParseUtil::process_arg& arg);
 
 protected:
+	/// Start a record in the file and/or the sink
+	/// @param rtype Record type
+	/// @param name Record name
+	/// @return True if successful
+	bool process_record_begin (const std::stringcase& rtype, 
+		const std::string& name);
+	/// Finish a record in the file and/or the sink
+	/// @return True if successful
+	bool process_record_end();
 	/// Process a record field of type string
 	/// @param name Name of field
 	/// @param val Value of field
@@ -788,6 +1087,10 @@ protected:
 
 	/// Device support field conversion rule
 	device_support_type	device_support;
+	/// Sink receiving the records
+	epics_record_sink*	record_sink;
+	/// Records are written to the database file
+	bool				record_file;
 };
 
 
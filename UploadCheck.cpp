@@ -0,0 +1,188 @@
+#include "stdafx.h"
+#include "ParseUtilConst.h"
+#include "ParseTpy.h"
+
+using namespace std;
+using namespace ParseUtil;
+using namespace ParseTpy;
+
+#pragma warning (disable: 4996)
+
+/** @file UploadCheck.cpp
+	Source for the check of a recorded ADS symbol upload against its tpy
+ ************************************************************************/
+
+/** Number of reported mismatches
+ ************************************************************************/
+static int errors = 0;
+
+/** Reports a mismatch
+	@param what Kind of the compared entry
+	@param name Name of the entry
+	@param detail Property which differs
+ ************************************************************************/
+static void mismatch (const char* what, const stringcase& name,
+					  const char* detail)
+{
+	if (errors++ < 20) {
+		fprintf (stderr, "Mismatch for %s %s: %s\n", what, name.c_str(), detail);
+	}
+}
+
+/** OPC list without the PLC name, which is not part of an upload
+ ************************************************************************/
+static opc_list without_plcname (const opc_list& opc)
+{
+	opc_list ret (opc);
+	ret.get_properties().erase (OPC_PROP_PLCNAME);
+	return ret;
+}
+
+/** Compares the symbols of a tpy and of an upload
+ ************************************************************************/
+static void compare_symbols (const tpy_file& tpy, const tpy_file& upload)
+{
+	map<stringcase, const symbol_record*> syms;
+	for (const auto& sym : tpy.get_symbols()) {
+		syms[sym.get_name()] = &sym;
+	}
+	if (syms.size() != upload.get_symbols().size()) {
+		mismatch ("symbol list", "", "number of symbols");
+	}
+	for (const auto& sym : upload.get_symbols()) {
+		auto s = syms.find (sym.get_name());
+		if (s == syms.end()) {
+			mismatch ("symbol", sym.get_name(), "missing in tpy");
+			continue;
+		}
+		if (sym.get_type_name() != s->second->get_type_name()) {
+			mismatch ("symbol", sym.get_name(), "type name");
+		}
+		if (sym.get() != s->second->get()) {
+			mismatch ("symbol", sym.get_name(), "location or size");
+		}
+		if (sym.get_type_pointer() != s->second->get_type_pointer()) {
+			mismatch ("symbol", sym.get_name(), "pointer");
+		}
+		if (!(without_plcname (sym.get_opc()) ==
+			  without_plcname (s->second->get_opc()))) {
+			mismatch ("symbol", sym.get_name(), "properties");
+		}
+	}
+}
+
+/** Compares the data types of a tpy and of an upload.
+	Types which are missing in the tpy must be implicit arrays.
+ ************************************************************************/
+static void compare_types (const tpy_file& tpy, const tpy_file& upload)
+{
+	map<stringcase, const type_record*> types;
+	for (const auto& t : tpy.get_types()) {
+		types[t.second.get_name()] = &t.second;
+	}
+	for (const auto& t : upload.get_types()) {
+		const type_record& typ = t.second;
+		auto p = types.find (typ.get_name());
+		if (p == types.end()) {
+			if (typ.get_type_description() != arraytype) {
+				mismatch ("type", typ.get_name(), "missing in tpy");
+			}
+			continue;
+		}
+		const type_record& ref = *p->second;
+		if ((typ.get_type_name() != ref.get_type_name()) ||
+			(typ.get_type_description() != ref.get_type_description())) {
+			mismatch ("type", typ.get_name(), "type name or description");
+		}
+		if (typ.get_bit_size() != ref.get_bit_size()) {
+			mismatch ("type", typ.get_name(), "bit size");
+		}
+		if ((typ.get_array_dimensions() != ref.get_array_dimensions()) ||
+			(typ.get_enum_list() != ref.get_enum_list())) {
+			mismatch ("type", typ.get_name(), "dimensions or enums");
+		}
+		if (!(typ.get_opc() == ref.get_opc())) {
+			mismatch ("type", typ.get_name(), "properties");
+		}
+		const item_list& items = typ.get_struct_list();
+		const item_list& refitems = ref.get_struct_list();
+		if (items.size() != refitems.size()) {
+			mismatch ("type", typ.get_name(), "number of items");
+			continue;
+		}
+		for (auto i = items.begin(), r = refitems.begin();
+			 i != items.end(); ++i, ++r) {
+			if ((i->get_name() != r->get_name()) ||
+				(i->get_type_name() != r->get_type_name()) ||
+				(i->get_bit_offset() != r->get_bit_offset()) ||
+				(i->get_bit_size() != r->get_bit_size()) ||
+				!(i->get_opc() == r->get_opc())) {
+				mismatch ("item", typ.get_name() + "." + i->get_name(),
+					"name, type, location or properties");
+			}
+		}
+	}
+}
+
+/** Expands all symbols into one line per record
+ ************************************************************************/
+static vector<stringcase> expand (tpy_file& tpy)
+{
+	vector<stringcase> lines;
+	auto add = [&lines] (const process_arg_tc& arg) -> bool {
+		stringcase line = arg.get_name() + " " + arg.get_type_name() + " " +
+			arg.get() + " " + arg.get_process_string();
+		opc_list opc = without_plcname (arg.get_opc());
+		for (const auto& prop : opc.get_properties()) {
+			line += " " + stringcase (to_string (prop.first).c_str()) + "=" +
+				prop.second;
+		}
+		lines.push_back (line);
+		return true;
+	};
+	tpy.process_symbols (add);
+	return lines;
+}
+
+/** Main program
+ ************************************************************************/
+int main (int argc, char *argv[])
+{
+	if (argc != 3) {
+		printf ("Usage: UploadCheck 'tpy' 'upload'\n"
+			"       Checks that a recorded ADS symbol upload decodes to the\n"
+			"       same symbols, types and records as the matching tpy file\n"
+			"       (e.g. UploadCheck\\sample.tpy UploadCheck\\sample.upload)\n");
+		return 1;
+	}
+	tpy_file tpy;
+	tpy_file upload;
+	if (!tpy.parse_file (argv[1])) {
+		fprintf (stderr, "Unable to parse %s\n", argv[1]);
+		return 1;
+	}
+	if (!upload.parse_file (argv[2])) {
+		fprintf (stderr, "Unable to decode %s\n", argv[2]);
+		return 1;
+	}
+	compare_symbols (tpy, upload);
+	compare_types (tpy, upload);
+	vector<stringcase> tpylines = expand (tpy);
+	vector<stringcase> uplines = expand (upload);
+	if (tpylines.size() != uplines.size()) {
+		mismatch ("record list", "", "number of records");
+	}
+	for (size_t i = 0; i < tpylines.size() && i < uplines.size(); ++i) {
+		if (tpylines[i] != uplines[i]) {
+			mismatch ("record", uplines[i], tpylines[i].c_str());
+		}
+	}
+
+	printf ("Symbols                           = %9d\n",
+		(int)upload.get_symbols().size());
+	printf ("Types                             = %9d\n",
+		(int)upload.get_types().size());
+	printf ("Records                           = %9d\n", (int)uplines.size());
+	printf ("Mismatches                        = %9d\n", errors);
+	return errors ? 2 : 0;
+}
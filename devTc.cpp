@@ -58,6 +58,8 @@ static bool linkTcRecord (dbCommon* pEpicsRecord, plc::BaseRecordPtr& pRecord)
 	epics->set_pEpicsRecord(pEpicsRecord);
 	// Link EPICS interface to record object
 	pRecord->set_userInterface(epics);
+	// Use private processing pool, if configured
+	epics->set_pool(ProcessPool::get_pool(epics->get_parent()));
 
 	return true;
 }
@@ -89,16 +91,137 @@ static bool linkInfoRecord (dbCommon* pEpicsRecord, plc::BaseRecordPtr& pRecord)
 	epics->set_pEpicsRecord(pEpicsRecord);
 	// Link EPICS interface to record object
 	pRecord->set_userInterface(epics);
+	// Use private processing pool, if configured
+	epics->set_pool(ProcessPool::get_pool(epics->get_parent()));
 
 	return true;
 }
 
+/* parse_number
+   Parses a decimal number of at most maxdigits digits
+ ************************************************************************/
+static const char* parse_number (const char* p, unsigned long& val, int maxdigits)
+{
+	if ((*p < '0') || (*p > '9')) {
+		return nullptr;
+	}
+	val = 0;
+	int n = 0;
+	for (; (*p >= '0') && (*p <= '9'); ++p) {
+		if (++n > maxdigits) return nullptr;
+		val = 10 * val + (*p - '0');
+	}
+	return p;
+}
+
+/* parse_plcname
+   Parses the PLC name tc://netid:port/ and returns the position 
+   following it
+ ************************************************************************/
+static const char* parse_plcname (const char* inpout, link_address& addr)
+{
+	const char* p = inpout;
+	if (strncmp (p, "tc://", 5) != 0) {
+		return nullptr;
+	}
+	p += 5;
+	// AMS net id: numbers between 0 and 255 separated by dots
+	unsigned long val;
+	for (;;) {
+		p = parse_number (p, val, 3);
+		if (!p || (val > 255)) return nullptr;
+		if (*p != '.') break;
+		++p;
+	}
+	// port
+	if (*p != ':') return nullptr;
+	p = parse_number (p + 1, val, 5);
+	if (!p || (*p != '/')) return nullptr;
+	++p;
+	addr.plcname = inpout;
+	addr.plcnamelen = p - inpout;
+	return p;
+}
+
+/** Parser for a TwinCAT link: tc://netid:port/group/offset:size
+	@param inpout Link string
+	@param addr Parsed link (return)
+	@return true if successful
+	@brief Parse TwinCat link
+ ************************************************************************/
+static bool parseTcLink (const char* inpout, link_address& addr)
+{
+	const char* p = parse_plcname (inpout, addr);
+	if (!p) return false;
+	p = parse_number (p, addr.address.indexGroup, 9);
+	if (!p || (*p != '/')) return false;
+	p = parse_number (p + 1, addr.address.indexOffset, 9);
+	if (!p || (*p != ':')) return false;
+	p = parse_number (p + 1, addr.address.length, 9);
+	if (!p || (*p != 0)) return false;
+	addr.has_address = true;
+	return true;
+}
+
+/** Parser for an info link: tc://netid:port/info/name
+	@param inpout Link string
+	@param addr Parsed link (return)
+	@return true if successful
+	@brief Parse Info link
+ ************************************************************************/
+static bool parseInfoLink (const char* inpout, link_address& addr)
+{
+	const char* p = parse_plcname (inpout, addr);
+	if (!p || (strncmp (p, "info/", 5) != 0)) return false;
+	p += 5;
+	if (!isalnum ((unsigned char)*p) && (*p != '_')) return false;
+	addr.has_address = false;
+	return true;
+}
+
 /** register_devsup::register_devsup
  ************************************************************************/
 register_devsup::register_devsup()
+	: link_num (0), link_fail (0), link_time (0.0)
+{
+	add (parseTcLink, linkTcRecord);
+	add (parseInfoLink, linkInfoRecord);
+}
+
+/** register_devsup::findRecord
+ ************************************************************************/
+bool register_devsup::findRecord (const std::stringcase& inpout, 
+	const link_address& addr, dbCommon* pEpicsRecord, 
+	plc::BaseRecordPtr& pRecord)
 {
-	add (tc_regex, linkTcRecord);
-	add (info_regex, linkInfoRecord);
+	// Records are usually sorted by PLC: try the previous one first
+	plc::BasePLCPtr plcptr = last_plc.lock();
+	if (!plcptr.get() || 
+		(plcptr->get_name().length() != addr.plcnamelen) ||
+		(strncmp (plcptr->get_name().c_str(), addr.plcname, addr.plcnamelen) != 0)) {
+		plcptr = plc::System::get().find (
+			std::stringcase (addr.plcname, addr.plcnamelen));
+		if (!plcptr.get()) {
+			printf ("PLC not found %s.\n", pEpicsRecord->name);
+			return false;
+		}
+		last_plc = plcptr;
+	}
+	// Link record object to EPICS record
+	TcComms::TcPLC* tcplc = addr.has_address ? 
+		dynamic_cast<TcComms::TcPLC*>(plcptr.get()) : nullptr;
+	if (tcplc) {
+		pRecord = tcplc->find (addr.address.indexGroup, 
+			addr.address.indexOffset, addr.address.length);
+	}
+	else {
+		pRecord = plcptr->find (inpout);
+	}
+	if (!pRecord.get()) {
+		printf("No PLC record for %s.\n", pEpicsRecord->name);
+		return false;
+	}
+	return true;
 }
 
 /** register_devsup::linkRecord
@@ -106,33 +229,63 @@ register_devsup::register_devsup()
 bool register_devsup::linkRecord (const std::stringcase& inpout, 
 	dbCommon* pEpicsRecord, plc::BaseRecordPtr& pRecord)
 {
+	register_devsup& reg = the_register_devsup;
 	if (inpout.empty() ) {
 		printf ("Error in inp field for record %s.\n", pEpicsRecord->name);
+		++reg.link_fail;
 		return false;
 	}
 
+	LARGE_INTEGER t1, t2, freq;
+	QueryPerformanceCounter (&t1);
+	bool found = false;
+	bool ret = false;
+	// Parsed links
+	link_address addr;
+	for (auto i : reg.pp_list) {
+		if ((*i.first) (inpout.c_str(), addr)) {
+			found = true;
+			ret = reg.findRecord (inpout, addr, pEpicsRecord, pRecord) &&
+				(*i.second) (pEpicsRecord, pRecord);
+			break;
+		}
+	}
+	// Links registered with a regex
 	std::smatch match;
-	for (auto i : the_register_devsup.tp_list) {
-		if (std::regex_search (inpout, match, i.first)) {
-			// Get PLC name from EPICS name string
-			BasePLCPtr plcMatch = plc::System::get().find (match[1].str().c_str());
-			if (!plcMatch.get()) {
-				printf ("PLC not found %s.\n", pEpicsRecord->name);
-				return false;
-			}
-			// Link record object to EPICS record
-			pRecord = plcMatch->find (inpout);
-			if (!pRecord.get()) {
-				printf("No PLC record for %s.\n", pEpicsRecord->name);
-				return false;
-			}
-			// Call link function
-			return i.second (pEpicsRecord, pRecord);
+	for (auto i = reg.tp_list.begin(); !found && (i != reg.tp_list.end()); ++i) {
+		if (std::regex_search (inpout, match, i->first)) {
+			found = true;
+			addr.plcname = inpout.c_str() + match.position (1);
+			addr.plcnamelen = match.length (1);
+			addr.has_address = false;
+			ret = reg.findRecord (inpout, addr, pEpicsRecord, pRecord) &&
+				i->second (pEpicsRecord, pRecord);
 		}
 	}
-	printf ("Name doesn't fit regex for %s, link field is %s.\n", 
-		pEpicsRecord->name, inpout.c_str());
-	return false;
+	if (!found) {
+		printf ("Name doesn't fit link syntax for %s, link field is %s.\n", 
+			pEpicsRecord->name, inpout.c_str());
+	}
+	QueryPerformanceCounter (&t2);
+	QueryPerformanceFrequency (&freq);
+	reg.link_time += 1000.0 * (double)(t2.QuadPart - t1.QuadPart) / (double)freq.QuadPart;
+	if (ret) ++reg.link_num; else ++reg.link_fail;
+	return ret;
+}
+
+/** register_devsup::print_link_statistics
+ ************************************************************************/
+void register_devsup::print_link_statistics()
+{
+	const register_devsup& reg = the_register_devsup;
+	if (reg.link_num + reg.link_fail == 0) {
+		return;
+	}
+	printf ("Linked %i records in %.1f ms", reg.link_num, reg.link_time);
+	if (reg.link_fail) {
+		printf (", %i failed", reg.link_fail);
+	}
+	printf ("\n");
 }
 
 /** register_devsup::the_register_devsup
@@ -144,11 +297,160 @@ register_devsup register_devsup::the_register_devsup;
  ************************************************************************/
 EpicsInterface::EpicsInterface (plc::BaseRecord& dval)
 		: Interface (dval), isPassive (false), isCallback (false),
-		pEpicsRecord (nullptr), ioscanpvt (nullptr), ioscan_inuse (0)
+		pEpicsRecord (nullptr), ioscanpvt (nullptr), ioscan_inuse (0),
+		push_pending (false), push_num (0), coalesce_num (0), drop_num (0),
+		pool (nullptr)
 {
 	memset (&callbackval, 0, sizeof (callbackval));
 }
 
+/* EpicsInterface::callback_queue_limit
+   Low priority records are deferred first, high priority records only
+   when the queue is almost full.
+ ************************************************************************/
+double EpicsInterface::callback_queue_limit[NUM_CALLBACK_PRIORITIES] =
+	{ 0.5, 0.75, 0.95 };
+
+/* EpicsInterface::get_callback_queue_limit
+ ************************************************************************/
+double EpicsInterface::get_callback_queue_limit (int pri)
+{
+	return ((pri >= 0) && (pri < NUM_CALLBACK_PRIORITIES)) ?
+		callback_queue_limit[pri] : 1.0;
+}
+
+/* EpicsInterface::set_callback_queue_limit
+ ************************************************************************/
+void EpicsInterface::set_callback_queue_limit (int pri, double limit)
+{
+	if ((pri < 0) || (pri >= NUM_CALLBACK_PRIORITIES)) return;
+	if (limit < 0.0) limit = 0.0;
+	if (limit > 1.0) limit = 1.0;
+	callback_queue_limit[pri] = limit;
+}
+
+/* EpicsInterface::is_callback_queue_congested
+ ************************************************************************/
+bool EpicsInterface::is_callback_queue_congested (int pri)
+{
+	if ((pri < 0) || (pri >= NUM_CALLBACK_PRIORITIES) ||
+		(callback_queue_limit[pri] >= 1.0)) {
+		return false;
+	}
+	// returns 0 or -1 for an unpatched EPICS base or a stopped IOC
+	int size = get_callback_queue_size (pri);
+	int used = get_callback_queue_used (pri);
+	if ((size <= 0) || (used <= 0)) {
+		return false;
+	}
+	return (double)used >= callback_queue_limit[pri] * (double)size;
+}
+
+/* EpicsInterface::get_priority
+ ************************************************************************/
+int EpicsInterface::get_priority() const
+{
+	if (isPassive) return priorityHigh;
+	return pEpicsRecord ? pEpicsRecord->prio : priorityLow;
+}
+
+/* EpicsInterface::count_push
+ ************************************************************************/
+void EpicsInterface::count_push()
+{
+	++push_num;
+	BasePLC* plc = get_parent();
+	if (plc) plc->inc_push_count();
+}
+
+/* EpicsInterface::count_coalesce
+ ************************************************************************/
+void EpicsInterface::count_coalesce()
+{
+	++coalesce_num;
+	BasePLC* plc = get_parent();
+	if (plc) plc->inc_coalesce_count();
+}
+
+/* EpicsInterface::count_drop
+ ************************************************************************/
+void EpicsInterface::count_drop()
+{
+	++drop_num;
+	BasePLC* plc = get_parent();
+	if (plc) plc->inc_drop_count();
+}
+
+/* EpicsInterface::printVal
+ ************************************************************************/
+void EpicsInterface::printVal (FILE* fp)
+{
+	fprintf (fp, "%65s  push %u, coalesce %u, drop %u\n", "",
+		push_num.load(), coalesce_num.load(), drop_num.load());
+}
+
+/** Per record update statistics of a PLC, computed once per info cycle
+ ************************************************************************/
+struct update_stats_type {
+	/// Default constructor
+	update_stats_type() : valid (false), cycle (0), num(), max() {}
+	/// Statistics have been computed
+	bool			valid;
+	/// Info cycle of the statistics
+	unsigned int	cycle;
+	/// Number of records with coalesced/dropped updates
+	int				num[2];
+	/// Largest number of coalesced/dropped updates of a record
+	unsigned int	max[2];
+	/// Name of the record with the most coalesced/dropped updates
+	std::string		name[2];
+};
+/// Mutex for the update statistics
+static std::mutex update_stats_mux;
+/// Update statistics by PLC
+static std::map<const plc::BasePLC*, update_stats_type> update_stats_list;
+
+/* EpicsInterface::get_update_stats
+   All info records of a cycle share a single walk over the records
+ ************************************************************************/
+unsigned int EpicsInterface::get_update_stats (plc::BasePLC* plc, bool drop,
+	std::string& name, int& num)
+{
+	name.clear();
+	num = 0;
+	if (!plc) return 0;
+	const TcComms::TcPLC* tc = dynamic_cast<const TcComms::TcPLC*>(plc);
+	unsigned int cycle = tc ? tc->get_info_cycle() : 0;
+	std::lock_guard<std::mutex> lock (update_stats_mux);
+	update_stats_type& stats = update_stats_list[plc];
+	if (!tc || !stats.valid || (stats.cycle != cycle)) {
+		update_stats_type cur;
+		auto walk = [&cur] (BaseRecord* prec) {
+			EpicsInterface* epics = prec ? 
+				dynamic_cast<EpicsInterface*>(prec->get_userInterface()) : nullptr;
+			if (!epics) return;
+			unsigned int n[2] = { epics->get_coalesce_num(), epics->get_drop_num() };
+			for (int i = 0; i < 2; ++i) {
+				if (!n[i]) continue;
+				++cur.num[i];
+				if (n[i] > cur.max[i]) {
+					cur.max[i] = n[i];
+					cur.name[i] = epics->pEpicsRecord ? epics->pEpicsRecord->name : 
+						prec->get_name().c_str();
+				}
+			}
+		};
+		plc->for_each (walk);
+		cur.valid = true;
+		cur.cycle = cycle;
+		stats = std::move (cur);
+	}
+	int i = drop ? 1 : 0;
+	name = stats.name[i];
+	num = stats.num[i];
+	return stats.max[i];
+}
+
 /* EpicsInterface::get_callbackRequestPending
  ************************************************************************/
 bool EpicsInterface::get_callbackRequestPending() const
@@ -169,52 +471,354 @@ void EpicsInterface::ioscan_reset (int bitnum)
 {
 	std::lock_guard<std::mutex> guard(ioscanmux);
 	std::atomic_fetch_and(&ioscan_inuse, ~(1 << bitnum));
+	// scan finished: deliver the latest value, if updates were coalesced
+	if ((ioscan_inuse.load() == 0) && push_pending.exchange (false) &&
+		get_record().UserIsDirty()) {
+		unsigned int inuse = scanIoRequest (get_ioscan());
+		std::atomic_store (&ioscan_inuse, inuse);
+		if (inuse) count_push(); else count_drop();
+	}
 }
 
 /* EpicsInterface::push
+   Overload policy:
+   - an update arriving while a request for the same record is still
+     queued is coalesced, since the record processing will read the
+     latest value anyway;
+   - if the callback queue of the record's priority is above its high
+     water mark, the update is deferred. The user dirty flag stays set,
+     so the next PLC update of the record will retry;
+   - if the request is rejected by EPICS (queue full), it is counted as
+     dropped and likewise retried with the next PLC update.
+   With a private processing pool the record is queued to the pool
+   instead, using the same coalesce/drop policy.
  ************************************************************************/
 bool EpicsInterface::push()
 {
-	static int skip = 0;
-	static int proc = 0;
+	if (!isCallback) {
+		return true;
+	}
+	// Private processing pool: bypass callback and scan threads
+	if (pool) {
+		if (push_pending.exchange (true)) {
+			count_coalesce();
+			return true;
+		}
+		if (!interruptAccept || !pool->push (this)) {
+			push_pending.store (false);
+			count_drop();
+			return false;
+		}
+		count_push();
+		return true;
+	}
+	// Output records: request a callback to read back the value
+	if (isPassive) {
+		if (callback().priority != priorityHigh) {
+			return false;
+		}
+		if (push_pending.exchange (true)) {
+			count_coalesce();
+			return true;
+		}
+		if (is_callback_queue_congested (priorityHigh)) {
+			push_pending.store (false);
+			count_drop();
+			return false;
+		}
+		if (callbackRequest(&callback()) != 0) {
+			push_pending.store (false);
+			count_drop();
+			return false;
+		}
+		count_push();
+	}
+	// Generate IO intr request
+	else {
+		std::lock_guard<std::mutex> guard(ioscanmux);
+		// scan still in progress: coalesce to the latest value
+		if (ioscan_inuse.load() != 0) {
+			push_pending.store (true);
+			count_coalesce();
+			return true;
+		}
+		if (is_callback_queue_congested (get_priority())) {
+			count_drop();
+			return false;
+		}
+		unsigned int inuse = scanIoRequest (get_ioscan());
+		std::atomic_store (&ioscan_inuse, inuse);
+		if (inuse == 0) {
+			count_drop();
+			return false;
+		}
+		count_push();
+	}
+	return true;
+}
+
+/* EpicsInterface::init_readback
+ ************************************************************************/
+void EpicsInterface::init_readback (int priority)
+{
+	callbackSetCallback (readback_callback, &callbackval);
+	callbackSetPriority (priority, &callbackval);
+	callbackSetUser (this, &callbackval);
+}
 
-	if (isCallback) {
-		
-		// Generate IO intr request
-		if (isPassive) {
-			if (callback().priority != priorityHigh) {
-				return false;
-			}
-			if (callbackRequest(&callback()) != 0) {
-				return false;
-			}
-//+			callbackRequestPending = true;
+/* EpicsInterface::readback_callback
+   Only the queued read back resets the pending flag, writes by clients 
+   leave the coalescing state alone
+ ************************************************************************/
+void EpicsInterface::readback_callback (CALLBACK* pcb)
+{
+	void* user = nullptr;
+	callbackGetUser (user, pcb);
+	EpicsInterface* epics = static_cast<EpicsInterface*>(user);
+	if (epics) {
+		epics->process();
+	}
+}
+
+/* EpicsInterface::process
+ ************************************************************************/
+void EpicsInterface::process()
+{
+	// updates arriving from now on need a new request
+	push_pending.store (false);
+	if (!pEpicsRecord || !isCallback) {
+		return;
+	}
+	dbScanLock (pEpicsRecord);
+	dbProcess (pEpicsRecord);
+	dbScanUnlock (pEpicsRecord);
+}
+
+
+/* ProcessPool static members
+ ************************************************************************/
+int ProcessPool::pool_threads = 0;
+int ProcessPool::pool_depth = 0;
+bool ProcessPool::pool_perplc = false;
+std::mutex ProcessPool::pool_mux;
+std::map<const plc::BasePLC*, ProcessPool*> ProcessPool::pool_list;
+
+/* ProcessPool::ProcessPool
+ ************************************************************************/
+ProcessPool::ProcessPool (int threads, int depth)
+	: queue (nullptr), mask (0), enqueue_pos (0), dequeue_pos (0), 
+	wakeup (nullptr), idle (0), stop (false), queue_max (0), 
+	process_num (0), latency_avg (0.0), latency_max (0.0)
+{
+	// round queue size up to a power of 2
+	size_t size = 2;
+	while ((size < (size_t)depth) && (size < 0x100000)) size <<= 1;
+	queue = new (std::nothrow) queue_entry[size];
+	if (!queue) {
+		printf ("Unable to allocate processing queue of size %u\n", (unsigned int)size);
+		return;
+	}
+	mask = size - 1;
+	for (size_t i = 0; i < size; ++i) {
+		queue[i].seq.store (i, std::memory_order_relaxed);
+		queue[i].epics = nullptr;
+		queue[i].queued = 0;
+	}
+	wakeup = CreateSemaphore (NULL, 0, LONG_MAX, NULL);
+	if (!wakeup) {
+		printf ("CreateSemaphore failed with error %d\n", GetLastError());
+		return;
+	}
+	for (int i = 0; i < threads; ++i) {
+		workers.push_back (std::thread (&ProcessPool::worker, this));
+	}
+}
+
+/* ProcessPool::~ProcessPool
+ ************************************************************************/
+ProcessPool::~ProcessPool()
+{
+	stop = true;
+	if (wakeup) {
+		ReleaseSemaphore (wakeup, (LONG)workers.size(), NULL);
+	}
+	for (auto& t : workers) {
+		if (t.joinable()) t.join();
+	}
+	if (wakeup) CloseHandle (wakeup);
+	delete [] queue;
+}
+
+/* ProcessPool::push
+   Bounded multi-producer/multi-consumer queue: each entry carries a
+   sequence number which tells producers and consumers whether the
+   entry is free or filled for the current lap.
+ ************************************************************************/
+bool ProcessPool::push (EpicsInterface* epics)
+{
+	if (!queue || !wakeup || workers.empty()) {
+		return false;
+	}
+	queue_entry* entry;
+	size_t pos = enqueue_pos.load (std::memory_order_relaxed);
+	for (;;) {
+		entry = &queue[pos & mask];
+		size_t seq = entry->seq.load (std::memory_order_acquire);
+		intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+		if (dif == 0) {
+			if (enqueue_pos.compare_exchange_weak (pos, pos + 1, 
+				std::memory_order_relaxed)) break;
+		}
+		else if (dif < 0) {
+			// queue full
+			return false;
 		}
 		else {
-			std::lock_guard<std::mutex> guard(ioscanmux);
-			if (ioscan_inuse.load() == 0) ++proc; else ++skip;
-			std::atomic_store (&ioscan_inuse, scanIoRequest(get_ioscan()));
-			/*
-			if (ioscan_inuse.load() == 0) {
-				std::lock_guard<std::mutex> guard(ioscanmux);
-				std::atomic_store(&ioscan_inuse, scanIoRequest(get_ioscan()));
-				++proc;
-				//printf("Processing %s %4.1f %%\n", record.get_name().c_str(), 100.0*(double)skip / (double)(skip + proc));
+			pos = enqueue_pos.load (std::memory_order_relaxed);
+		}
+	}
+	LARGE_INTEGER now;
+	QueryPerformanceCounter (&now);
+	entry->epics = epics;
+	entry->queued = now.QuadPart;
+	entry->seq.store (pos + 1, std::memory_order_release);
+
+	// statistics
+	int used = get_queue_used();
+	int maxused = queue_max.load (std::memory_order_relaxed);
+	while ((used > maxused) && !queue_max.compare_exchange_weak (maxused, used)) {}
+	// wake up an idle thread
+	int n = idle.load();
+	while (n > 0) {
+		if (idle.compare_exchange_weak (n, n - 1)) {
+			ReleaseSemaphore (wakeup, 1, NULL);
+			break;
+		}
+	}
+	return true;
+}
+
+/* ProcessPool::pop
+ ************************************************************************/
+bool ProcessPool::pop (EpicsInterface*& epics, LONGLONG& queued)
+{
+	queue_entry* entry;
+	size_t pos = dequeue_pos.load (std::memory_order_relaxed);
+	for (;;) {
+		entry = &queue[pos & mask];
+		size_t seq = entry->seq.load (std::memory_order_acquire);
+		intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+		if (dif == 0) {
+			if (dequeue_pos.compare_exchange_weak (pos, pos + 1, 
+				std::memory_order_relaxed)) break;
+		}
+		else if (dif < 0) {
+			// queue empty
+			return false;
+		}
+		else {
+			pos = dequeue_pos.load (std::memory_order_relaxed);
+		}
+	}
+	epics = entry->epics;
+	queued = entry->queued;
+	entry->seq.store (pos + mask + 1, std::memory_order_release);
+	return true;
+}
+
+/* ProcessPool::get_queue_used
+ ************************************************************************/
+int ProcessPool::get_queue_used() const
+{
+	size_t in = enqueue_pos.load (std::memory_order_relaxed);
+	size_t out = dequeue_pos.load (std::memory_order_relaxed);
+	return (in > out) ? (int)(in - out) : 0;
+}
+
+/* ProcessPool::update_latency
+ ************************************************************************/
+void ProcessPool::update_latency (double ms)
+{
+	double avg = latency_avg.load (std::memory_order_relaxed);
+	while (!latency_avg.compare_exchange_weak (avg, avg + (ms - avg) / 64.0)) {}
+	double maxms = latency_max.load (std::memory_order_relaxed);
+	while ((ms > maxms) && !latency_max.compare_exchange_weak (maxms, ms)) {}
+}
+
+/* ProcessPool::worker
+ ************************************************************************/
+void ProcessPool::worker()
+{
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency (&freq);
+	EpicsInterface* epics;
+	LONGLONG queued;
+	while (!stop) {
+		if (!pop (epics, queued)) {
+			// register as idle, then check again to not miss a push
+			++idle;
+			if (pop (epics, queued)) {
+				// a producer may have taken our idle count already
+				int n = idle.load();
+				while ((n > 0) && !idle.compare_exchange_weak (n, n - 1)) {}
+				if (n == 0) WaitForSingleObject (wakeup, INFINITE);
 			}
 			else {
-				// skip  ioscan due to overload
-				++skip;
-				//std::lock_guard<std::mutex> guard(ioscanmux);
-				//std::atomic_store(&ioscan_inuse, 0);
-				//if (skip % 100 == 0) {
-				//	printf("Skipping %s %4.1f %%\n", record.get_name().c_str(), 100.0*(double)skip / (double)(skip + proc));
-				//}
+				WaitForSingleObject (wakeup, INFINITE);
+				continue;
 			}
-			*/
 		}
+		LARGE_INTEGER now;
+		QueryPerformanceCounter (&now);
+		update_latency (1000.0 * (double)(now.QuadPart - queued) / (double)freq.QuadPart);
+		epics->process();
+		++process_num;
+	}
+}
 
+/* ProcessPool::configure
+ ************************************************************************/
+void ProcessPool::configure (int threads, int depth, bool perplc)
+{
+	std::lock_guard<std::mutex> lock (pool_mux);
+	pool_threads = threads > 0 ? threads : 0;
+	pool_depth = depth > 0 ? depth : 0;
+	pool_perplc = perplc;
+}
+
+/* ProcessPool::get_pool
+ ************************************************************************/
+ProcessPool* ProcessPool::get_pool (const plc::BasePLC* plc)
+{
+	std::lock_guard<std::mutex> lock (pool_mux);
+	if (pool_threads <= 0) {
+		return nullptr;
 	}
-	return true;
+	if (!pool_perplc) plc = nullptr;
+	auto p = pool_list.find (plc);
+	if (p != pool_list.end()) {
+		return p->second;
+	}
+	ProcessPool* pool = new (std::nothrow) ProcessPool (pool_threads, pool_depth);
+	if (pool && pool->workers.empty()) {
+		delete pool;
+		pool = nullptr;
+	}
+	if (!pool) {
+		printf ("Unable to create processing pool, using EPICS callbacks\n");
+	}
+	pool_list[plc] = pool;
+	return pool;
+}
+
+/* ProcessPool::find_pool
+ ************************************************************************/
+ProcessPool* ProcessPool::find_pool (const plc::BasePLC* plc)
+{
+	std::lock_guard<std::mutex> lock (pool_mux);
+	if (!pool_perplc) plc = nullptr;
+	auto p = pool_list.find (plc);
+	return (p != pool_list.end()) ? p->second : nullptr;
 }
 
 
@@ -306,6 +910,50 @@ int EpicsInterface::get_callback_queue_free (int pri)
 
 
 extern "C" {
+	int get_process_pool_threads(const plc::BasePLC* plc) {
+		ProcessPool* pool = ProcessPool::find_pool (plc);
+		return pool ? pool->get_threads() : 0;
+	}
+	int get_process_queue_size(const plc::BasePLC* plc) {
+		ProcessPool* pool = ProcessPool::find_pool (plc);
+		return pool ? pool->get_queue_size() : 0;
+	}
+	int get_process_queue_used(const plc::BasePLC* plc) {
+		ProcessPool* pool = ProcessPool::find_pool (plc);
+		return pool ? pool->get_queue_used() : 0;
+	}
+	int get_process_queue_max(const plc::BasePLC* plc) {
+		ProcessPool* pool = ProcessPool::find_pool (plc);
+		return pool ? pool->get_queue_max() : 0;
+	}
+	double get_process_latency(const plc::BasePLC* plc) {
+		ProcessPool* pool = ProcessPool::find_pool (plc);
+		return pool ? pool->get_latency() : 0.0;
+	}
+	double get_process_latency_max(const plc::BasePLC* plc) {
+		ProcessPool* pool = ProcessPool::find_pool (plc);
+		return pool ? pool->get_latency_max() : 0.0;
+	}
+	int get_update_record_num(plc::BasePLC* plc, int drop) {
+		std::string name;
+		int num = 0;
+		EpicsInterface::get_update_stats (plc, drop != 0, name, num);
+		return num;
+	}
+	unsigned int get_update_record_max(plc::BasePLC* plc, int drop) {
+		std::string name;
+		int num = 0;
+		return EpicsInterface::get_update_stats (plc, drop != 0, name, num);
+	}
+	void get_update_record_name(plc::BasePLC* plc, int drop, char* name, int size) {
+		std::string s;
+		int num = 0;
+		EpicsInterface::get_update_stats (plc, drop != 0, s, num);
+		if (name && (size > 0)) {
+			strncpy (name, s.c_str(), size - 1);
+			name[size - 1] = 0;
+		}
+	}
 	int get_callback_queue_size(int pri) {
 		return EpicsInterface::get_callback_queue_size(pri);
 	}
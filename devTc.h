@@ -22,20 +22,25 @@
  ************************************************************************/
 namespace DevTc {
 
-/** Callback function to process EPICS out record
-	@brief Callback for output record
+/** Parsed INP/OUT link of a TwinCAT or info record. The PLC name 
+	points into the link string and is not zero terminated.
+	@brief Parsed link
  ************************************************************************/
-	
-/// Regex for indentifying TwinCAT records
-const std::regex tc_regex (
-	"((tc)://((\\b([0-9]|[1-9][0-9]|1[0-9][0-9]|2[0-4][0-9]|25[0-5])\\.?)+:(8[0-9][0-9]))/)(\\d{1,9})/(\\d{1,9}):(\\d{1,9})");
-
-/// Regex for indentifying info records
-const std::regex info_regex(
-	"((tc)://((\\b([0-9]|[1-9][0-9]|1[0-9][0-9]|2[0-4][0-9]|25[0-5])\\.?)+:(8[0-9][0-9]))/)(info)/([A-Za-z0-9_]+)");
+struct link_address
+{
+	/// PLC name, i.e., tc://netid:port/
+	const char*		plcname;
+	/// Length of PLC name
+	size_t			plcnamelen;
+	/// true if the link contains an ADS address (group/offset:size)
+	bool			has_address;
+	/// ADS address: index group, index offset and size
+	TcComms::DataPar	address;
+};
 
 /** This is a class for managing device support for multiple record
-    types, such as TwinCAT/ADS and Info.
+    types, such as TwinCAT/ADS and Info. Links are recognized either by
+	a parser function or, for other link types, by a regex.
     @brief Device support registration.
  ************************************************************************/
 class register_devsup
@@ -43,14 +48,23 @@ class register_devsup
 public:
 	/// Type descriping the link function
 	typedef auto link_func (dbCommon* pEpicsRecord, plc::BaseRecordPtr& pRecord) -> bool;
+	/// Type describing the parser function
+	typedef auto parse_func (const char* inpout, link_address& addr) -> bool;
 	/// pair of pattern and link function
 	typedef std::pair<std::regex, link_func&> test_pattern;
 	/// list of pattern/link functions
 	typedef std::vector<test_pattern> test_pattern_list;
+	/// pair of parser and link function
+	typedef std::pair<parse_func*, link_func*> parse_pattern;
+	/// list of parser/link functions
+	typedef std::vector<parse_pattern> parse_pattern_list;
 
 	/// Register a pattern/link function
 	static void add (const std::regex& rgx, link_func& func) {
 		the_register_devsup.tp_list.push_back (test_pattern (rgx, func)); }
+	/// Register a parser/link function
+	static void add (parse_func& parse, link_func& func) {
+		the_register_devsup.pp_list.push_back (parse_pattern (&parse, &func)); }
 
 	/// Go through list and call first link function which matches the pattern
 	/// Used to link epics records with internal records.
@@ -62,6 +76,15 @@ public:
 	static bool linkRecord (const std::stringcase& inpout, dbCommon* pEpicsRecord, 
 		plc::BaseRecordPtr& pRecord);
 
+	/// Get number of linked records
+	static int get_link_num() { return the_register_devsup.link_num; }
+	/// Get number of records which failed to link
+	static int get_link_fail() { return the_register_devsup.link_fail; }
+	/// Get time spent linking records in ms
+	static double get_link_time() { return the_register_devsup.link_time; }
+	/// Print link statistics to stdout
+	static void print_link_statistics();
+
 protected:
 	/// Default constructor (adds linkTcRecord entry)
 	register_devsup();
@@ -70,8 +93,27 @@ protected:
 	/// Disabled assignment operator
 	register_devsup& operator= (const register_devsup&);
 
+	/// Find the record for a parsed link
+	///	@param inpout Value of INP/OUT field
+	/// @param addr Parsed link
+	/// @param pEpicsRecord Pointer to EPICS record
+	/// @param pRecord Pointer to a base record (return)
+	/// @return true if found
+	bool findRecord (const std::stringcase& inpout, const link_address& addr,
+		dbCommon* pEpicsRecord, plc::BaseRecordPtr& pRecord);
+
 	/// list of pattern and links
 	test_pattern_list	tp_list;
+	/// list of parsers and links
+	parse_pattern_list	pp_list;
+	/// PLC of the last linked record, not kept alive by the register
+	std::weak_ptr<plc::BasePLC>	last_plc;
+	/// Number of linked records
+	int					link_num;
+	/// Number of records which failed to link
+	int					link_fail;
+	/// Time spent linking in ms
+	double				link_time;
 	/// the one global instance of the register class
 	static register_devsup the_register_devsup;
 };
@@ -80,6 +122,8 @@ protected:
  ************************************************************************/
 /** @{ */
 
+class ProcessPool;
+
 /** This is a class for an EPICS Interface
     @brief Epics interface class.
  ************************************************************************/
@@ -125,11 +169,60 @@ public:
 	/// Set pointer to io scan list
 	void set_ioscan (const IOSCANPVT ioscan) {
 		ioscanpvt = ioscan; }
+	/// Get the private processing pool (nullptr: use EPICS callbacks)
+	ProcessPool* get_pool() const {
+		return pool; }
+	/// Set the private processing pool
+	void set_pool (ProcessPool* p) {
+		pool = p; }
+	/// Processes the EPICS record (called by the processing pool)
+	void process();
 
 	/// Makes a call to the EPICS dbProcess function
 	virtual bool push() override;
 	/// Does nothing
 	virtual bool pull() override { return true; }
+	/// Print push statistics to file
+	/// @param fp File pointer
+	virtual void printVal (FILE* fp) override;
+	/// Get the callback priority of the EPICS record
+	virtual int get_priority() const override;
+
+	/// Set up the read back callback of an output record
+	/// @param priority Callback priority
+	void init_readback (int priority);
+	/// Get number of callback/scan requests issued for this record
+	unsigned int get_push_num() const { return push_num; }
+	/// Get number of updates coalesced into an already queued request
+	unsigned int get_coalesce_num() const { return coalesce_num; }
+	/// Get number of updates deferred or rejected due to a full queue
+	unsigned int get_drop_num() const { return drop_num; }
+	/** Get the per record update statistics of a PLC. The records are
+		walked once per info cycle, later calls return the cached result.
+		@param plc PLC whose records are examined
+		@param drop Deferred/dropped updates if true, coalesced updates otherwise
+		@param name Name of the EPICS record with the most updates (return)
+		@param num Number of records with at least one update (return)
+		@return Largest number of updates of a single record */
+	static unsigned int get_update_stats (plc::BasePLC* plc, bool drop,
+		std::string& name, int& num);
+
+	/** Get the callback queue high water mark for a given priority.
+		When the usage of the callback queue exceeds this fraction,
+		records of this priority are deferred to the next PLC update.
+		Lower priorities have lower limits, so they are deferred first.
+		@param pri Priority of ring buffer
+		@return Usage limit between 0 and 1 */
+	static double get_callback_queue_limit (int pri);
+	/** Set the callback queue high water mark for a given priority.
+		@param pri Priority of ring buffer
+		@param limit Usage limit between 0 and 1 (1 = never defer) */
+	static void set_callback_queue_limit (int pri, double limit);
+	/// Checks, if the callback queue of the given priority is above
+	/// the high water mark
+	/// @param pri Priority of ring buffer
+	/// @return true if records of this priority should be deferred
+	static bool is_callback_queue_congested (int pri);
 
 	/** Get the size of the callback ring buffer
 		For this function to return a valid value the EPICS
@@ -186,6 +279,15 @@ public:
 protected:
 	/// Reset ioscan use flag
 	void ioscan_reset(int bitnum);
+	/// Count a push in this record and in the parent PLC
+	void count_push();
+	/// Read back callback, processes the record and resets the pending flag
+	static void readback_callback (CALLBACK* pcb);
+	/// Count a coalesced update in this record and in the parent PLC
+	void count_coalesce();
+	/// Count a deferred/dropped update in this record and in the parent PLC
+	void count_drop();
+
 	/** Bool indicating passive scan
 		true : EPICS record SCAN field is set to PASSIVE */
 	bool				isPassive;
@@ -200,8 +302,137 @@ protected:
 	IOSCANPVT			ioscanpvt;
 	/// Scan in progress (bit encoded value from priorities)
 	std::atomic<unsigned int>	ioscan_inuse;
+	/// A request is queued (output records) or an update was
+	/// coalesced while the scan was in progress (I/O Intr records)
+	std::atomic<bool>	push_pending;
+	/// Number of issued requests
+	std::atomic<unsigned int>	push_num;
+	/// Number of coalesced updates
+	std::atomic<unsigned int>	coalesce_num;
+	/// Number of deferred or dropped updates
+	std::atomic<unsigned int>	drop_num;
 	/// Callback structure
 	CALLBACK			callbackval;
+	/// Private processing pool
+	ProcessPool*		pool;
+
+	/// Callback queue high water marks by priority
+	static double		callback_queue_limit[NUM_CALLBACK_PRIORITIES];
+};
+
+/** This is a class for a private pool of threads which process tcIoc
+	records directly instead of going through the EPICS callback and 
+	scan threads which are shared with all other drivers. Records are
+	passed to the threads by a bounded lock-free queue. A pool is either
+	shared by all PLCs of the IOC or private to a single PLC.
+    @brief Record processing pool.
+ ************************************************************************/
+class ProcessPool
+{
+public:
+	/// Constructor
+	/// @param threads Number of processing threads
+	/// @param depth Queue depth (rounded up to a power of 2)
+	ProcessPool (int threads, int depth);
+	/// Destructor
+	~ProcessPool();
+
+	/// Queue a record for processing
+	/// @param epics EPICS interface of the record
+	/// @return true if queued, false if the pool isn't running or full
+	bool push (EpicsInterface* epics);
+
+	/// Get number of processing threads
+	int get_threads() const { return (int)workers.size(); }
+	/// Get size of the queue
+	int get_queue_size() const { return (int)mask + 1; }
+	/// Get the number of queued records
+	int get_queue_used() const;
+	/// Get the maximum number of queued records
+	int get_queue_max() const { return queue_max; }
+	/// Get number of processed records
+	unsigned int get_process_num() const { return process_num; }
+	/// Get the average latency between queuing and processing in ms
+	double get_latency() const { return latency_avg; }
+	/// Get the maximum latency between queuing and processing in ms
+	double get_latency_max() const { return latency_max; }
+	/// Reset the maximum queue depth and latency
+	void reset_max() { queue_max = 0; latency_max = 0.0; }
+
+	/// Configure the processing pools, must be called before iocInit
+	/// @param threads Number of threads per pool (0 = use EPICS callbacks)
+	/// @param depth Queue depth of each pool
+	/// @param perplc true for one pool per PLC, false for one per IOC
+	static void configure (int threads, int depth, bool perplc);
+	/// Get the pool for a PLC, creates it if necessary
+	/// @param plc PLC of the record
+	/// @return Processing pool, nullptr if not configured
+	static ProcessPool* get_pool (const plc::BasePLC* plc);
+	/// Find the pool of a PLC
+	/// @param plc PLC of the record
+	/// @return Processing pool, nullptr if none was created
+	static ProcessPool* find_pool (const plc::BasePLC* plc);
+
+protected:
+	/// Disabled copy constructor
+	ProcessPool (const ProcessPool&);
+	/// Disabled assignment operator
+	ProcessPool& operator= (const ProcessPool&);
+
+	/// Queue entry
+	struct queue_entry {
+		/// Sequence number for lock-free access
+		std::atomic<size_t>	seq;
+		/// Queued record
+		EpicsInterface*		epics;
+		/// Performance counter at time of queuing
+		LONGLONG			queued;
+	};
+	/// Get next record from the queue
+	/// @param epics Queued record (return)
+	/// @param queued Performance counter at time of queuing (return)
+	/// @return true if successful, false if queue is empty
+	bool pop (EpicsInterface*& epics, LONGLONG& queued);
+	/// Thread function processing queued records
+	void worker();
+	/// Update latency statistics
+	void update_latency (double ms);
+
+	/// Queue entries
+	queue_entry*		queue;
+	/// Queue size - 1
+	size_t				mask;
+	/// Enqueue position
+	std::atomic<size_t>	enqueue_pos;
+	/// Dequeue position
+	std::atomic<size_t>	dequeue_pos;
+	/// Semaphore for waking up idle threads
+	HANDLE				wakeup;
+	/// Number of idle threads waiting for the semaphore
+	std::atomic<int>	idle;
+	/// Set when the threads should stop
+	std::atomic<bool>	stop;
+	/// Processing threads
+	std::vector<std::thread>	workers;
+	/// Maximum number of queued records
+	std::atomic<int>	queue_max;
+	/// Number of processed records
+	std::atomic<unsigned int>	process_num;
+	/// Average latency in ms (exponential moving average)
+	std::atomic<double>	latency_avg;
+	/// Maximum latency in ms
+	std::atomic<double>	latency_max;
+
+	/// Number of threads per pool
+	static int			pool_threads;
+	/// Queue depth of a pool
+	static int			pool_depth;
+	/// One pool per PLC
+	static bool			pool_perplc;
+	/// Mutex for pool list
+	static std::mutex	pool_mux;
+	/// List of pools by PLC (nullptr for the IOC wide pool)
+	static std::map<const plc::BasePLC*, ProcessPool*> pool_list;
 };
 
 
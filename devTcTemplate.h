@@ -674,7 +674,7 @@ long devTcDefOut<RecType>::init_write_record (rec_type_ptr prec)
 	epics->set_isCallback(true); // readwrite record: need to generate callback to do a read
 	epics->set_isPassive(true);
 	// Set parameters for generating callbacks
-	callbackSetProcess(&(epics->callback()), priorityHigh, prec);
+	epics->init_readback (priorityHigh);
 
 	return 0;
 }
@@ -1,6 +1,7 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include "drvTc.h"
 #include "ParseTpy.h"
+#include "ParseTpyConst.h"
 #include "TpyToEpics.h"
 #include "TpyToEpicsConst.h"
 #include "infoPlc.h"
@@ -17,7 +18,11 @@
 #include "waveformRecord.h"
 #include "initHooks.h"
 #include "tcComms.h"
+#include "devTc.h"
 #include "epicsExit.h"
+#include "epicsString.h"
+#include <future>
+#include <memory>
 #undef _CRT_SECURE_NO_WARNINGS
 
 /** @file drvTc.cpp
@@ -54,6 +59,13 @@ static const iocshArg tcAliasArg1					= {"Replacement rules", iocshArgString};
 static const iocshArg tcInfoPrefixArg0				= {"Prefix for info PLC records", iocshArgString};
 static const iocshArg tcPrintValsArg0				= {"emptyarg", iocshArgString };
 static const iocshArg tcPrintValArg0				= {"Variable name (accepts wildcards)", iocshArgString};
+static const iocshArg tcSetCallbackLimitArg0		= {"Callback priority (0=low, 1=medium, 2=high)", iocshArgString};
+static const iocshArg tcSetCallbackLimitArg1		= {"Callback queue usage limit in percent", iocshArgString};
+static const iocshArg tcSetProcessPoolArg0			= {"Number of processing threads (0 = EPICS callbacks)", iocshArgString};
+static const iocshArg tcSetProcessPoolArg1			= {"Processing queue depth", iocshArgString};
+static const iocshArg tcSetProcessPoolArg2			= {"Pool per 'ioc' or per 'plc'", iocshArgString};
+static const iocshArg tcSetRepublishRateArg0		= {"Records per second republished after a connection change", iocshArgString};
+static const iocshArg tcWaitLoadedArg0				= {"emptyarg", iocshArgString };
 
 static const iocshArg* const  tcLoadRecordsArg[2]   = {&tcLoadRecordsArg0, &tcLoadRecordsArg1};
 static const iocshArg* const  tcSetScanRateArg[2]   = {&tcSetScanRateArg0, &tcSetScanRateArg1};
@@ -63,8 +75,14 @@ static const iocshArg* const  tcAliasArg[2]			= {&tcAliasArg0, &tcAliasArg1};
 static const iocshArg* const  tcInfoPrefixArg[1]	= {&tcInfoPrefixArg0};
 static const iocshArg* const  tcPrintValsArg[1]		= {&tcPrintValsArg0};
 static const iocshArg* const  tcPrintValArg[1]		= {&tcPrintValArg0};
+static const iocshArg* const  tcSetCallbackLimitArg[2]	= {&tcSetCallbackLimitArg0, &tcSetCallbackLimitArg1};
+static const iocshArg* const  tcSetProcessPoolArg[3]	= {&tcSetProcessPoolArg0, &tcSetProcessPoolArg1, &tcSetProcessPoolArg2};
+static const iocshArg* const  tcSetRepublishRateArg[1]	= {&tcSetRepublishRateArg0};
+static const iocshArg* const  tcWaitLoadedArg[1]		= {&tcWaitLoadedArg0};
 
 static const iocshFuncDef tcLoadRecordsFuncDef      = {"tcLoadRecords", 2, tcLoadRecordsArg};
+static const iocshFuncDef tcLoadRecordsAsyncFuncDef = {"tcLoadRecordsAsync", 2, tcLoadRecordsArg};
+static const iocshFuncDef tcWaitLoadedFuncDef		= {"tcWaitLoaded", 1, tcWaitLoadedArg};
 static const iocshFuncDef tcSetScanRateFuncDef	    = {"tcSetScanRate", 2, tcSetScanRateArg};
 static const iocshFuncDef tcListFuncDef				= {"tcGenerateList", 2, tcListArg};
 static const iocshFuncDef tcMacroFuncDef            = {"tcGenerateMacros", 2, tcMacroArg};
@@ -72,6 +90,9 @@ static const iocshFuncDef tcAliasFuncDef            = {"tcSetAlias", 2, tcAliasA
 static const iocshFuncDef tcInfoPrefixFuncDef		= {"tcInfoPrefix", 1, tcInfoPrefixArg};
 static const iocshFuncDef tcPrintValsFuncDef        = {"tcPrintVals", 1, tcPrintValsArg};
 static const iocshFuncDef tcPrintValFuncDef			= {"tcPrintVal", 1, tcPrintValArg};
+static const iocshFuncDef tcSetCallbackLimitFuncDef	= {"tcSetCallbackLimit", 2, tcSetCallbackLimitArg};
+static const iocshFuncDef tcSetProcessPoolFuncDef	= {"tcSetProcessPool", 3, tcSetProcessPoolArg};
+static const iocshFuncDef tcSetRepublishRateFuncDef	= {"tcSetRepublishRate", 1, tcSetRepublishRateArg};
 
 /// Tuple for filnemae, rule and list processing 
 typedef std::tuple<std::stringcase, std::stringcase, 
@@ -86,6 +107,7 @@ typedef std::vector<dirname_arg_macro_tuple> tc_macro_def;
 
 static int scanrate = TcComms::default_scanrate;
 static int multiple = TcComms::default_multiple;
+static int republishrate = TcComms::default_republish_rate;
 static std::stringcase tc_alias;
 static ParseUtil::replacement_table tc_replacement_rules;
 static tc_listing_def tc_lists;
@@ -103,22 +125,46 @@ public:
 	/// @param rules Replacement rules
 	/// @param l Pointer to list definitions
 	/// @param m Pointer to macro definition
+	/// @param cache Output cache of the database (nullptr for none)
 	explicit epics_tc_db_processing (TcComms::TcPLC& p,
 		ParseUtil::replacement_table& rules,
-		tc_listing_def* l = nullptr, tc_macro_def* m = nullptr)
-		: plc (&p), invnum (0), lists (l), macros (m) { 
+		tc_listing_def* l = nullptr, tc_macro_def* m = nullptr,
+		const EpicsTpy::output_cache* cache = nullptr)
+		: plc (&p), invnum (0), lists (l), macros (m), 
+		direct_load (false), db_file (true) { 
 			device_support = device_support_tc_name; 
 			set_rule_table (rules);
-			init_lists(); init_macros(); }
+			init_lists (cache); init_macros (cache); }
 	~epics_tc_db_processing() { 
 		done_lists(); done_macros(); }
 
+	/// Parse a command line
+	/// Same as epics_db_processing::getopt, but also handles:
+	///
+	/// /dl: Create the records directly in the EPICS database
+	/// /dn: Do not write a .db file, when records are created directly
+	/// @param argc Number of command line arguments
+	/// @param argv List of command line arguments, same format as in main()
+	/// @param argp Excluded/processed arguments (in/out), array length must be argc
+	/// @return Number of arguments processed
+	int getopt (int argc, const char* const argv[], bool argp[] = 0);
+
+	/// Are records created directly in the EPICS database?
+	bool is_direct_load() const { return direct_load; }
+	/// Is the .db file written?
+	bool is_db_file() const { return db_file || !direct_load; }
+
 	/// Process a variable
 	/// @param arg Process argument describign the variable and type
 	/// @return True if successful
 	bool operator() (const ParseUtil::process_arg& arg);
 	/// Flush output files
 	void flush();
+	/// Flush and wait until the macro files are written
+	/// @return True if all macro files were written
+	bool wait_written();
+	/// Write the output cache manifests of listings and macros
+	void update_output_cache();
 
 	/// Get number of EPICS records without tc records
 	int get_invalid_records() const { return invnum; }
@@ -134,8 +180,8 @@ protected:
 	/// Disable assignment operator
 	epics_tc_db_processing& operator= (const epics_tc_db_processing&);
 
-	/// Init lists
-	void init_lists();
+	/// Init lists, unchanged listings are skipped
+	void init_lists (const EpicsTpy::output_cache* cache = nullptr);
 	/// Cleanup lists
 	void done_lists();
 	/// Process all listings
@@ -150,7 +196,7 @@ protected:
 		const ParseUtil::process_arg& arg);
 
 	/// Init macros
-	void init_macros();
+	void init_macros (const EpicsTpy::output_cache* cache = nullptr);
 	/// Cleanup macros
 	void done_macros();
 	/// Process all macros
@@ -172,16 +218,310 @@ protected:
 	tc_macro_def*		macros;
 	/// Number of EPICS records without tc records
 	int					invnum;
+	/// Create records directly in the EPICS database
+	bool				direct_load;
+	/// Write the .db file
+	bool				db_file;
+	/// Output caches of the listings
+	std::vector<EpicsTpy::output_cache>	list_caches;
+	/// Output caches of the macros
+	std::vector<EpicsTpy::output_cache>	macro_caches;
+};
+
+/** Class for creating EPICS records directly through the static 
+	database access library, instead of writing them to a .db file 
+	and loading it with dbLoadRecords
+	@brief EPICS static database record sink
+ ************************************************************************/
+class epics_dbstatic_sink : public EpicsTpy::epics_record_sink {
+public:
+	/// Default constructor
+	/// @param defer Collect the records and create them later with create_deferred
+	explicit epics_dbstatic_sink (bool defer = false) 
+		: active (false), valid (false), errors (0), deferred (defer) {}
+	/// Destructor
+	~epics_dbstatic_sink() { record_end(); }
+
+	/// Start a new record
+	bool record_begin (const std::stringcase& rtype, 
+		const std::string& name) override;
+	/// Set a field of the current record
+	bool record_field (const std::stringcase& name, 
+		const std::stringcase& val) override;
+	/// Finish the current record
+	bool record_end() override;
+
+	/// Create the collected records, must be called from the IOC shell thread
+	/// @return True if successful
+	bool create_deferred();
+
+	/// Get number of errors
+	int get_errors() const { return errors; }
+
+protected:
+	/// Disable copy constructor
+	epics_dbstatic_sink (const epics_dbstatic_sink&);
+	/// Disable assignment operator
+	epics_dbstatic_sink& operator= (const epics_dbstatic_sink&);
+
+	/// List of field name and value pairs
+	typedef std::vector<std::pair<std::stringcase, std::stringcase>> field_list;
+	/// Tuple of record type, record name and fields
+	typedef std::tuple<std::stringcase, std::string, field_list> deferred_record;
+
+	/// Database entry of the current record
+	DBENTRY		entry;
+	/// Entry is initialized
+	bool		active;
+	/// Current record was created
+	bool		valid;
+	/// Number of errors
+	int			errors;
+	/// Records are collected instead of created
+	bool		deferred;
+	/// Collected records
+	std::vector<deferred_record>	records;
+};
+
+/** Class for collecting the addresses of TCat symbols when a tpy file 
+	is reloaded. The symbol names are generated the same way as the names 
+	of the TCat interfaces by epics_tc_db_processing.
+	@brief TCat symbol reload processing
+ ************************************************************************/
+class tc_reload_processing : public ParseUtil::replacement_rules {
+public:
+	/// Constructor
+	/// @param rules Replacement rules
+	/// @param s Map of symbols (return)
+	tc_reload_processing (const ParseUtil::replacement_table& rules,
+		TcComms::tc_symbol_map& s)
+		: replacement_rules (rules), symbols (&s) {}
+
+	/// Process a variable
+	/// @param arg Process argument describign the variable and type
+	/// @return True if successful
+	bool operator() (const ParseUtil::process_arg_tc& arg) {
+		std::stringcase tcatname = arg.get_alias();
+		if (HasRules()) {
+			tcatname = apply_replacement_rules (tcatname);
+		}
+		TcComms::tc_symbol_info& info = (*symbols)[tcatname];
+		info.addr.indexGroup = arg.get_igroup();
+		info.addr.indexOffset = arg.get_ioffset();
+		info.addr.length = arg.get_bytesize();
+		info.type = arg.get_type_name();
+		return true; }
+
+protected:
+	/// Pointer to map of symbols
+	TcComms::tc_symbol_map*	symbols;
+};
+
+/** Class for loading a tpy file in two steps. The tpy file is parsed, 
+	the records are generated and the requests are optimized by prepare, 
+	which can run on a background thread. The PLC is started and the 
+	EPICS database is loaded by load on the IOC shell thread.
+	@brief Load TwinCAT records
+ ************************************************************************/
+class tc_load_records {
+public:
+	/// Constructor, takes over the alias, rules, listings, macros and
+	/// info prefix which were defined for this tpy file
+	/// @param tpy Name of the tpy file
+	/// @param opts Option arguments
+	/// @param defer Collect records created with /dl until load is called
+	tc_load_records (const char* tpy, const char* opts, bool defer = false);
+	/// Parse the tpy file, generate the records and optimize requests
+	/// @return True if successful
+	bool prepare();
+	/// Start the PLC and load the EPICS database
+	/// @return True if successful
+	bool load();
+
+	/// Get the name of the tpy file
+	const std::stringcase& get_tpyname() const { return tpyname; }
+
+protected:
+	/// Disable copy constructor
+	tc_load_records (const tc_load_records&);
+	/// Disable assignment operator
+	tc_load_records& operator= (const tc_load_records&);
+
+	/// Name of the tpy file
+	std::stringcase		tpyname;
+	/// Option arguments
+	std::stringcase		reloadopts;
+	/// Alias name
+	std::stringcase		alias;
+	/// Replacement rules
+	ParseUtil::replacement_table	rules;
+	/// Listings
+	tc_listing_def		listings;
+	/// Macros
+	tc_macro_def		macros;
+	/// Prefix of info records
+	std::stringcase		infoprefix;
+	/// Scan rate
+	int					rate;
+	/// Multiple of the scan rate for EPICS updates
+	int					rate_multiple;
+	/// Republish rate
+	int					republish_rate;
+	/// Export all variables
+	bool				export_all;
+	/// Name of the db file
+	std::stringcase		outfilename;
+	/// PLC, until it is adopted by the system (a PLC which failed to load
+	/// stays in the list of PLC instances and is never deleted)
+	TcComms::TcPLC*		tcplc;
+	/// Records are created directly
+	bool				direct_load;
+	/// Sink for creating records directly
+	epics_dbstatic_sink	dbsink;
 };
 
+/// Tuple of a tpy file load and its background result
+typedef std::pair<std::unique_ptr<tc_load_records>, 
+				  std::future<bool>> tc_load_pending;
+/// List of tpy files loaded by tcLoadRecordsAsync
+static std::vector<tc_load_pending> tc_pending_loads;
+
 /// @cond Doxygen_Suppress
 
+/* epics_dbstatic_sink::record_begin
+ ************************************************************************/
+bool epics_dbstatic_sink::record_begin (const std::stringcase& rtype, 
+	const std::string& name)
+{
+	record_end();
+	if (deferred) {
+		records.emplace_back (rtype, name, field_list());
+		valid = true;
+		return true;
+	}
+	if (!pdbbase) {
+		printf ("No database definition loaded for record %s\n", name.c_str());
+		++errors;
+		return false;
+	}
+	dbInitEntry (pdbbase, &entry);
+	active = true;
+	valid = !dbFindRecordType (&entry, rtype.c_str()) &&
+		!dbCreateRecord (&entry, name.c_str());
+	if (!valid) {
+		printf ("Unable to create record %s of type %s\n", 
+			name.c_str(), rtype.c_str());
+		++errors;
+	}
+	return valid;
+}
+
+/* epics_dbstatic_sink::record_field
+ ************************************************************************/
+bool epics_dbstatic_sink::record_field (const std::stringcase& name, 
+	const std::stringcase& val)
+{
+	if (!valid) {
+		return false;
+	}
+	if (deferred) {
+		get<2>(records.back()).emplace_back (name, val);
+		return true;
+	}
+	// translate escape sequences like dbLoadRecords does for quoted values;
+	// no macros are expanded since the .db file is loaded without any
+	std::vector<char> buf (val.size() + 1);
+	dbTranslateEscape (buf.data(), val.c_str());
+	if (dbFindField (&entry, name.c_str()) || 
+		dbPutString (&entry, buf.data())) {
+		printf ("Unable to set field %s of record %s\n", 
+			name.c_str(), dbGetRecordName (&entry));
+		++errors;
+		return false;
+	}
+	return true;
+}
+
+/* epics_dbstatic_sink::record_end
+ ************************************************************************/
+bool epics_dbstatic_sink::record_end()
+{
+	bool ret = valid;
+	if (active) {
+		dbFinishEntry (&entry);
+	}
+	active = false;
+	valid = false;
+	return ret;
+}
+
+/* epics_dbstatic_sink::create_deferred
+ ************************************************************************/
+bool epics_dbstatic_sink::create_deferred()
+{
+	record_end();
+	deferred = false;
+	for (const deferred_record& rec : records) {
+		if (!record_begin (get<0>(rec), get<1>(rec))) continue;
+		for (const auto& fld : get<2>(rec)) {
+			record_field (fld.first, fld.second);
+		}
+		record_end();
+	}
+	records.clear();
+	return errors == 0;
+}
+
+/* epics_tc_db_processing::getopt
+ ************************************************************************/
+int epics_tc_db_processing::getopt (int argc, const char* const argv[], 
+	bool argp[])
+{
+	int num = EpicsTpy::epics_db_processing::getopt (argc, argv, argp);
+	for (int i = 1; i < argc; ++i) {
+		if (argp && argp[i]) continue;
+		if (!argv[i]) continue;
+		std::stringcase arg (argv[i]);
+		int oldnum = num;
+		// create records directly
+		if (arg == "-dl" || arg == "/dl") {
+			direct_load = true;
+			++num;
+		}
+		// no .db file
+		else if (arg == "-dn" || arg == "/dn") {
+			db_file = false;
+			++num;
+		}
+		// no set flag to indicated a processed option
+		if (argp && (num > oldnum)) {
+			argp[i] = true;
+		}
+	}
+	return num;
+}
+
 /* epics_tc_db_processing::init_lists
  ************************************************************************/
-void epics_tc_db_processing::init_lists()
+void epics_tc_db_processing::init_lists (const EpicsTpy::output_cache* cache)
 {
 	if (!lists) return;
-	for (filename_rule_list_tuple& list : *lists) {
+	list_caches.assign (lists->size(), cache ? *cache : output_cache());
+	for (size_t idx = 0; idx < lists->size(); ++idx) {
+		filename_rule_list_tuple& list = (*lists)[idx];
+		// skip unchanged listings
+		output_cache& lcache = list_caches[idx];
+		if (lcache.get_use_cache()) {
+			lcache.append_key (get<1>(list));
+			lcache.read (output_cache::get_manifest (get<0>(list)));
+			if (lcache.is_current()) {
+				printf ("Listing %s is unchanged.\n", get<0>(list).c_str());
+				lcache.set_use_cache (false);
+				if (std::get<2>(list)) delete std::get<2>(list);
+				std::get<2>(list) = nullptr;
+				continue;
+			}
+		}
 		optarg options (get<1>(list));
 		epics_list_processing* lproc = new (std::nothrow) epics_list_processing;
 		bool no_string = false;
@@ -261,10 +601,12 @@ bool epics_tc_db_processing::process_list (filename_rule_list_tuple& listdef,
 
 /* epics_tc_db_processing::init_macros
  ************************************************************************/
-void epics_tc_db_processing::init_macros()
+void epics_tc_db_processing::init_macros (const EpicsTpy::output_cache* cache)
 {
 	if (!macros) return;
-	for (dirname_arg_macro_tuple& macro : *macros) {
+	macro_caches.assign (macros->size(), cache ? *cache : output_cache());
+	for (size_t idx = 0; idx < macros->size(); ++idx) {
+		dirname_arg_macro_tuple& macro = (*macros)[idx];
 		optarg options (get<1>(macro));
 		epics_macrofiles_processing* mproc = 
 			new (std::nothrow) epics_macrofiles_processing (
@@ -276,6 +618,13 @@ void epics_tc_db_processing::init_macros()
 			if (get<3>(macro) && *get<3>(macro)) {
 				mproc->set_indirname (get<3>(macro));
 			}
+			// only rewrite changed macro files
+			output_cache& mcache = macro_caches[idx];
+			if (mcache.get_use_cache()) {
+				mcache.append_key (get<1>(macro));
+				mcache.read (output_cache::get_manifest (get<0>(macro), true));
+				mproc->set_output_cache (&mcache);
+			}
 		}
 		if (std::get<2>(macro)) delete std::get<2>(macro);
 		std::get<2>(macro) = mproc;
@@ -435,6 +784,46 @@ void epics_tc_db_processing::flush()
 	}
 }
 
+/* Wait for the macro files
+   epics_tc_db_processing::wait_written()
+ ************************************************************************/
+bool epics_tc_db_processing::wait_written() 
+{
+	flush();
+	if (!macros) return true;
+	bool succ = true;
+	for (dirname_arg_macro_tuple& macro : *macros) {
+		if (get<2>(macro) && !get<2>(macro)->wait_written()) {
+			printf ("Unable to write macro files to %s.\n", get<0>(macro).c_str());
+			succ = false;
+		}
+	}
+	return succ;
+}
+
+/* Write output cache manifests
+   epics_tc_db_processing::update_output_cache()
+ ************************************************************************/
+void epics_tc_db_processing::update_output_cache() 
+{
+	flush();
+	for (size_t idx = 0; lists && (idx < lists->size()) && 
+		(idx < list_caches.size()); ++idx) {
+		filename_rule_list_tuple& list = (*lists)[idx];
+		if (!get<2>(list) || !list_caches[idx].get_use_cache()) continue;
+		list_caches[idx].add_file (get<0>(list));
+		list_caches[idx].set_stats (get<2>(list)->get_processed_total());
+		list_caches[idx].write (output_cache::get_manifest (get<0>(list)));
+	}
+	for (size_t idx = 0; macros && (idx < macros->size()) && 
+		(idx < macro_caches.size()); ++idx) {
+		dirname_arg_macro_tuple& macro = (*macros)[idx];
+		if (!get<2>(macro) || !macro_caches[idx].get_use_cache()) continue;
+		macro_caches[idx].set_stats (get<2>(macro)->get_processed_total());
+		macro_caches[idx].write (output_cache::get_manifest (get<0>(macro), true));
+	}
+}
+
 /* Patch channel names in info database
    epics_tc_db_processing::patch_db_recordnames()
  ************************************************************************/
@@ -465,52 +854,62 @@ bool epics_tc_db_processing::patch_db_recordnames (std::stringcase& infodb)
 	}
 	return !err;
 }
-/// @endcond
+/** Uploads the symbols and types of a PLC and records them in a file
+	@param uploadaddr ADS address of the form 'netid:port'
+	@param filename Name of the recorded upload file
+	@param version Symbol version of the upload (return)
+	@return True if successful
+ ************************************************************************/
+static bool tc_symbol_upload (const stringcase& uploadaddr, 
+	const stringcase& filename, unsigned int& version)
+{
+	stringcase::size_type colon = uploadaddr.rfind (':');
+	ParseTpy::ads_routing_info route (uploadaddr.substr (0, colon), 
+		colon == stringcase::npos ? 851 : 
+		strtol (uploadaddr.c_str() + colon + 1, NULL, 10));
+	std::string syms;
+	std::string types;
+	if (!TcComms::ads_symbol_upload (route.get_netid(), route.get_port(), 
+			syms, types, version) ||
+		!ParseTpy::tpy_file::write_upload (filename.c_str(), route, 
+			syms.data(), syms.size(), types.data(), types.size())) {
+		printf ("Unable to upload symbols from %s.\n", uploadaddr.c_str());
+		return false;
+	}
+	printf ("Uploaded symbols from %s to %s.\n", 
+		uploadaddr.c_str(), filename.c_str());
+	return true;
+}
 
-/** Function for loading a TCat tpy file, and using it to generate 
-	internal record entries as well as the EPICs .db file
-	@brief Load TwinCAT records
-	@param args Arguments for tcLoadRecords
+/* tc_load_records::tc_load_records
  ************************************************************************/
-void tcLoadRecords (const iocshArgBuf *args) 
+tc_load_records::tc_load_records (const char* tpy, const char* opts, 
+	bool defer)
+	: tpyname (tpy ? tpy : ""), reloadopts (opts ? opts : ""), 
+	alias (tc_alias), rules (tc_replacement_rules), listings (tc_lists),
+	macros (tc_macros), infoprefix (tc_infoprefix), rate (scanrate), 
+	rate_multiple (multiple), republish_rate (republishrate), 
+	export_all (dbg), tcplc (nullptr), direct_load (false), dbsink (defer)
 {
-	// save and reset alias name, listings and macro
-	std::stringcase alias = tc_alias;
-	ParseUtil::replacement_table rules = tc_replacement_rules;
-	tc_listing_def listings = tc_lists;
-	tc_macro_def macros = tc_macros;
-	std::stringcase infoprefix = tc_infoprefix;
+	// reset alias name, listings and macro
 	tc_alias = "";
 	tc_replacement_rules.clear();
 	tc_lists.clear();
 	tc_macros.clear();
 	tc_infoprefix = "";
-
-	// Check if Ioc is running
-	if (plc::System::get().is_ioc_running()) {
-        printf ("IOC is already initialized\n");
-        return;
-    }
-
-	// open input file
-	if (!args || !args[0].sval || (strlen (args[0].sval) == 0)) {
-        printf("Specify a tpy filename\n");
-		return;
-	}
-	FILE* inpf = 0;
-	inpf = fopen (args[0].sval, "r");
-	if (!inpf) {
-		printf ("Failed to open input %s.\n", args[0].sval);
-		return;
-	}
 	for (dirname_arg_macro_tuple& macro : macros) {
-		get<3>(macro) = args[0].sval;
+		get<3>(macro) = tpyname.c_str();
 	}
-	
+}
+
+/* tc_load_records::prepare
+ ************************************************************************/
+bool tc_load_records::prepare()
+{
 	// check option arguments
 	optarg options;
-	if (args[1].sval) {
-		options.parse (args[1].sval);
+	if (!reloadopts.empty()) {
+		options.parse (reloadopts);
 	}
 
 	// Timer for just tpy file parsing
@@ -519,53 +918,127 @@ void tcLoadRecords (const iocshArgBuf *args)
 
 	tpybegin = clock();
 
-	// parse tpy file
-	ParseTpy::tpy_file tpyfile;
-	tpyfile.getopt (options.argc(), options.argv(), options.argp());
-	if (!tpyfile.parse (inpf)) {
-		printf ("Unable to parse %s.\n", args[0].sval);
-		fclose (inpf);
-		return;
-	}
-	fclose (inpf);
-
 	// generate the db filename
-	stringcase outfilename (args[0].sval);
+	outfilename = tpyname;
 	stringcase::size_type pos = outfilename.rfind (".tpy");
 	if (pos == outfilename.length() - 4) {
 		outfilename.erase (pos);
 	}
+	stringcase parsename = tpyname;
+	stringcase uploadaddr;
+	for (int i = 1; i + 1 < options.argc(); ++i) {
+		stringcase arg (options.argv()[i] ? options.argv()[i] : "");
+		if (arg == "/au" || arg == "-au") {
+			uploadaddr = options.argv()[i+1] ? options.argv()[i+1] : "";
+			options.argp()[i] = options.argp()[i+1] = true;
+		}
+	}
+	// upload symbols and types from the PLC, /au 'netid:port'
+	unsigned int symversion = 0;
+	if (!uploadaddr.empty()) {
+		parsename = outfilename + ParseTpy::adsUploadExt;
+		if (!tc_symbol_upload (uploadaddr, parsename, symversion)) {
+			return false;
+		}
+	}
 	outfilename.append (".db");
 
+	// parse tpy file, with /pp the symbols are processed while parsing
+	ParseTpy::tpy_file tpyfile;
+	tpyfile.set_use_cache (true);
+	tpyfile.getopt (options.argc(), options.argv(), options.argp());
+	ParseTpy::tpy_stream stream (tpyfile);
+	if (!stream.start (parsename.c_str()) || !stream.wait_types()) {
+		printf ("Unable to parse %s.\n", parsename.c_str());
+		return false;
+	}
+
 	// get ADS parameters
 	stringcase netid = tpyfile.get_project_info().get_netid();
 	int port = tpyfile.get_project_info().get_port();
 
 	// get plc
-	TcComms::TcPLC* tcplc = new (std::nothrow) TcComms::TcPLC(args[0].sval);
+	tcplc = new (std::nothrow) TcComms::TcPLC(parsename.c_str());
 	if (!tcplc) {
 		printf ("Failed to allocate PLC %s.\n", outfilename.c_str());
-		return;
+		return false;
 	}
 	// set plc parameters
 	tcplc->set_addr(netid, port);
-	tcplc->set_read_scanner_period (scanrate);
-	tcplc->set_write_scanner_period (scanrate);
-	tcplc->set_update_scanner_period (scanrate);
-	tcplc->set_read_scanner_multiple (multiple);
+	tcplc->set_read_scanner_period (rate);
+	tcplc->set_write_scanner_period (rate);
+	tcplc->set_update_scanner_period (rate);
+	tcplc->set_read_scanner_multiple (rate_multiple);
+	tcplc->set_republish_rate (republish_rate);
 	tcplc->set_alias (alias);
+	// uploaded symbols are reloaded when the PLC symbol version changes
+	if (!uploadaddr.empty()) {
+		tcplc->set_symbol_upload (symversion);
+	}
+	// reload the tpy file with the same options after an online change
+	std::stringcase opts (reloadopts);
+	ParseUtil::replacement_table reloadrules (rules);
+	bool reloadall = export_all;
+	tcplc->set_reload_function ([opts, reloadrules, reloadall, uploadaddr] 
+		(const std::string& tpyPath, TcComms::tc_symbol_map& symbols) {
+		unsigned int version = 0;
+		if (!uploadaddr.empty() && 
+			!tc_symbol_upload (uploadaddr, tpyPath.c_str(), version)) {
+			return false;
+		}
+		optarg options (opts);
+		ParseTpy::tpy_file tpyfile;
+		tpyfile.set_use_cache (true);
+		tpyfile.getopt (options.argc(), options.argv(), options.argp());
+		if (!tpyfile.parse_file (tpyPath.c_str())) {
+			return false;
+		}
+		if (reloadall) tpyfile.set_export_all (TRUE);
+		tc_reload_processing reloadproc (reloadrules, symbols);
+		tpyfile.process_symbols (reloadproc);
+		return true;
+	});
 	
+	// reuse outputs when the tpy file, options and rules are unchanged
+	output_cache outcache;
+	outcache.set_use_cache (true);
+	outcache.getopt (options.argc(), options.argv(), options.argp());
+	unsigned long long tpyhash = 0;
+	if (outcache.get_use_cache() && 
+		output_cache::hash_file (parsename, tpyhash)) {
+		outcache.set_key (tpyhash, reloadopts + '|' + alias + '|' + 
+			infoprefix + (export_all ? "|dbg" : ""), rules);
+	}
+	else {
+		outcache.set_use_cache (false);
+	}
+
 	// Set up output db generator
-	epics_tc_db_processing dbproc (*tcplc, rules, &listings, &macros);
+	epics_tc_db_processing dbproc (*tcplc, rules, &listings, &macros, &outcache);
 	// option processing
 	dbproc.getopt (options.argc(), options.argv(), options.argp());
+	// create records directly, the .db file is then optional
+	direct_load = dbproc.is_direct_load();
+	if (direct_load) {
+		dbproc.set_record_sink (&dbsink, dbproc.is_db_file());
+	}
+	// keep an unchanged db file
+	stringcase manifest = output_cache::get_manifest (outfilename);
+	bool db_current = dbproc.is_db_file() && outcache.read (manifest) && 
+		outcache.is_current();
+	if (db_current) {
+		printf ("Record database %s is unchanged.\n", outfilename.c_str());
+		dbproc.set_record_file (false);
+	}
 	// force single file
-	split_io_support iosupp (outfilename, false, 0);
-	if (!iosupp) {
-		printf ("Failed to open output %s.\n", outfilename.c_str());
-		return;
+	else if (dbproc.is_db_file()) {
+		split_io_support iosupp (outfilename, false, 0);
+		if (!iosupp) {
+			printf ("Failed to open output %s.\n", outfilename.c_str());
+			return false;
+		}
+		(split_io_support&)(dbproc) = iosupp;
 	}
-	(split_io_support&)(dbproc) = iosupp;
 	// setup macro processing
 	for (dirname_arg_macro_tuple& macro : macros) {
 		if (get<2>(macro)) get<2>(macro)->set_twincat3 (
@@ -573,8 +1046,12 @@ void tcLoadRecords (const iocshArgBuf *args)
 	}
 
 	// generate db file from tc records
-	if (dbg) tpyfile.set_export_all (TRUE);
-	int num = tpyfile.process_symbols (dbproc);
+	if (export_all) tpyfile.set_export_all (TRUE);
+	int num = stream.process (dbproc);
+	if (!stream.finish()) {
+		printf ("Unable to parse %s.\n", parsename.c_str());
+		return false;
+	}
 
 	// generate db file from info  records
 	if (!infoprefix.empty()) {
@@ -584,14 +1061,23 @@ void tcLoadRecords (const iocshArgBuf *args)
 	}
 
 	// make sure all file contents is written to file
-	dbproc.flush();
+	if (!dbproc.wait_written()) {
+		return false;
+	}
+	// remember the outputs for the next run
+	if (outcache.get_use_cache() && dbproc.is_db_file() && !db_current) {
+		outcache.add_file (outfilename);
+		outcache.set_stats (num);
+		outcache.write (manifest);
+	}
+	dbproc.update_output_cache();
 	// write statistics
 	if (dbproc.get_invalid_records() == 0) {
-		printf ("Loaded %i records from %s.\n", num, args[0].sval);
+		printf ("Loaded %i records from %s.\n", num, tpyname.c_str());
 	}
 	else {
 		printf ("Loaded %i valid and %i invaid records from %s.\n", 
-			num, dbproc.get_invalid_records(), args[0].sval);
+			num, dbproc.get_invalid_records(), tpyname.c_str());
 	}
 
 	// end timer
@@ -601,37 +1087,144 @@ void tcLoadRecords (const iocshArgBuf *args)
 	//Start scanner
 	if (!tcplc->optimizeRequests()) {
 		printf ("Failed to optimize request groups\n");
-		return;
+		return false;
 	}
+	return true;
+}
 
+/* tc_load_records::load
+ ************************************************************************/
+bool tc_load_records::load()
+{
+	if (!tcplc) {
+		return false;
+	}
 	if (!tcplc->start ()) {
 		printf ("Failed to start\n");
-		return;
+		return false;
 	}
 
 	plc::System::get().add(plc::BasePLCPtr(tcplc)); // adopted by TSystem
+	tcplc = nullptr;
 
 	// load epics database
-	pos = outfilename.rfind ('\\');
-	stringcase path;
-	stringcase fname;
-	if (pos == stringcase::npos) {
-		fname = outfilename;
-	}
-	else {
-		fname = outfilename.substr (pos + 1);
-		path  = outfilename.substr (0, pos);
+	if (direct_load) {
+		dbsink.create_deferred();
+		if (dbsink.get_errors()) {
+			printf ("\nUnable to create %i records or fields directly.\n", 
+				dbsink.get_errors());
+			return false;
+		}
+		printf ("Created records directly from %s.\n", tpyname.c_str());
+		return true;
 	}
-
 	printf ("Loading record database %s.\n", outfilename.c_str());
 	if (dbLoadRecords (outfilename.c_str(), 0)) {
 		printf ("\nUnable to laod record database for %s.\n", outfilename.c_str());
-		return;
+		return false;
 	}
 	printf ("Loaded record database %s.\n", outfilename.c_str());
 	// success!
+	return true;
+}
 
-	return;
+/* Wait for all tpy files loaded by tcLoadRecordsAsync 
+ ************************************************************************/
+static void wait_loaded()
+{
+	int failed = 0;
+	for (tc_load_pending& pending : tc_pending_loads) {
+		if (!pending.second.get() || !pending.first->load()) {
+			printf ("Failed to load %s.\n", pending.first->get_tpyname().c_str());
+			++failed;
+		}
+	}
+	if (!tc_pending_loads.empty()) {
+		printf ("Loaded %i of %i tpy files in the background.\n", 
+			static_cast<int>(tc_pending_loads.size()) - failed, 
+			static_cast<int>(tc_pending_loads.size()));
+	}
+	tc_pending_loads.clear();
+}
+/// @endcond
+
+/** Function for loading a TCat tpy file, and using it to generate 
+	internal record entries as well as the EPICs .db file
+	@brief Load TwinCAT records
+	@param args Arguments for tcLoadRecords
+ ************************************************************************/
+void tcLoadRecords (const iocshArgBuf *args) 
+{
+	// take over and reset alias name, listings and macro
+	tc_load_records tpyload (args ? args[0].sval : nullptr, 
+		args ? args[1].sval : nullptr);
+
+	// Check if Ioc is running
+	if (plc::System::get().is_ioc_running()) {
+        printf ("IOC is already initialized\n");
+        return;
+    }
+
+	// open input file
+	if (tpyload.get_tpyname().empty()) {
+        printf("Specify a tpy filename\n");
+		return;
+	}
+
+	if (tpyload.prepare()) {
+		tpyload.load();
+	}
+}
+
+/** Function for loading a TCat tpy file in the background. The tpy file 
+	is parsed, and the records are generated while the IOC shell continues 
+	with the next command. The EPICS database is loaded by tcWaitLoaded.
+	@brief Load TwinCAT records in the background
+	@param args Arguments for tcLoadRecordsAsync
+ ************************************************************************/
+void tcLoadRecordsAsync (const iocshArgBuf *args) 
+{
+	// take over and reset alias name, listings and macro
+	std::unique_ptr<tc_load_records> tpyload (new (std::nothrow) 
+		tc_load_records (args ? args[0].sval : nullptr, 
+		args ? args[1].sval : nullptr, true));
+	if (!tpyload) {
+		printf ("Failed to allocate tpy file load\n");
+		return;
+	}
+
+	// Check if Ioc is running
+	if (plc::System::get().is_ioc_running()) {
+        printf ("IOC is already initialized\n");
+        return;
+    }
+
+	// open input file
+	if (tpyload->get_tpyname().empty()) {
+        printf("Specify a tpy filename\n");
+		return;
+	}
+
+	printf ("Loading %s in the background.\n", tpyload->get_tpyname().c_str());
+	tc_load_records* p = tpyload.get();
+	tc_pending_loads.emplace_back (std::move (tpyload), 
+		std::async (std::launch::async, [p] () { return p->prepare(); }));
+}
+
+/** Function for waiting on all tpy files loaded by tcLoadRecordsAsync,
+	their PLCs are started and their EPICS databases are loaded in the 
+	order of the tcLoadRecordsAsync calls
+	@brief Wait for background loads
+	@param args Arguments for tcWaitLoaded
+ ************************************************************************/
+void tcWaitLoaded (const iocshArgBuf *args) 
+{
+	// Check if Ioc is running
+	if (plc::System::get().is_ioc_running()) {
+        printf ("IOC is already initialized\n");
+        return;
+    }
+	wait_loaded();
 }
 
 /** Set scan rate of the read scanner
@@ -854,12 +1447,148 @@ void tcPrintVal (const iocshArgBuf *args)
 	return;
 }
 
+/** Sets the usage limit of a callback queue above which record updates
+	of the corresponding priority are deferred
+	@brief Set callback queue limit
+	@param args Arguments for tcSetCallbackLimit
+ ************************************************************************/
+void tcSetCallbackLimit (const iocshArgBuf *args)
+{
+	// Check arguments
+	if (!args) {
+		printf("Specify a priority and a limit\n");
+		return;
+	}
+	const char* p1 = args[0].sval;
+	const char* p2 = args[1].sval;
+	if (!p1 || !p2) {
+		printf("Specify a priority and a limit in percent\n");
+		return;
+	}
+	// Convert to number
+	char* pp;
+	int pri = strtol (p1, &pp, 10);
+	if (*pp || (pri < 0) || (pri >= NUM_CALLBACK_PRIORITIES)) {
+		printf("Priority must be 0, 1 or 2: %s\n", p1);
+		return;
+	}
+	double limit = strtod (p2, &pp);
+	if (*pp) {
+		printf("Limit must be a number %s\n", p2);
+		return;
+	}
+	EpicsInterface::set_callback_queue_limit (pri, limit / 100.0);
+	printf("Callback queue limit for priority %i is %g %%\n", pri, 
+		100.0 * EpicsInterface::get_callback_queue_limit (pri));
+}
+
+/** Configures a private pool of threads for processing the tcIoc records
+	instead of the EPICS callback and scan threads
+	@brief Set processing pool
+	@param args Arguments for tcSetProcessPool
+ ************************************************************************/
+void tcSetProcessPool (const iocshArgBuf *args)
+{
+	// Check if Ioc is running
+	if (plc::System::get().is_ioc_running()) {
+		printf ("IOC is already initialized\n");
+		return;
+	}
+	// Check arguments
+	if (!args) {
+		printf("Specify the number of threads\n");
+		return;
+	}
+	const char* p1 = args[0].sval;
+	const char* p2 = args[1].sval;
+	const char* p3 = args[2].sval;
+	if (!p1) {
+		printf("Specify the number of threads\n");
+		return;
+	}
+	// Convert to number
+	char* pp;
+	int threads = strtol (p1, &pp, 10);
+	if (*pp || (threads < 0)) {
+		printf("Number of threads must be a positive integer %s\n", p1);
+		return;
+	}
+	if (threads > TcComms::maximum_process_threads) {
+		threads = TcComms::maximum_process_threads;
+		printf("Number of threads set to maximum %i\n", threads);
+	}
+	int depth = TcComms::default_process_queue;
+	if (p2 && *p2) {
+		depth = strtol (p2, &pp, 10);
+		if (*pp || (depth <= 0)) {
+			printf("Queue depth must be a positive integer %s\n", p2);
+			return;
+		}
+	}
+	bool perplc = false;
+	if (p3 && *p3) {
+		std::stringcase mode (p3);
+		if (mode == "plc") {
+			perplc = true;
+		}
+		else if (mode != "ioc") {
+			printf("Pool must be 'ioc' or 'plc': %s\n", p3);
+			return;
+		}
+	}
+	ProcessPool::configure (threads, depth, perplc);
+	if (threads == 0) {
+		printf ("Records are processed by EPICS callbacks\n");
+	}
+	else {
+		printf ("Records are processed by %i threads per %s with a queue depth of %i\n", 
+			threads, perplc ? "PLC" : "IOC", depth);
+	}
+}
+
+/** Sets the rate at which records are republished after the connection
+	to a PLC is lost or restored
+	@brief Set republication rate
+	@param args Arguments for tcSetRepublishRate
+ ************************************************************************/
+void tcSetRepublishRate (const iocshArgBuf *args)
+{
+	// Check if Ioc is running
+	if (plc::System::get().is_ioc_running()) {
+		printf ("IOC is already initialized\n");
+		return;
+	}
+	// Check arguments
+	const char* p1 = args ? args[0].sval : nullptr;
+	if (!p1) {
+		printf("Specify a rate in records per second\n");
+		return;
+	}
+	// Convert to number
+	char* pp;
+	int rate = strtol (p1, &pp, 10);
+	if (*pp || (rate <= 0)) {
+		printf("Rate must be a positive integer %s\n", p1);
+		return;
+	}
+	republishrate = rate;
+	printf ("Records are republished at %i records per second.\n", republishrate);
+}
+
 /*  Process hook
     @brief piniProcessHook
  ************************************************************************/
 static void piniProcessHook (initHookState state)
 {
     switch (state) {
+	case initHookAtIocBuild:
+		// finish background loads, when tcWaitLoaded was not called
+		if (!tc_pending_loads.empty()) {
+			printf ("Call tcWaitLoaded before iocInit.\n");
+			wait_loaded();
+		}
+		break;
+
     case initHookAtIocRun:
         break;
 
@@ -874,6 +1603,10 @@ static void piniProcessHook (initHookState state)
     case initHookAfterIocPaused:
         break;
 
+	case initHookAfterInitDatabase:
+		register_devsup::print_link_statistics();
+		break;
+
 	case initHookAfterFinishDevSup:
 		break;
 
@@ -889,6 +1622,8 @@ static void piniProcessHook (initHookState state)
 tcRegisterToIocShell::tcRegisterToIocShell () 
 {
     iocshRegister(&tcLoadRecordsFuncDef, tcLoadRecords);
+    iocshRegister(&tcLoadRecordsAsyncFuncDef, tcLoadRecordsAsync);
+    iocshRegister(&tcWaitLoadedFuncDef, tcWaitLoaded);
     iocshRegister(&tcSetScanRateFuncDef, tcSetScanRate);
     iocshRegister(&tcAliasFuncDef, tcAlias);
     iocshRegister(&tcListFuncDef, tcList);
@@ -896,6 +1631,9 @@ tcRegisterToIocShell::tcRegisterToIocShell ()
 	iocshRegister(&tcInfoPrefixFuncDef, tcInfoPrefix);
 	iocshRegister(&tcPrintValsFuncDef, tcPrintVals);
 	iocshRegister(&tcPrintValFuncDef, tcPrintVal);
+	iocshRegister(&tcSetCallbackLimitFuncDef, tcSetCallbackLimit);
+	iocshRegister(&tcSetProcessPoolFuncDef, tcSetProcessPool);
+	iocshRegister(&tcSetRepublishRateFuncDef, tcSetRepublishRate);
 	initHookRegister(piniProcessHook);
 }
 
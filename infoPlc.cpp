@@ -11,6 +11,15 @@ extern "C" {
 	int get_callback_queue_size(int pri);
 	int get_callback_queue_used(int pri);
 	int get_callback_queue_free(int pri);
+	int get_process_pool_threads(const plc::BasePLC* plc);
+	int get_process_queue_size(const plc::BasePLC* plc);
+	int get_process_queue_used(const plc::BasePLC* plc);
+	int get_process_queue_max(const plc::BasePLC* plc);
+	double get_process_latency(const plc::BasePLC* plc);
+	double get_process_latency_max(const plc::BasePLC* plc);
+	int get_update_record_num(plc::BasePLC* plc, int drop);
+	unsigned int get_update_record_max(plc::BasePLC* plc, int drop);
+	void get_update_record_name(plc::BasePLC* plc, int drop, char* name, int size);
 }
 /// @endcond
 
@@ -513,7 +522,146 @@ info_dbrecord_type (
 		property_el(OPC_PROP_UNIT, "percent")
 		})),
 	"LREAL", true, update_enum::forever,
-	&InfoInterface::info_update_callback_queue2_percent)
+	&InfoInterface::info_update_callback_queue2_percent),
+info_dbrecord_type (
+	variable_name("cb.push.num"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Number of record update requests")
+		})),
+	"UDINT", true, update_enum::forever,
+	&InfoInterface::info_update_callback_push_num),
+info_dbrecord_type (
+	variable_name("cb.coalesce.num"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Number of coalesced record updates")
+		})),
+	"UDINT", true, update_enum::forever,
+	&InfoInterface::info_update_callback_coalesce_num),
+info_dbrecord_type (
+	variable_name("cb.drop.num"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Number of deferred record updates")
+		})),
+	"UDINT", true, update_enum::forever,
+	&InfoInterface::info_update_callback_drop_num),
+info_dbrecord_type (
+	variable_name("cb.coalesce.records"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Records with coalesced updates")
+		})),
+	"DINT", true, update_enum::forever,
+	&InfoInterface::info_update_callback_coalesce_records),
+info_dbrecord_type (
+	variable_name("cb.coalesce.max"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Most coalesced updates of a record")
+		})),
+	"UDINT", true, update_enum::forever,
+	&InfoInterface::info_update_callback_coalesce_max),
+info_dbrecord_type (
+	variable_name("cb.coalesce.max.name"),
+	process_type_enum::pt_string,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Record with most coalesced updates")
+		})),
+	"STRING", true, update_enum::forever,
+	&InfoInterface::info_update_callback_coalesce_max_name),
+info_dbrecord_type (
+	variable_name("cb.drop.records"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Records with deferred updates")
+		})),
+	"DINT", true, update_enum::forever,
+	&InfoInterface::info_update_callback_drop_records),
+info_dbrecord_type (
+	variable_name("cb.drop.max"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Most deferred updates of a record")
+		})),
+	"UDINT", true, update_enum::forever,
+	&InfoInterface::info_update_callback_drop_max),
+info_dbrecord_type (
+	variable_name("cb.drop.max.name"),
+	process_type_enum::pt_string,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Record with most deferred updates")
+		})),
+	"STRING", true, update_enum::forever,
+	&InfoInterface::info_update_callback_drop_max_name),
+info_dbrecord_type (
+	variable_name("pool.threads"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Number of record processing threads")
+		})),
+	"DINT", true, update_enum::forever,
+	&InfoInterface::info_update_pool_threads),
+info_dbrecord_type (
+	variable_name("pool.queue.size"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Size of record processing queue")
+		})),
+	"DINT", true, update_enum::forever,
+	&InfoInterface::info_update_pool_queue_size),
+info_dbrecord_type (
+	variable_name("pool.queue.used"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Used entries in record processing queue")
+		})),
+	"DINT", true, update_enum::forever,
+	&InfoInterface::info_update_pool_queue_used),
+info_dbrecord_type (
+	variable_name("pool.queue.max"),
+	process_type_enum::pt_int,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Max. used entries in processing queue")
+		})),
+	"DINT", true, update_enum::forever,
+	&InfoInterface::info_update_pool_queue_max),
+info_dbrecord_type (
+	variable_name("pool.latency"),
+	process_type_enum::pt_real,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Average record processing latency"),
+		property_el(OPC_PROP_PREC, "3"),
+		property_el(OPC_PROP_UNIT, "ms")
+		})),
+	"LREAL", true, update_enum::forever,
+	&InfoInterface::info_update_pool_latency),
+info_dbrecord_type (
+	variable_name("pool.latency.max"),
+	process_type_enum::pt_real,
+	opc_list(publish, property_map({
+		property_el(OPC_PROP_RIGHTS, "1"),
+		property_el(OPC_PROP_DESC, "Maximum record processing latency"),
+		property_el(OPC_PROP_PREC, "3"),
+		property_el(OPC_PROP_UNIT, "ms")
+		})),
+	"LREAL", true, update_enum::forever,
+	&InfoInterface::info_update_pool_latency_max)
 });
 
 
@@ -1226,6 +1374,123 @@ bool InfoInterface::info_update_callback_queue2_percent()
 }
 
 
+/* InfoInterface::info_update_callback_push_num
+ ************************************************************************/
+bool InfoInterface::info_update_callback_push_num()
+{
+	const TcComms::TcPLC* tc = dynamic_cast<const TcComms::TcPLC*>(get_parent());
+	if (!tc) return false;
+	return record.PlcWrite(tc->get_push_count());
+}
+
+/* InfoInterface::info_update_callback_coalesce_num
+ ************************************************************************/
+bool InfoInterface::info_update_callback_coalesce_num()
+{
+	const TcComms::TcPLC* tc = dynamic_cast<const TcComms::TcPLC*>(get_parent());
+	if (!tc) return false;
+	return record.PlcWrite(tc->get_coalesce_count());
+}
+
+/* InfoInterface::info_update_callback_drop_num
+ ************************************************************************/
+bool InfoInterface::info_update_callback_drop_num()
+{
+	const TcComms::TcPLC* tc = dynamic_cast<const TcComms::TcPLC*>(get_parent());
+	if (!tc) return false;
+	return record.PlcWrite(tc->get_drop_count());
+}
+
+/* InfoInterface::info_update_callback_coalesce_records
+ ************************************************************************/
+bool InfoInterface::info_update_callback_coalesce_records()
+{
+	return record.PlcWrite(get_update_record_num(get_parent(), 0));
+}
+
+/* InfoInterface::info_update_callback_coalesce_max
+ ************************************************************************/
+bool InfoInterface::info_update_callback_coalesce_max()
+{
+	return record.PlcWrite(get_update_record_max(get_parent(), 0));
+}
+
+/* InfoInterface::info_update_callback_coalesce_max_name
+ ************************************************************************/
+bool InfoInterface::info_update_callback_coalesce_max_name()
+{
+	char buf[100];
+	get_update_record_name(get_parent(), 0, buf, sizeof(buf));
+	string name (buf);
+	return record.PlcWrite(name);
+}
+
+/* InfoInterface::info_update_callback_drop_records
+ ************************************************************************/
+bool InfoInterface::info_update_callback_drop_records()
+{
+	return record.PlcWrite(get_update_record_num(get_parent(), 1));
+}
+
+/* InfoInterface::info_update_callback_drop_max
+ ************************************************************************/
+bool InfoInterface::info_update_callback_drop_max()
+{
+	return record.PlcWrite(get_update_record_max(get_parent(), 1));
+}
+
+/* InfoInterface::info_update_callback_drop_max_name
+ ************************************************************************/
+bool InfoInterface::info_update_callback_drop_max_name()
+{
+	char buf[100];
+	get_update_record_name(get_parent(), 1, buf, sizeof(buf));
+	string name (buf);
+	return record.PlcWrite(name);
+}
+
+/* InfoInterface::info_update_pool_threads
+ ************************************************************************/
+bool InfoInterface::info_update_pool_threads()
+{
+	return record.PlcWrite(get_process_pool_threads(get_parent()));
+}
+
+/* InfoInterface::info_update_pool_queue_size
+ ************************************************************************/
+bool InfoInterface::info_update_pool_queue_size()
+{
+	return record.PlcWrite(get_process_queue_size(get_parent()));
+}
+
+/* InfoInterface::info_update_pool_queue_used
+ ************************************************************************/
+bool InfoInterface::info_update_pool_queue_used()
+{
+	return record.PlcWrite(get_process_queue_used(get_parent()));
+}
+
+/* InfoInterface::info_update_pool_queue_max
+ ************************************************************************/
+bool InfoInterface::info_update_pool_queue_max()
+{
+	return record.PlcWrite(get_process_queue_max(get_parent()));
+}
+
+/* InfoInterface::info_update_pool_latency
+ ************************************************************************/
+bool InfoInterface::info_update_pool_latency()
+{
+	return record.PlcWrite(get_process_latency(get_parent()));
+}
+
+/* InfoInterface::info_update_pool_latency_max
+ ************************************************************************/
+bool InfoInterface::info_update_pool_latency_max()
+{
+	return record.PlcWrite(get_process_latency_max(get_parent()));
+}
+
 /* process_arg::get
  ************************************************************************/
 std::stringcase process_arg_info::get_full() const
@@ -207,6 +207,36 @@ protected:
 	bool info_update_callback_queue2_free();
 	/// info update: Usage percentage of high priority callback queue
 	bool info_update_callback_queue2_percent();
+	/// info update: Number of record update requests
+	bool info_update_callback_push_num();
+	/// info update: Number of coalesced record updates
+	bool info_update_callback_coalesce_num();
+	/// info update: Number of deferred/dropped record updates
+	bool info_update_callback_drop_num();
+	/// info update: Number of records with coalesced updates
+	bool info_update_callback_coalesce_records();
+	/// info update: Most coalesced updates of a single record
+	bool info_update_callback_coalesce_max();
+	/// info update: Name of the record with the most coalesced updates
+	bool info_update_callback_coalesce_max_name();
+	/// info update: Number of records with deferred/dropped updates
+	bool info_update_callback_drop_records();
+	/// info update: Most deferred/dropped updates of a single record
+	bool info_update_callback_drop_max();
+	/// info update: Name of the record with the most deferred/dropped updates
+	bool info_update_callback_drop_max_name();
+	/// info update: Number of threads of the processing pool
+	bool info_update_pool_threads();
+	/// info update: Size of the processing queue
+	bool info_update_pool_queue_size();
+	/// info update: Used entries of the processing queue
+	bool info_update_pool_queue_used();
+	/// info update: Maximum used entries of the processing queue
+	bool info_update_pool_queue_max();
+	/// info update: Average processing latency
+	bool info_update_pool_latency();
+	/// info update: Maximum processing latency
+	bool info_update_pool_latency_max();
 
 	/// List of db info records
 	static const info_dbrecord_list dbinfo_list;
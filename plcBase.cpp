@@ -2,6 +2,7 @@
 #include "plcBase.h"
 #undef _CRT_SECURE_NO_WARNINGS
 #include <windows.h>
+#include <algorithm>
 
 /** @file plcBase.cpp
 	Defines methods for the internal record entry.
@@ -117,7 +118,8 @@ DataValue::~DataValue()
  ************************************************************************/
 DataValue::DataValue (const DataValue& dval)
 : mydata (nullptr), mytype (dtInvalid), mysize (0), myvalid (false), 
-	myuserdirty (false), myplcdirty (false)
+	myuserdirty (false), myplcdirty (false), mygeneration (0), 
+	myusergeneration (0)
 {
 	*this = dval;
 }
@@ -531,7 +533,11 @@ BasePLC::time_type BaseRecord::get_timestamp() const
  ************************************************************************/
 BasePLC::BasePLC()
 	: timestamp (0), read_scanner_period (1000), write_scanner_period (1000),
-	update_scanner_period (1000), scanners_active (false)
+	update_scanner_period (1000), scanners_active (false),
+	push_count (0), coalesce_count (0), drop_count (0),
+	connected (true), epoch (0), republish_epoch (0), republish_rate (10000),
+	republish_cur (0), republish_pos (0), record_array_valid (false),
+	refresh_cycle (10000), refresh_pos (0)
 {
 	records.max_load_factor (0.5);
 }
@@ -654,6 +660,89 @@ void BasePLC::plc_data_set_valid (bool valid)
 	});
 }
 
+/* BasePLC::get_record_array
+ ************************************************************************/
+BasePLC::record_array_ptr BasePLC::get_record_array()
+{
+	if (record_array_valid) {
+		return std::atomic_load (&record_array);
+	}
+	guard lock (mux);
+	if (!record_array_valid) {
+		auto arr = std::make_shared<std::vector<BaseRecordPtr>>();
+		arr->reserve (records.size());
+		for (auto& i : records) {
+			if (i.second->get_userInterface()) {
+				arr->push_back (i.second);
+			}
+		}
+		std::stable_sort (arr->begin(), arr->end(),
+			[](const BaseRecordPtr& a, const BaseRecordPtr& b) {
+				return a->get_userInterface()->get_priority() > 
+					b->get_userInterface()->get_priority(); });
+		std::atomic_store (&record_array, record_array_ptr (arr));
+		record_array_valid = true;
+	}
+	return std::atomic_load (&record_array);
+}
+
+/* BasePLC::refresh
+ ************************************************************************/
+void BasePLC::refresh (int period)
+{
+	record_array_ptr arr = get_record_array();
+	if (!arr || arr->empty()) {
+		return;
+	}
+	// visit every record once per refresh cycle
+	double ticks = (double)refresh_cycle / (double)(period > 0 ? period : 1);
+	if (ticks < 1) ticks = 1;
+	int workload = (int)((double)arr->size() / ticks + 1);
+	for (int i = 0; i < workload; ++i, ++refresh_pos) {
+		if (refresh_pos >= arr->size()) {
+			refresh_pos = 0;
+		}
+		BaseRecord* rec = (*arr)[refresh_pos].get();
+		// only push records whose last update didn't reach the user
+		if (rec->get_data().UserIsDivergent()) {
+			rec->UserSetDirty();
+		}
+	}
+}
+
+/* BasePLC::republish
+ ************************************************************************/
+void BasePLC::republish (int period)
+{
+	unsigned int ep = epoch;
+	if (republish_epoch == ep) {
+		return;
+	}
+	record_array_ptr arr = get_record_array();
+	if (!arr) {
+		return;
+	}
+	// restart at the top, if the connection state changed again
+	if ((republish_cur != ep) || (republish_pos >= arr->size())) {
+		republish_cur = ep;
+		republish_pos = 0;
+	}
+	int workload = (int)((double)republish_rate * (double)period / 1000.0);
+	if (workload < 1) workload = 1;
+	for (; (workload > 0) && (republish_pos < arr->size()); ++republish_pos) {
+		BaseRecord* rec = (*arr)[republish_pos].get();
+		if (rec->get_epoch() == ep) continue;
+		rec->set_epoch (ep);
+		rec->UserSetDirty();
+		--workload;
+	}
+	// done: all records have been published in this epoch
+	if (republish_pos >= arr->size()) {
+		republish_pos = 0;
+		republish_epoch = ep;
+	}
+}
+
 /** Structure for arguments sent to a scanner thread
     @brief Scanner thread arguments
  ************************************************************************/
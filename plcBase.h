@@ -58,6 +58,11 @@ public:
 	virtual void printVal (FILE* fp) {}
 	/// Get symbol name
 	virtual const char* get_symbol_name() const { return nullptr; }
+	/// Returns false, if the data source behind this interface is 
+	/// unavailable. Consulted by the record whenever the data is accessed.
+	virtual bool is_valid() const { return true; }
+	/// Get update priority, higher priorities are republished first
+	virtual int get_priority() const { return 0; }
 protected:
 	/// Pointer to tag/channel record associated with this interface
 	BaseRecord&			record;
@@ -228,13 +233,15 @@ public:
 
 	/// Default constructor
 	DataValue() : mydata (nullptr), mytype (dtInvalid), mysize (0), 
-		myvalid (false), myuserdirty (false), myplcdirty (false) {}
+		myvalid (false), myuserdirty (false), myplcdirty (false),
+		mygeneration (0), myusergeneration (0) {}
 	/// Constructor
 	/// @param rt Data type enumeration value
 	/// @param len Length of data
 	explicit DataValue (data_type_enum rt, size_type len = 0) 
 		: mydata (nullptr), mytype (dtInvalid), mysize (0), 
-		myvalid (false), myuserdirty (false), myplcdirty (false) { 
+		myvalid (false), myuserdirty (false), myplcdirty (false),
+		mygeneration (0), myusergeneration (0) { 
 		Init(rt, len); }
 	/// Desctructor
 	~DataValue();
@@ -258,21 +265,21 @@ public:
 	/// Read data by the user
 	/// @param data Data value reference (return)
 	template <typename T> bool UserRead (T& data) const {
-		return Read (myuserdirty, data); }
+		UserSyncGeneration(); return Read (myuserdirty, data); }
 	/// Read fixed length character array data by the user
 	/// @param data Data value reference for a fixed length character array (return)
 	template <size_type N> bool UserRead (type_string_value (& data)[N]) const {
-		return ReadBinary (myuserdirty, &data, N) > 0; }
+		UserSyncGeneration(); return ReadBinary (myuserdirty, &data, N) > 0; }
 	/// Read character array (pchar) by the user
 	/// @param data Destination buffer
 	/// @param max Maximum length
 	bool UserRead (type_string_value* data, size_type max) const {
-		return Read (myuserdirty, data, max); }
+		UserSyncGeneration(); return Read (myuserdirty, data, max); }
 	/// Read character array (pwchar) by the user
 	/// @param data Destination buffer
 	/// @param max Maximum length
 	bool UserRead (type_wstring_value* data, size_type max) const {
-		return Read (myuserdirty, data, max); }
+		UserSyncGeneration(); return Read (myuserdirty, data, max); }
 	/// Write data by the user
 	/// @param data Data value reference
 	template <typename T> bool UserWrite (const T& data) {
@@ -297,7 +304,7 @@ public:
 	/// @param p value pointer (destination buffer)
 	/// @param len Length in bytes
 	size_type UserReadBinary (type_binary p, size_type len) const {
-		return ReadBinary (myuserdirty, p, len); }
+		UserSyncGeneration(); return ReadBinary (myuserdirty, p, len); }
 	/// Write data as binary by the user
 	/// @param p value pointer (source buffer)
 	/// @param len Length in bytes
@@ -306,11 +313,19 @@ public:
 	/// New data for user
 	bool UserIsDirty() const { return myuserdirty; }
 	/// Set dirty flag for user
-	void UserSetDirty() { myuserdirty.store (true); }
+	void UserSetDirty() { myuserdirty.store (true); ++mygeneration; }
+	/// Checks if the user hasn't read the latest generation of the value
+	bool UserIsDivergent() const { 
+		return mygeneration.load() != myusergeneration.load(); }
+	/// Get the generation of the value (incremented with each update for the user)
+	unsigned int get_generation() const { return mygeneration; }
+	/// Get the generation of the value last read by the user
+	unsigned int get_user_generation() const { return myusergeneration; }
 
 	/// Set the valid flag and set the dirty flag when flag changes
 	/// @param valid True for valid data, False for invalid
-	void UserSetValid (bool valid) { SetValid (myuserdirty, valid); }
+	void UserSetValid (bool valid) { 
+		SetValid (myuserdirty, valid); UserNewGeneration (true); }
 	/// Get the valid flag and reset the dirty flag
 	/// @return valid True for valid data, False for invalid
 	bool UserGetValid() const { return GetValid (myplcdirty); }
@@ -336,21 +351,21 @@ public:
 	/// Write data by the plc
 	/// @param data Data value reference
 	template <typename T> bool PlcWrite (const T& data) {
-		return Write (myuserdirty, myplcdirty, data); }
+		return UserNewGeneration (Write (myuserdirty, myplcdirty, data)); }
 	/// Write fixed length character array data by the plc
 	/// @param data Data value reference
 	template <size_type N> bool PlcWrite (const type_string_value (& data)[N]) {
-		return WriteBinary (myuserdirty, myplcdirty, &data, N) > 0; }
+		return UserNewGeneration (WriteBinary (myuserdirty, myplcdirty, &data, N) > 0); }
 	/// Write character array (pchar) by the plc
 	/// @param data Source buffer
 	/// @param max Maximum length
 	bool PlcWrite (const type_string_value* data, size_type max) {
-		return Write (myuserdirty, myplcdirty, data, max); }
+		return UserNewGeneration (Write (myuserdirty, myplcdirty, data, max)); }
 	/// Write character array (wpchar) by the plc
 	/// @param data Source buffer
 	/// @param max Maximum length
 	bool PlcWrite (const type_wstring_value* data, size_type max) {
-		return Write (myuserdirty, myplcdirty, data, max); }
+		return UserNewGeneration (Write (myuserdirty, myplcdirty, data, max)); }
 
 	/// Read data as binary by the plc
 	/// @param p value pointer (destination buffer)
@@ -361,7 +376,8 @@ public:
 	/// @param p value pointer (source buffer)
 	/// @param len Length in bytes
 	size_type PlcWriteBinary (const type_binary p, size_type len) {
-		return WriteBinary (myuserdirty, myplcdirty, p, len); }
+		size_type ret = WriteBinary (myuserdirty, myplcdirty, p, len);
+		UserNewGeneration (ret > 0); return ret; }
 	/// New data for plc
 	bool PlcIsDirty() const {return myplcdirty; }
 	/// Set dirty flag for plc
@@ -458,6 +474,15 @@ protected:
 	/// @return valid True for valid data, False for invalid
 	bool GetValid (atomic_bool& dirty) const;
 
+	/// Starts a new generation, if the user needs an update
+	/// @param ret Return value of the write
+	/// @return ret
+	bool UserNewGeneration (bool ret) {
+		if (ret && myuserdirty.load()) ++mygeneration; return ret; }
+	/// Remembers the generation read by the user (must be before read)
+	void UserSyncGeneration() const { 
+		myusergeneration.store (mygeneration.load()); }
+
 	/// Data pointer
 	data_type				mydata;
 	/// Size of allocated memory for simple types; size of string class
@@ -471,6 +496,10 @@ protected:
 	mutable atomic_bool		myuserdirty;
 	/// Dirty flag indicating plc needs to update
 	mutable atomic_bool		myplcdirty;
+	/// Generation of the value for the user
+	std::atomic<unsigned int>	mygeneration;
+	/// Generation of the value last read by the user
+	mutable std::atomic<unsigned int>	myusergeneration;
 };
 
 /** Enum for access rights of a record
@@ -496,11 +525,13 @@ class BaseRecord : public DataValueTypeDef
 {
 public:
 	/// Default constructor
-	BaseRecord() : access (read_write), process (false), parent (nullptr) {}
+	BaseRecord() : access (read_write), process (false), parent (nullptr),
+		epoch (0) {}
 	/// Constructor
 	/// @param tag Name of tag/channel
 	explicit BaseRecord (const std::stringcase& tag)
-		: name (tag), access (read_write), process (true), parent (nullptr) {}
+		: name (tag), access (read_write), process (true), parent (nullptr),
+		epoch (0) {}
 	/// Constructor
 	/// @param recordName Name of tag/channel
 	/// @param rt Data type
@@ -509,7 +540,7 @@ public:
 	BaseRecord (const std::stringcase& recordName, 
 		data_type_enum rt, Interface* puser = nullptr, Interface* pplc = nullptr)
 		: name (recordName), access (read_write), process (true), value (rt), 
-		user (puser), plc (pplc), parent (nullptr) {}
+		user (puser), plc (pplc), parent (nullptr), epoch (0) {}
 	/// Desctructor
 	virtual ~BaseRecord() {};
 
@@ -540,6 +571,10 @@ public:
 	virtual BasePLC* get_parent() const { return parent; };
 	/// Set parent plc
 	virtual void set_parent(BasePLC* pPLC) { parent = pPLC; }
+	/// Get the validity epoch of the PLC this record was last published in
+	unsigned int get_epoch() const { return epoch; }
+	/// Set the validity epoch this record was published in
+	void set_epoch (unsigned int ep) { epoch = ep; }
 
 	/// Get a const reference to the data object
 	const DataValue& get_data() const { return value; }
@@ -547,7 +582,7 @@ public:
 	DataValue& get_data() { return value; }
 	/// Returns true, if the data is valid
 	bool DataIsValid() {
-		return process && value.IsValid(); }
+		return process && value.IsValid() && (!plc || plc->is_valid()); }
 
 	/// Execute a user read, but pull plc first
 	/// @param data Reference to data (return)
@@ -697,6 +732,8 @@ protected:
 	InterfacePtr			user;
 	/// PLC that this record belongs to
 	BasePLC*				parent;
+	/// Validity epoch of the PLC this record was last published in
+	std::atomic<unsigned int>	epoch;
 };
 
 /** This is a smart pointer to a tag/channel record 
@@ -849,6 +886,37 @@ public:
 	/// @param valid Valid flag, true for valid, false for invalid
 	virtual void plc_data_set_valid (bool valid);
 
+	/// Get number of user update requests issued by all records
+	unsigned int get_push_count() const { return push_count; }
+	/// Get number of user updates coalesced into pending requests
+	unsigned int get_coalesce_count() const { return coalesce_count; }
+	/// Get number of user updates deferred or dropped due to overload
+	unsigned int get_drop_count() const { return drop_count; }
+	/// Increase the user update request count
+	void inc_push_count() { ++push_count; }
+	/// Increase the coalesced user update count
+	void inc_coalesce_count() { ++coalesce_count; }
+	/// Increase the deferred/dropped user update count
+	void inc_drop_count() { ++drop_count; }
+
+	/// Is the connection to the PLC valid?
+	bool is_connected() const { return connected; }
+	/// Set the connection state. A change starts a new validity epoch, 
+	/// records are then republished by republish() at a limited rate.
+	/// This is O(1): records consult the connection state lazily.
+	/// @param conn true if connected, false if disconnected
+	void set_connected (bool conn) {
+		if (connected.exchange (conn) != conn) ++epoch; }
+	/// Get the validity epoch (incremented at each connection change)
+	unsigned int get_epoch() const { return epoch; }
+	/// Is a record republication in progress?
+	bool is_republishing() const { return republish_epoch != epoch; }
+	/// Get the republication rate in records per second
+	int get_republish_rate() const { return republish_rate; }
+	/// Set the republication rate in records per second
+	void set_republish_rate (int rate) { 
+		republish_rate = rate > 0 ? rate : 1; }
+
 protected:
 	/// Set name (careful! This is used for indexing in the PLCList of System)
 	void set_name (const std::stringcase& n) { name = n; }
@@ -872,7 +940,35 @@ protected:
 	int					update_scanner_period;
 	/// scanners are active
 	std::atomic<bool>	scanners_active;
-	/// read thread 
+	/// number of user update requests
+	std::atomic<unsigned int>	push_count;
+	/// number of coalesced user updates
+	std::atomic<unsigned int>	coalesce_count;
+	/// number of deferred/dropped user updates
+	std::atomic<unsigned int>	drop_count;
+	/// connection state
+	std::atomic<bool>	connected;
+	/// validity epoch
+	std::atomic<unsigned int>	epoch;
+	/// epoch of the current republication
+	std::atomic<unsigned int>	republish_epoch;
+	/// republication rate in records per second
+	int					republish_rate;
+	/// epoch of the republication in progress
+	unsigned int		republish_cur;
+	/// position of the next record to republish
+	size_t				republish_pos;
+	/// Dense array of records with a user interface sorted by priority
+	typedef std::shared_ptr<const std::vector<BaseRecordPtr>> record_array_ptr;
+	/// dense array of records, replaced as a whole when rebuilt
+	record_array_ptr	record_array;
+	/// record array is up to date, cleared when the record list changes
+	std::atomic<bool>	record_array_valid;
+	/// time in ms in which the refresher visits every record once
+	int					refresh_cycle;
+	/// position of the next record to refresh
+	size_t				refresh_pos;
+	/// read thread
 	std::thread			read_thread;
 	/// write thread 
 	std::thread			write_thread;
@@ -885,6 +981,22 @@ protected:
 	virtual void write_scanner () {};
 	/// update scanner (override for action)
 	virtual void update_scanner () {};
+
+	/// Returns the record array and builds it on first use or after the
+	/// record list changed. Call only after all records have been added 
+	/// and linked to their user interface. The returned array stays valid
+	/// while it is rebuilt by another thread.
+	record_array_ptr get_record_array();
+	/// Refreshes the next records: walks the record array by cursor and
+	/// pushes records whose latest value hasn't been read by the user.
+	/// Every record is visited once per refresh cycle.
+	/// @param period Scanner period in ms (determines the workload)
+	void refresh (int period);
+	/// Republishes the next records to the user which haven't been 
+	/// published since the last connection change; high priority records 
+	/// are republished first. Call this function from a scanner.
+	/// @param period Scanner period in ms (determines the workload)
+	void republish (int period);
 };
 
 /** This is list of BasePLC, ordered by their name.
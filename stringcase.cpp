@@ -1,4 +1,19 @@
 #include "stringcase.h"
+#include <string.h>
+#include <mutex>
+#include <deque>
+#include <vector>
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define STRINGCASE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define STRINGCASE_AVX2
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 /** @file stringcase.cpp
 	Methods for case insensitve strings.
@@ -6,6 +21,92 @@
 
 namespace std {
 
+#if defined(STRINGCASE_SSE2) || defined(STRINGCASE_AVX2)
+/* Index of the lowest set bit of a non-zero mask
+ ************************************************************************/
+static inline size_t first_bit (unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanForward (&idx, mask);
+	return idx;
+#else
+	return (size_t)__builtin_ctz (mask);
+#endif
+}
+#endif
+
+#if defined(STRINGCASE_SSE2)
+/* Lower case of 16 ASCII characters: 'A'..'Z' are moved to the bottom 
+   of the signed range, so that a single compare selects them.
+ ************************************************************************/
+static inline __m128i case_fold16 (__m128i x)
+{
+	const __m128i shift = _mm_set1_epi8 ((char)(0x80 - 'A'));
+	const __m128i limit = _mm_set1_epi8 ((char)(-128 + 26));
+	const __m128i bit = _mm_set1_epi8 (0x20);
+	__m128i upper = _mm_cmplt_epi8 (_mm_add_epi8 (x, shift), limit);
+	return _mm_or_si128 (x, _mm_and_si128 (upper, bit));
+}
+#endif
+
+#if defined(STRINGCASE_AVX2)
+/* Lower case of 32 ASCII characters
+ ************************************************************************/
+static inline __m256i case_fold32 (__m256i x)
+{
+	const __m256i shift = _mm256_set1_epi8 ((char)(0x80 - 'A'));
+	const __m256i limit = _mm256_set1_epi8 ((char)(-128 + 26));
+	const __m256i bit = _mm256_set1_epi8 (0x20);
+	__m256i upper = _mm256_cmpgt_epi8 (limit, _mm256_add_epi8 (x, shift));
+	return _mm256_or_si256 (x, _mm256_and_si256 (upper, bit));
+}
+#endif
+
+/* Difference of two characters after case folding
+ ************************************************************************/
+static inline int case_fold_diff (char c1, char c2)
+{
+	return (int)(unsigned char)case_fold (c1) - 
+		(int)(unsigned char)case_fold (c2);
+}
+
+/* Case insensitive compare of ASCII characters
+ ************************************************************************/
+int case_fold_compare (const char* s1, const char* s2, size_t n)
+{
+	size_t i = 0;
+#if defined(STRINGCASE_AVX2)
+	for (; i + 32 <= n; i += 32) {
+		__m256i a = case_fold32 (_mm256_loadu_si256 ((const __m256i*)(s1 + i)));
+		__m256i b = case_fold32 (_mm256_loadu_si256 ((const __m256i*)(s2 + i)));
+		unsigned int neq = ~(unsigned int)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (a, b));
+		if (neq) {
+			i += first_bit (neq);
+			return case_fold_diff (s1[i], s2[i]);
+		}
+	}
+#endif
+#if defined(STRINGCASE_SSE2)
+	for (; i + 16 <= n; i += 16) {
+		__m128i a = case_fold16 (_mm_loadu_si128 ((const __m128i*)(s1 + i)));
+		__m128i b = case_fold16 (_mm_loadu_si128 ((const __m128i*)(s2 + i)));
+		unsigned int neq = ~(unsigned int)_mm_movemask_epi8 (_mm_cmpeq_epi8 (a, b)) & 0xFFFF;
+		if (neq) {
+			i += first_bit (neq);
+			return case_fold_diff (s1[i], s2[i]);
+		}
+	}
+#endif
+	for (; i < n; ++i) {
+		int d = case_fold_diff (s1[i], s2[i]);
+		if (d) {
+			return d;
+		}
+	}
+	return 0;
+}
+
 /* This string comparison function is not case sensitive.
  ************************************************************************/
 //int _strncasecmp (const char *s1, const char *s2, int n) 
@@ -70,25 +171,34 @@ static const size_t FNV1_32_INIT = (size_t)1099511628211;
 #endif
 
 // Perform a 32 or 64 bit Fowler/Noll/Vo hash on a case insensitive string
-std::size_t std::hash<stringcase>::operator()(const stringcase& str) const 
+// of n characters
+static size_t stringcase_hash (const char* s, size_t n)
 {
-	const unsigned char* s = (unsigned char*)str.c_str();
+	// the FNV multiply chain is serial, folding the case without tolower
+	// and the known length is what makes it fast
+	const char* const end = s + n;
 #ifdef _WIN64
 	size_t hval = FNV1_64_INIT;
-	while (*s) {
+	while ((s < end) && *s) {
 		hval *= FNV_64_PRIME;
-		hval ^= (size_t)tolower(*s++);
+		hval ^= (size_t)(unsigned char)case_fold (*s++);
 	}
 #else 
 	size_t hval = FNV1_32_INIT;
-	while (*s) {
+	while ((s < end) && *s) {
 		hval *= FNV_32_PRIME;
-		hval ^= (size_t)tolower(*s++);
+		hval ^= (size_t)(unsigned char)case_fold (*s++);
 	}
 #endif;
 	return hval;
 }
 
+// Perform a 32 or 64 bit Fowler/Noll/Vo hash on a case insensitive string
+std::size_t std::hash<stringcase>::operator()(const stringcase& str) const 
+{
+	return stringcase_hash (str.data(), str.size());
+}
+
 // Perform a 32/64 bit Fowler/Noll/Vo hash on a case insensitive 
 // unicode string
 std::size_t std::hash<wstringcase>::operator()(const wstringcase& str) const
@@ -117,4 +227,112 @@ std::size_t std::hash<wstringcase>::operator()(const wstringcase& str) const
 	return hval;
 }
 
-}
\ No newline at end of file
+
+/** Part of the global string pool. Strings are distributed over the
+	shards by hash, so that threads rarely wait for each other.
+ ************************************************************************/
+struct stringcase_pool_shard
+{
+	/// Constructor
+	stringcase_pool_shard() : num (0), bytes (0), used (0), table (64, nullptr) {}
+
+	/// Lock
+	std::mutex							mux;
+	/// Number of strings
+	size_t								num;
+	/// Number of characters
+	size_t								bytes;
+	/// Number of used table slots
+	size_t								used;
+	/// Storage of the entries, a deque does not move them
+	std::deque<stringcase_pool_entry>	entries;
+	/// Open addressing table of the first spelling of every string
+	std::vector<stringcase_pool_entry*>	table;
+};
+
+/// Number of shards of the string pool, a power of 2
+static const size_t stringcase_pool_num = 64;
+
+/* Shards of the string pool, never freed since handles may outlive 
+   static destructors
+ ************************************************************************/
+static stringcase_pool_shard* stringcase_pool()
+{
+	static stringcase_pool_shard* shards = 
+		new stringcase_pool_shard[stringcase_pool_num];
+	return shards;
+}
+
+/* Returns the pool entry of a string and adds it when new
+ ************************************************************************/
+const stringcase_pool_entry* stringcase_intern (const char* s, size_t n)
+{
+	// the empty string is not stored in the pool
+	static const stringcase_pool_entry empty = 
+		{ stringcase(), stringcase_hash ("", 0), &empty, nullptr };
+	if (!s || !n) {
+		return &empty;
+	}
+	const size_t h = stringcase_hash (s, n);
+	stringcase_pool_shard& shard = stringcase_pool()[h & (stringcase_pool_num - 1)];
+	std::lock_guard<std::mutex> lock (shard.mux);
+	// look for the first spelling, ignoring case
+	size_t mask = shard.table.size() - 1;
+	size_t idx = (h >> 6) & mask;
+	while (shard.table[idx]) {
+		stringcase_pool_entry* e = shard.table[idx];
+		if ((e->hash == h) && (e->str.size() == n) && 
+			(case_fold_compare (e->str.data(), s, n) == 0)) {
+			// look for the exact spelling
+			for (stringcase_pool_entry* p = e; p; p = p->next) {
+				if (char_traits<char>::compare (p->str.data(), s, n) == 0) {
+					return p;
+				}
+			}
+			// add a new spelling
+			shard.entries.push_back ({ stringcase (s, n), h, e, e->next });
+			e->next = &shard.entries.back();
+			++shard.num;
+			shard.bytes += n;
+			return e->next;
+		}
+		idx = (idx + 1) & mask;
+	}
+	// add a new string
+	shard.entries.push_back ({ stringcase (s, n), h, nullptr, nullptr });
+	stringcase_pool_entry* e = &shard.entries.back();
+	e->key = e;
+	shard.table[idx] = e;
+	++shard.num;
+	++shard.used;
+	shard.bytes += n;
+	// keep the table at most half full
+	if (2 * shard.used > shard.table.size()) {
+		std::vector<stringcase_pool_entry*> old (2 * shard.table.size(), nullptr);
+		old.swap (shard.table);
+		mask = shard.table.size() - 1;
+		for (stringcase_pool_entry* p : old) {
+			if (!p) continue;
+			idx = (p->hash >> 6) & mask;
+			while (shard.table[idx]) idx = (idx + 1) & mask;
+			shard.table[idx] = p;
+		}
+	}
+	return e;
+}
+
+/* Returns the statistics of the string pool
+ ************************************************************************/
+void stringcase_pool_stats (size_t& num, size_t& bytes)
+{
+	num = 0;
+	bytes = 0;
+	stringcase_pool_shard* shards = stringcase_pool();
+	for (size_t i = 0; i < stringcase_pool_num; ++i) {
+		std::lock_guard<std::mutex> lock (shards[i].mux);
+		num += shards[i].num;
+		bytes += shards[i].bytes;
+	}
+}
+
+}
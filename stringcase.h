@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string.h>
 #include <ctype.h>
 
 /** @file stringcase.h
@@ -34,6 +35,27 @@ inline
 int wcsncasewcmp (const wchar_t *s1, const wchar_t *s2, size_t n) {
 	return _wcsnicmp (s1, s2, n); }
 
+/** Converts an ASCII upper case character to lower case.
+	Unlike tolower this does not depend on the locale.
+	@param c Character
+	@return Lower case character
+    @brief ASCII lower case
+ ************************************************************************/
+inline
+char case_fold (char c) {
+	return ((unsigned char)(c - 'A') < 26) ? (char)(c | 0x20) : c; }
+
+/** Case insensitive compare of ASCII characters.
+	Uses SSE2 or AVX2 when available, compares all n characters 
+	including embedded zeros.
+	@param s1 first string
+	@param s2 second string
+	@param n Number of characters
+	@return <0 smaller, 0 equal, >0 greater
+    @brief case insensitive compare of n characters
+ ************************************************************************/
+int case_fold_compare (const char* s1, const char* s2, size_t n);
+
 /** This traits class is not case sensitive.
     @brief case insensitive traits.
  ************************************************************************/
@@ -43,26 +65,26 @@ struct case_char_traits : public std::char_traits<char>
 	/// @param c1 First char
 	/// @param c2 Second char
 	static bool eq (const char_type& c1, const char_type& c2) {
-		return ::tolower (c1) == ::tolower (c2); 
+		return case_fold (c1) == case_fold (c2); 
 	}
 	/// Not equal character
 	/// @param c1 First char
 	/// @param c2 Second char
 	static bool ne (const char_type& c1, const char_type& c2) {
-		return !(::tolower (c1) == ::tolower (c2));
+		return case_fold (c1) != case_fold (c2);
 	}
 	/// Lower than character
 	/// @param c1 First char
 	/// @param c2 Second char
 	static bool lt (const char_type& c1, const char_type& c2) {
-		return ::tolower (c1) < ::tolower (c2);
+		return case_fold (c1) < case_fold (c2);
 	}
 	/// Compare strings
 	/// @param s1 First string
 	/// @param s2 Second string
 	/// @param n number of characters
 	static int compare (const char_type* s1, const char_type* s2, size_t n) {
-		return strncasecmp (s1, s2, n); 
+		return case_fold_compare (s1, s2, n); 
 	}
 };
 
@@ -152,4 +174,5 @@ void split_string (Container& output, const String& input,
 }
 
 #include "stringcase_hash.h"
+#include "stringcase_intern.h"
 /** @} */
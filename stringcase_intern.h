@@ -0,0 +1,112 @@
+#pragma once
+
+/** @file stringcase_intern.h
+	Global pool of interned case insensitive strings.
+ ************************************************************************/
+namespace std {
+
+/** This is an entry of the global string pool. Entries are never freed,
+	so that pointers to them stay valid for the lifetime of the program.
+	Spellings which only differ in case have separate entries which
+	share the same key.
+    @brief interned string entry
+ ************************************************************************/
+struct stringcase_pool_entry
+{
+	/// String
+	stringcase						str;
+	/// Case insensitive hash, same as std::hash<stringcase>
+	size_t							hash;
+	/// First interned spelling, equal keys mean equal strings
+	const stringcase_pool_entry*	key;
+	/// Next spelling which only differs in case
+	stringcase_pool_entry*			next;
+};
+
+/** Returns the pool entry of a string and adds it when new.
+	This function is thread safe.
+	@param s String
+	@param n Number of characters
+	@return Pool entry
+    @brief intern a string
+ ************************************************************************/
+const stringcase_pool_entry* stringcase_intern (const char* s, size_t n);
+
+/** Returns the statistics of the string pool.
+	@param num Number of interned strings
+	@param bytes Number of characters of the interned strings
+    @brief string pool statistics
+ ************************************************************************/
+void stringcase_pool_stats (size_t& num, size_t& bytes);
+
+/** This class is a handle to a string in the global string pool.
+	Copies are as cheap as a pointer, the hash is precomputed and the
+	case insensitive compare of two handles is a pointer compare.
+    @brief interned case insensitive string.
+ ************************************************************************/
+class interned_stringcase
+{
+public:
+	/// Default constructor
+	interned_stringcase() : entry (stringcase_intern (nullptr, 0)) {}
+	/// Constructor
+	/// @param s String
+	interned_stringcase (const stringcase& s)
+		: entry (stringcase_intern (s.data(), s.size())) {}
+	/// Constructor
+	/// @param s Zero terminated string
+	interned_stringcase (const char* s)
+		: entry (stringcase_intern (s, s ? strlen (s) : 0)) {}
+
+	/// Get string
+	const stringcase& str() const { return entry->str; }
+	/// Convert to string
+	operator const stringcase&() const { return entry->str; }
+	/// Get zero terminated string
+	const char* c_str() const { return entry->str.c_str(); }
+	/// Get length
+	size_t size() const { return entry->str.size(); }
+	/// Get length
+	size_t length() const { return entry->str.length(); }
+	/// Empty string
+	bool empty() const { return entry->str.empty(); }
+	/// Get precomputed case insensitive hash
+	size_t hash() const { return entry->hash; }
+	/// Get id which is equal for strings which only differ in case
+	const void* id() const { return entry->key; }
+
+	/// Equal, ignoring case
+	bool operator== (const interned_stringcase& s) const {
+		return entry->key == s.entry->key; }
+	/// Not equal, ignoring case
+	bool operator!= (const interned_stringcase& s) const {
+		return entry->key != s.entry->key; }
+	/// Equal, ignoring case
+	bool operator== (const stringcase& s) const { return entry->str == s; }
+	/// Not equal, ignoring case
+	bool operator!= (const stringcase& s) const { return entry->str != s; }
+	/// Equal, ignoring case
+	bool operator== (const char* s) const { return entry->str == s; }
+	/// Not equal, ignoring case
+	bool operator!= (const char* s) const { return entry->str != s; }
+
+protected:
+	/// Pool entry
+	const stringcase_pool_entry*	entry;
+};
+
+/** This is a function specialization for interned strings.
+	Returns the precomputed hash, same as for the string itself.
+    @brief hash for interned case insensitive string.
+ ************************************************************************/
+template<>
+struct hash<interned_stringcase>
+{
+public:
+	/// @param str string to hash
+	/// @return 32/64 bit hash
+	std::size_t operator()(const interned_stringcase& str) const {
+		return str.hash(); }
+};
+
+}
@@ -79,6 +79,64 @@ void errorPrintf(int nErr)
 		printf("Error code %i: ~~~MYSTERY ERROR!!!~~~ Go Google \"ADS return codes\"!\n",nErr);
 }
 
+/* ads_symbol_upload
+ ************************************************************************/
+bool ads_symbol_upload (const std::stringcase& netid, int port,
+	std::string& syms, std::string& types, unsigned int& version)
+{
+	AmsAddr addr;
+	ParseTpy::ads_routing_info ads (netid, port);
+	if (!ads.get (addr.netId.b[0], addr.netId.b[1], addr.netId.b[2], 
+		addr.netId.b[3], addr.netId.b[4], addr.netId.b[5])) {
+		return false;
+	}
+	addr.port = port;
+	long nPort = AdsPortOpenEx();
+	if (!nPort) {
+		return false;
+	}
+	// symbol version, read first so that a change during the upload
+	// is detected afterwards
+	unsigned char ver = 0;
+	unsigned long retsize = 0;
+	long nErr = AdsSyncReadReqEx2 (nPort, &addr, ADSIGRP_SYM_VERSION, 0,
+		sizeof (ver), &ver, &retsize);
+	version = ver;
+	// sizes of the symbol and data type tables
+	AdsSymbolUploadInfo2 info;
+	memset (&info, 0, sizeof (info));
+	if (!nErr) {
+		nErr = AdsSyncReadReqEx2 (nPort, &addr, ADSIGRP_SYM_UPLOADINFO2, 0,
+			sizeof (info), &info, &retsize);
+	}
+	// symbol table
+	if (!nErr) {
+		syms.assign (info.nSymSize, '\0');
+		retsize = 0;
+		if (!syms.empty()) {
+			nErr = AdsSyncReadReqEx2 (nPort, &addr, ADSIGRP_SYM_UPLOAD, 0,
+				info.nSymSize, &syms[0], &retsize);
+		}
+		syms.resize (retsize);
+	}
+	// data type table
+	if (!nErr) {
+		types.assign (info.nDatatypeSize, '\0');
+		retsize = 0;
+		if (!types.empty()) {
+			nErr = AdsSyncReadReqEx2 (nPort, &addr, ADSIGRP_SYM_DT_UPLOAD, 0,
+				info.nDatatypeSize, &types[0], &retsize);
+		}
+		types.resize (retsize);
+	}
+	AdsPortCloseEx (nPort);
+	if (nErr) {
+		errorPrintf (nErr);
+		return false;
+	}
+	return true;
+}
+
 /************************************************************************
   TCatInterface
  ************************************************************************/
@@ -90,7 +148,7 @@ TCatInterface::TCatInterface (BaseRecord& dval, const stringcase& name,
 							  unsigned long nBytes, const stringcase& type, 
 							  bool isStruct, bool isEnum)
 	: Interface (dval), tCatName(name), tCatType(type), 
-	tCatSymbol({ 0,0,0 }), requestNum(0), requestOffs(0)
+	tCatSymbol({ 0,0,0 }), requestNum(0), requestOffs(0), removed(false)
 {
 	tCatSymbol.indexGroup = group;
 	tCatSymbol.indexOffset = offset;
@@ -113,6 +171,14 @@ bool TCatInterface::pull()
 	return true;
 }
 
+/* TCatInterface::is_valid
+ ************************************************************************/
+bool TCatInterface::is_valid() const
+{
+	const plc::BasePLC* plc = record.get_parent();
+	return !removed && (!plc || plc->is_connected());
+}
+
 /* TCatInterface::get_parent
  ************************************************************************/
 TcPLC* TCatInterface::get_parent()
@@ -170,7 +236,7 @@ void TCatInterface::printVal (FILE* fp)
 		charPLCVar		= *(signed char*)pTCatVal;
 		fprintf(fp,"%d",charPLCVar);
 	}
-	else if (tCatType.substr(0,6) == "STRING") {
+	else if (tCatType.str().substr(0,6) == "STRING") {
 		strncpy(chararrPLCVar, (char*)pTCatVal, min (tCatSymbol.length, sizeof(chararrPLCVar)));
 		fprintf(fp,"%s",chararrPLCVar);
 	}
@@ -315,9 +381,10 @@ void tcProcWrite::tcwrite()
  /* TcPLC::TcPLC constructor
   ************************************************************************/
 TcPLC::TcPLC (std::string tpyPath)
-	: addr(), pathTpy(tpyPath), timeTpy(0), checkTpy(false), validTpy(true), nRequest(0),
-	scanRateMultiple(default_multiple), cyclesLeft(default_multiple), update_workload (0),
-	ads_state (ADSSTATE_INVALID), ads_handle (0), ads_restart (false), nReadPort(0), nWritePort(0),
+	: addr(), pathTpy(tpyPath), timeTpy(0), checkTpy(false), validTpy(true), reloading(false), 
+	symUpload(false), symVersion(0), plcSymVersion(-1), nRequest(0), addrIndexNum(0),
+	scanRateMultiple(default_multiple), cyclesLeft(default_multiple), infoCycle(0),
+	ads_state (ADSSTATE_INVALID), ads_handle (0), sym_handle (0), ads_restart (false), nReadPort(0), nWritePort(0),
 	nNotificationPort(0), read_active(false), plcId(0)
 {
 	// modification time
@@ -332,6 +399,14 @@ TcPLC::TcPLC (std::string tpyPath)
 	};
 };
 
+/* TcPLC::~TcPLC destructor
+ ************************************************************************/
+TcPLC::~TcPLC()
+{
+	if (reloadThread.joinable()) reloadThread.join();
+	remove_ads_notification();
+}
+
 /* TcPLC::set_addr
  ************************************************************************/
 bool TcPLC::set_addr(stringcase netIdStr, int port)
@@ -351,17 +426,6 @@ bool TcPLC::set_addr(stringcase netIdStr, int port)
  ************************************************************************/
 bool TcPLC::start()
 {
-	// initialize update scanner
-	double ticks = 10.0 / fabs((double)update_scanner_period) * 1000.0;
-	if (ticks < 1) ticks = 1;
-	{
-		guard lock(mux);
-		update_workload = (int)((double)records.size() / ticks + 1);
-		if (!records.empty()) {
-			update_last = records.begin()->second;
-		}
-	}
-
 	// initialize read and write scanner
 	nReadPort = openPort();
 	nWritePort = openPort();
@@ -408,7 +472,13 @@ bool TcPLC::is_valid_tpy()
 	if (validTpy && checkTpy.load()) {
 		checkTpy = false;
 		path fpath (pathTpy);
-		if (exists (fpath)) {
+		// uploaded symbols are stale when the PLC symbol version changed,
+		// keep them as long as the PLC hasn't reported its version
+		if (symUpload) {
+			int version = plcSymVersion;
+			validTpy = (version < 0) || ((unsigned int)version == symVersion);
+		}
+		else if (exists (fpath)) {
 			time_t modtime = file_time_type::clock::to_time_t (last_write_time (fpath));
 			validTpy = (modtime == timeTpy);
 		}
@@ -416,18 +486,112 @@ bool TcPLC::is_valid_tpy()
 			validTpy = false;
 		}
 		if (!validTpy) {
-			printf ("ABORT! Updated tpy file for PLC %s\nRESTART tcioc!\n", name.c_str());
+			if (reloadFunc && !reloading.load()) {
+				printf ("Updated %s for PLC %s\nReloading...\n", 
+					symUpload ? "symbols" : "tpy file", name.c_str());
+				if (reloadThread.joinable()) reloadThread.join();
+				reloading = true;
+				reloadThread = std::thread (&TcPLC::reload_tpy, this);
+			}
+			else {
+				printf ("ABORT! Updated tpy file for PLC %s\nRESTART tcioc!\n", name.c_str());
+			}
 		}
 	}
 	return validTpy;
 }
 
+/* TcPLC::reload_tpy
+ ************************************************************************/
+void TcPLC::reload_tpy()
+{
+	// Parse the new tpy file without blocking the scanners
+	path fpath (pathTpy);
+	time_t modtime = exists (fpath) ? 
+		file_time_type::clock::to_time_t (last_write_time (fpath)) : 0;
+	// the reload function uploads the symbols again
+	unsigned int version = symVersion;
+	if (symUpload && !read_symbol_version (version)) {
+		modtime = 0;
+	}
+	tc_symbol_map symbols;
+	bool succ = (modtime != 0) && reloadFunc (pathTpy, symbols);
+
+	// Swap in the new addresses and read requests between scan cycles
+	if (succ) {
+		std::lock_guard<std::mutex> lockit (sync);
+		remap_records (symbols);
+		succ = optimizeRequests();
+		if (succ) {
+			timeTpy = modtime;
+			symVersion = version;
+			validTpy = true;
+			// check again in case the file changed while reloading
+			checkTpy = true;
+		}
+	}
+	if (succ) {
+		printf ("Reloaded tpy file for PLC %s\n", name.c_str());
+	}
+	else {
+		printf ("ABORT! Failed to reload tpy file for PLC %s\nRESTART tcioc!\n", name.c_str());
+	}
+	reloading = false;
+}
+
+/* TcPLC::remap_records
+ ************************************************************************/
+void TcPLC::remap_records (const tc_symbol_map& symbols)
+{
+	guard lock (mux);
+	int moved = 0;
+	int removed = 0;
+	BaseRecordList remapped;
+	remapped.reserve (records.size());
+	for (auto& it : records) {
+		TCatInterface* tcat = dynamic_cast<TCatInterface*>(it.second->get_plcInterface());
+		if (!tcat) {
+			remapped.insert (it);
+			continue;
+		}
+		// records keep their names, which may be read by other threads
+		DataPar addr = tcat->get_tCatSymbol();
+		switch (tc_remap_symbol (symbols, tcat->get_tCatName(), 
+				tcat->get_tCatType(), addr)) {
+		case tc_remap_enum::removed:
+			// records stay alive with their EPICS records, but are invalid
+			tcat->set_removed (true);
+			++removed;
+			continue;
+		case tc_remap_enum::moved:
+			tcat->set_indexGroup (addr.indexGroup);
+			tcat->set_indexOffset (addr.indexOffset);
+			++moved;
+			break;
+		default:
+			break;
+		}
+		remapped.insert (it);
+	}
+	records.swap (remapped);
+	// rebuild the record array without the removed records
+	record_array_valid = false;
+	addrIndex.clear();
+	addrIndexNum = 0;
+	printf ("Moved %i and removed %i records of PLC %s\n", moved, removed, name.c_str());
+}
+
 /* Build TCat read request groups: TcPLC::optimizeRequests
  ************************************************************************/
 bool TcPLC::optimizeRequests()
 {
 	// TODO: THIS FUNCTION NEEDS A NEW NAME
 	if (debug) printf("Forming requests...\n");
+	// Start over, when the requests are rebuilt after a reload
+	nRequest = 0;
+	adsGroupReadRequestVector.clear();
+	adsResponseBufferVector.clear();
+	nonTcRecords.clear();
 	if (records.empty()) {
 		return true;
 	}
@@ -539,6 +703,28 @@ bool TcPLC::optimizeRequests()
 	return true;
 }
 
+/* TcPLC::find
+ ************************************************************************/
+BaseRecordPtr TcPLC::find (unsigned long group, unsigned long offset, 
+						   unsigned long length)
+{
+	guard lock (mux);
+	if (addrIndexNum != records.size()) {
+		addrIndex.clear();
+		addrIndex.reserve (records.size());
+		for (auto& it : records) {
+			TCatInterface* tcat = dynamic_cast<TCatInterface*>(it.second->get_plcInterface());
+			if (tcat) {
+				addrIndex[tcat->get_tCatSymbol()] = it.second;
+			}
+		}
+		addrIndexNum = records.size();
+	}
+	DataPar key = { group, offset, length };
+	auto i = addrIndex.find (key);
+	return (i != addrIndex.end()) ? i->second : BaseRecordPtr();
+}
+
 /* TcPLC::get_responseBuffer
 ************************************************************************/
 TcPLC::buffer_ptr TcPLC::get_responseBuffer(size_t idx)
@@ -637,6 +823,8 @@ void TcPLC::printRecord (const std::string& var)
 		Interface* iface = it.get()->get_plcInterface();
 		if (iface && std::regex_match (iface->get_symbol_name(), exp)) {
 			iface->printVal(stdout);
+			// print push statistics of the user side
+			if (it->get_userInterface()) it->get_userInterface()->printVal(stdout);
 			++num;
 		}
 	}
@@ -664,6 +852,22 @@ void __stdcall ADScallback (AmsAddr* pAddr, AdsNotificationHeader* pNotification
 	}
 }
 
+/** Callback for a change of the symbol version, e.g., by an online change.
+	The version is cached, so that the scanners never wait for the PLC.
+ ************************************************************************/
+void __stdcall ADSSymVersionCallback (AmsAddr* pAddr, 
+	AdsNotificationHeader* pNotification, unsigned long plcId)
+{
+	std::lock_guard<std::mutex> lock(TcPLC::plcVecMutex);
+	if (plcId < TcPLC::plcVec.size()) {
+		TcPLC* tCatPlcUser = TcPLC::plcVec[plcId];
+		if (pNotification && (pNotification->cbSampleSize >= 1)) {
+			tCatPlcUser->plcSymVersion = *(unsigned char*)pNotification->data;
+		}
+		tCatPlcUser->checkTpy = true;
+	}
+}
+
 /** TcPLC::set_ads_state
  ************************************************************************/
 void TcPLC::set_ads_state(ADSSTATE state)
@@ -700,6 +904,17 @@ void TcPLC::setup_ads_notification()
 	else {
 		// set_ads_state (ADSSTATE_RUN);
 	}
+	// uploaded symbols are checked when the symbol version changes
+	if (symUpload && !nErr) {
+		adsNotificationAttrib.cbLength = sizeof(char);
+		nErr = AdsSyncAddDeviceNotificationReqEx (nNotificationPort, &addr, 
+			ADSIGRP_SYM_VERSION, 0, &adsNotificationAttrib, 
+			ADSSymVersionCallback, plcId, &sym_handle);
+		if (nErr) {
+			printf ("Unable to watch the symbol version of %s\n", name.c_str());
+			errorPrintf(nErr);
+		}
+	}
 }
 
 /* TcPLC::remove_ads_notification
@@ -712,9 +927,35 @@ void TcPLC::remove_ads_notification()
 			&addr, ads_handle);
 		if (nErr && (nErr != 1813)) errorPrintf(nErr);
 	}
+	if (sym_handle) {
+		nErr = AdsSyncDelDeviceNotificationReqEx (nNotificationPort, 
+			&addr, sym_handle);
+		if (nErr && (nErr != 1813)) errorPrintf(nErr);
+	}
 	if (nNotificationPort) closePort (nNotificationPort);
 }
 
+/* TcPLC::read_symbol_version
+ ************************************************************************/
+bool TcPLC::read_symbol_version (unsigned int& version)
+{
+	// own port, since the scanners use theirs concurrently
+	long nPort = AdsPortOpenEx();
+	if (!nPort) {
+		return false;
+	}
+	unsigned char ver = 0;
+	unsigned long retsize = 0;
+	long nErr = AdsSyncReadReqEx2 (nPort, &addr, ADSIGRP_SYM_VERSION, 0,
+		sizeof (ver), &ver, &retsize);
+	AdsPortCloseEx (nPort);
+	if (nErr || (retsize != sizeof (ver))) {
+		return false;
+	}
+	version = ver;
+	return true;
+}
+
 /* TcPLC::read_scanner
  ************************************************************************/
 void TcPLC::read_scanner()
@@ -763,8 +1004,14 @@ void TcPLC::read_scanner()
 	// Reset countdown until EPICS read
 	if (readAll) cyclesLeft = scanRateMultiple;
 
+	// A connection change only starts a new validity epoch. Records 
+	// check the connection state lazily and are republished at a 
+	// limited rate to avoid flooding the EPICS callback queues.
+	set_connected (read_success);
+
 	// Update all tc records
-	for (auto recordsEntry = records.begin(); recordsEntry != records.end(); ++recordsEntry) {
+	unsigned int ep = get_epoch();
+	for (auto recordsEntry = records.begin(); read_success && (recordsEntry != records.end()); ++recordsEntry) {
 		BaseRecord* pRecord = recordsEntry->second.get();
 		if (!pRecord) continue;
 		TCatInterface* tcat = dynamic_cast<TCatInterface*>(pRecord->get_plcInterface());
@@ -772,17 +1019,20 @@ void TcPLC::read_scanner()
 		bool isReadOnly = (pRecord->get_access_rights() == read_only);
 		buffer_type* buffer = adsResponseBufferVector[tcat->get_requestNum()].get();
 		if (readAll || !isReadOnly) {
-			if (read_success) {
-				pRecord->PlcWriteBinary(buffer + tcat->get_requestOffs(), tcat->get_size());
+			// Not yet republished since reconnect: update value only
+			if (pRecord->get_epoch() != ep) {
+				pRecord->get_data().PlcWriteBinary(buffer + tcat->get_requestOffs(), tcat->get_size());
 			}
 			else {
-				pRecord->UserSetValid (false);
+				pRecord->PlcWriteBinary(buffer + tcat->get_requestOffs(), tcat->get_size());
 			}
 		}
 	}
+	republish (read_scanner_period);
 
 	// update non tc records (try using a different cycle to distribute load)
 	if (cyclesLeft == 1) {
+		++infoCycle;
 		for (auto const& it : nonTcRecords) {
 			InfoPlc::InfoInterface* iface = dynamic_cast<InfoPlc::InfoInterface*> (it.second->get_plcInterface());
 			if (iface) {
@@ -817,21 +1067,10 @@ void TcPLC::write_scanner()
 void TcPLC::update_scanner()
 {
 	static time_t last_restart = 0;
-	// Set the dirty flag on a few records to make sure they won't go 
-	// stale, i.e., EPICS and TwinCAT data values are diverging.
-	if (!update_last.get()) return;
-	BaseRecordPtr next;
-	for (int i = 0; i < update_workload; ++i) {
-		if (get_next (next, update_last) && next.get()) {
-			next->UserSetDirty();
-			update_last = next;
-		}
-		else {
-			/// what!?
-			guard lock (mux);
-			update_last = records.begin()->second;
-		}
-	}
+	// Check a few records to make sure they won't go stale, i.e., 
+	// EPICS and TwinCAT data values are diverging. Only records whose 
+	// latest value hasn't reached EPICS are pushed again.
+	refresh (update_scanner_period);
 	// restart ads callback when needed
 	if ((get_ads_state() == ADSSTATE_INVALID) ||
 		(is_read_active() && ads_restart.load())) {
@@ -2,6 +2,7 @@
 #include "stdafx.h"
 #include "TcAdsDef.h"
 #include "plcBase.h"
+#include <functional>
 
 /** @file tcComms.h
 	Header which includes classes to interface with the TCat system and 
@@ -44,6 +45,12 @@ const int default_multiple = 10;
 const int minimum_multiple = 1;	
 /// maximum multiple for PLC EPICS scan rate (200) 
 const int maximum_multiple = 200;
+/// default rate of republishing records after a connection change (10000/s)
+const int default_republish_rate = 10000;
+/// default queue depth of a record processing pool (4096)
+const int default_process_queue = 4096;
+/// maximum number of threads of a record processing pool (64)
+const int maximum_process_threads = 64;
 
 
 /** Forward declaration
@@ -64,6 +71,89 @@ struct DataPar
 	unsigned long		length;
 };
 
+/// Compares index group, index offset and length
+inline bool operator== (const DataPar& p1, const DataPar& p2) {
+	return (p1.indexGroup == p2.indexGroup) && 
+		(p1.indexOffset == p2.indexOffset) && (p1.length == p2.length); }
+
+/** Hash function for looking up records by index group, index offset
+	and length
+	@brief Hash of ADS address
+ ************************************************************************/
+struct DataPar_hash
+{
+	/// Hash function
+	size_t operator() (const DataPar& p) const {
+		return std::hash<unsigned long long>()(
+			((unsigned long long)p.indexGroup << 32) ^ 
+			((unsigned long long)p.indexOffset) ^
+			((unsigned long long)p.length << 48)); }
+};
+
+/** Address and data type of a TCat symbol found in a reloaded tpy file
+	@brief TCat symbol information
+ ************************************************************************/
+struct tc_symbol_info
+{
+	/// index group, index offset and size
+	DataPar				addr;
+	/// Data type in TCat
+	std::interned_stringcase type;
+};
+
+/// Map of TCat symbol names to their address and data type
+typedef std::unordered_map<std::stringcase, tc_symbol_info> tc_symbol_map;
+
+/** Result of looking up a TCat symbol in a reloaded tpy file
+	@brief Remap result
+ ************************************************************************/
+enum class tc_remap_enum {
+	/// Symbol has the same address
+	unchanged,
+	/// Symbol moved to a new index group or index offset
+	moved,
+	/// Symbol is gone or changed its size or data type
+	removed
+};
+
+/** Looks up a TCat symbol in the symbols of a reloaded tpy file. Only
+	the index group and index offset of a symbol can change, a symbol 
+	with a different size or data type is removed.
+	@param symbols TCat symbols of the reloaded tpy file
+	@param name Name of the TCat symbol
+	@param type Data type of the TCat symbol
+	@param addr Address of the TCat symbol, the new address on return
+	@return Unchanged, moved or removed
+ ************************************************************************/
+inline tc_remap_enum tc_remap_symbol (const tc_symbol_map& symbols,
+	const std::stringcase& name, const std::stringcase& type, DataPar& addr)
+{
+	auto sym = symbols.find (name);
+	if ((sym == symbols.end()) || (sym->second.addr.length != addr.length) ||
+		(sym->second.type != type)) {
+		return tc_remap_enum::removed;
+	}
+	if (sym->second.addr == addr) {
+		return tc_remap_enum::unchanged;
+	}
+	addr.indexGroup = sym->second.addr.indexGroup;
+	addr.indexOffset = sym->second.addr.indexOffset;
+	return tc_remap_enum::moved;
+}
+
+/** Reads the symbol and data type tables of a PLC by ADS symbol upload,
+	so that they can be loaded by ParseTpy::tpy_file::parse_upload
+	@param netid ADS net ID of the PLC
+	@param port ADS port of the PLC
+	@param syms Symbol table (return)
+	@param types Data type table (return)
+	@param version Symbol version of the PLC, read before the tables (return)
+	@return True if successful
+	@brief ADS symbol upload
+ ************************************************************************/
+bool ads_symbol_upload (const std::stringcase& netid, int port,
+	std::string& syms, std::string& types, unsigned int& version);
+
 /** This is a class for a TCat interface
 	@brief TCat interface class
  ************************************************************************/
@@ -73,7 +163,7 @@ public:
 	/// Constructor
 	explicit TCatInterface (plc::BaseRecord& dval)
 		: Interface(dval), tCatSymbol({ 0,0,0 }), requestNum (0), 
-		requestOffs (0) {};
+		requestOffs (0), removed (false) {};
 	/// Constructor
 	/// @param dval BaseRecord that this interface is part of
 	/// @param name Name of TCat symbol
@@ -99,10 +189,10 @@ public:
 	virtual const char* get_symbol_name() const { 
 		return tCatName.c_str(); }
 	/// Get TCat data type
-	const std::stringcase get_tCatType() { 
+	const std::interned_stringcase& get_tCatType() const { 
 		return tCatType; };
 	/// Set TCat data type
-	void set_tCatType(std::stringcase type) { 
+	void set_tCatType(const std::interned_stringcase& type) { 
 		tCatType = type; };
 	/// Get structure containing index group, index offset, size
 	DataPar	get_tCatSymbol() { 
@@ -141,10 +231,18 @@ public:
 	/// Set the request group number this record is in
 	void set_requestNum(int rNum) { 
 		requestNum = rNum; };
+	/// Is the symbol gone from a reloaded tpy file?
+	bool is_removed() const { 
+		return removed; };
+	/// Mark the symbol as gone from a reloaded tpy file
+	void set_removed(bool rem) { 
+		removed = rem; };
 
 	/// Prints TCat symbol value and information
 	/// @param fp File to print symbol to
 	virtual void printVal (FILE* fp);
+	/// Returns false while the PLC is disconnected or the symbol was removed
+	virtual bool is_valid() const override;
 
 	/// Does nothing
 	virtual bool push() override;
@@ -153,14 +251,16 @@ public:
 protected:
 	/// Name of TCat symbol
 	std::stringcase		tCatName;
-	/// Data type in TCat
-	std::stringcase		tCatType;
+	/// Data type in TCat, interned since many records share it
+	std::interned_stringcase tCatType;
 	/// Struct storing index group, index offset, and length of TC symbol
 	DataPar				tCatSymbol;
 	/// Which request group in the PLC
 	int					requestNum;
 	/// Offset into response buffer
 	size_t				requestOffs;
+	/// Symbol was removed by a tpy reload, set by the reload thread
+	std::atomic<bool>	removed;
 };
 
 
@@ -258,19 +358,36 @@ class TcPLC	:	public plc::BasePLC
 {
 	/// Notification callback is a friend
 	friend void __stdcall ADScallback (AmsAddr*, AdsNotificationHeader*, unsigned long);
+	/// Notification callback is a friend
+	friend void __stdcall ADSSymVersionCallback (AmsAddr*, AdsNotificationHeader*, unsigned long);
 public:
 	/// Buffer type
 	typedef char						buffer_type;
 	/// Smart pointer to buffer
 	typedef std::shared_ptr<buffer_type> buffer_ptr;
+	/// Function which parses a tpy file into a map of TCat symbols
+	typedef std::function<bool (const std::string& tpyPath, 
+		tc_symbol_map& symbols)> reload_function;
 
 	/// Constructor
 	TcPLC(std::string tpyPath);
 	/// Destructor
-	~TcPLC() { remove_ads_notification(); };
+	~TcPLC();
 
-	/// Is typ still valid? Meaning, it hasn't changed
+	/// Is typ still valid? Meaning, it hasn't changed.
+	/// A changed tpy file is reloaded in the background, if a reload 
+	/// function is set. Otherwise, all traffic is stopped.
 	bool is_valid_tpy();
+	/// Set the function which is used to reload a changed tpy file
+	void set_reload_function (const reload_function& func) {
+		reloadFunc = func; }
+	/// Is a reload of the tpy file in progress?
+	bool is_reloading() const { return reloading.load(); }
+	/// Watch the symbol version of the PLC instead of the tpy file, 
+	/// used when the symbols were loaded by ADS symbol upload
+	/// @param version Symbol version of the uploaded symbols
+	void set_symbol_upload (unsigned int version) {
+		symUpload = true; symVersion = version; }
 
 	/// Get AMS netID of TwinCAT system and port number for this PLC
 	AmsAddr	get_addr() const { return addr; };
@@ -291,6 +408,8 @@ public:
 	ADSSTATE get_ads_state() const { return ads_state.load(); }
 	/// Is read scanner active and successful
 	bool is_read_active() const { return read_active; }
+	/// Get the number of info record update cycles
+	unsigned int get_info_cycle() const { return infoCycle; }
 
 	/// Get the tpy filename
 	const std::string& get_tpyfilename() const {
@@ -326,11 +445,34 @@ public:
 	/// @param var variable name (accepts wildcards)
 	virtual void printRecord(const std::string& var);
 
+	/// Find a record by name
+	using BasePLC::find;
+	/// Find a TCat record by its ADS address. The address index is 
+	/// built on first use and rebuilt, when records are added.
+	/// @param group Index group
+	/// @param offset Index offset
+	/// @param length Size in bytes
+	/// @return Pointer to record, empty if not found
+	plc::BaseRecordPtr find (unsigned long group, unsigned long offset, 
+		unsigned long length);
+
 protected:
 	/// Makes read requests to ADS, makes PlcWrite on all data values
 	virtual void read_scanner();
 	/// Collects records to be written to TCat, makes write request
 	virtual void write_scanner();
+
+	/// Reloads a changed tpy file, runs in its own thread. When done,
+	/// the records are remapped and the read requests are rebuilt 
+	/// between two scan cycles. Until then the scanners neither read
+	/// nor write, since the old addresses may no longer be valid.
+	void reload_tpy();
+	/// Moves records to their new address, removes records which are
+	/// gone or changed their size or type. Records keep their names, 
+	/// only the address of the TCat symbol changes. Call with the sync 
+	/// mutex held.
+	/// @param symbols TCat symbols of the reloaded tpy file
+	void remap_records (const tc_symbol_map& symbols);
 	/// Makes sure we don't have stale values.
 	virtual void update_scanner();
 	
@@ -340,6 +482,11 @@ protected:
 	void setup_ads_notification();
 	/// Remove ADS status change notification
 	void remove_ads_notification();
+	/// Reads the symbol version of the PLC. This waits for the PLC, 
+	/// call it from the reload thread and never from the scanners.
+	/// @param version Symbol version (return)
+	/// @return true if successful
+	bool read_symbol_version (unsigned int& version);
 
 	/// Opens a new ADS communication port
 	long openPort();
@@ -358,7 +505,19 @@ protected:
 	/// need to check modifcation time to make sure tpy file hasn't changed
 	std::atomic<bool> checkTpy;
 	/// tpy file is valid and hasn't changed
-	bool validTpy;
+	std::atomic<bool> validTpy;
+	/// Function to reload a changed tpy file
+	reload_function reloadFunc;
+	/// Thread reloading the tpy file
+	std::thread reloadThread;
+	/// Reload in progress
+	std::atomic<bool> reloading;
+	/// Symbols were loaded by ADS symbol upload
+	bool symUpload;
+	/// Symbol version of the loaded symbols
+	std::atomic<unsigned int> symVersion;
+	/// Symbol version last reported by the PLC notification, -1 if unknown
+	std::atomic<int> plcSymVersion;
 
 	/// Number of read request groups
 	int	nRequest;
@@ -368,20 +527,24 @@ protected:
 	std::vector<buffer_ptr>	adsResponseBufferVector;
 	/// List of all records that don't interface directly with a PLC (info)
 	plc::BaseRecordList	nonTcRecords;
+	/// Index of TCat records by index group, index offset and length
+	std::unordered_map<DataPar, plc::BaseRecordPtr, DataPar_hash> addrIndex;
+	/// Number of records when the address index was built
+	size_t addrIndexNum;
 
 	/// Slowdown multiple for EPICS read
 	int	scanRateMultiple;
 	/** Cycles until EPICS read will be made
 		Counts down from scanRateMultiple, resets at 0 */
 	int cyclesLeft;
-	/// Workload for update scanner
-	int update_workload;
-	/// last updated record
-	plc::BaseRecordPtr update_last;
+	/// Number of info record update cycles
+	std::atomic<unsigned int> infoCycle;
 	/// ADS state
 	std::atomic<ADSSTATE> ads_state;
 	/// ADS handle
 	unsigned long ads_handle;
+	/// ADS handle of the symbol version notification
+	unsigned long sym_handle;
 	/// ADS restart
 	std::atomic<bool> ads_restart;
 